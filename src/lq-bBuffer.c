@@ -25,6 +25,10 @@
  * LooUQ circular buffer implementation for device streaming
  *****************************************************************************/
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE                                     // memfd_create() for mirrored buffers
+#endif
+
 #include <lq-embed.h>
 #define LOG_LEVEL LOGLEVEL_DBG
 //#define DISABLE_ASSERTS                                   // ASSERT/ASSERT_W enabled by default, can be disabled 
@@ -38,28 +42,156 @@
 
 #include <string.h>                                         // remove warnings for implicit mem* functions
 #include <stdio.h>
-#include "lq-bbuffer.h"
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+#include "lq-bBuffer.h"
 #include "lq-diagnostics.h"
 
 
 #define MAX(x, y) (((x) > (y)) ? (x) : (y))
 #define MIN(x, y) (((x) < (y)) ? (x) : (y))
 
-#define BBFFR_WRAPPED (bbffr->head < bbffr->tail)
-#define BBFFR_RIGHTEDGE ((BBFFR_WRAPPED) ? bbffr->bufferEnd : bbffr->head)
-#define BBFFR_SIZE (bbffr->bufferEnd - bbffr->buffer)
-#define BBFFR_OCCUPIED ((bbffr->head >= bbffr->tail) ? bbffr->head - bbffr->tail : BBFFR_SIZE - (bbffr->tail - bbffr->head))
-#define BBFFR_VACANT  (BBFFR_SIZE - BBFFR_OCCUPIED)
-
+/* Index publication for single-producer/single-consumer operation. C11 memory model (acquire/release) via the compiler
+ * atomic builtins, the header is shared with C++ so the control struct cannot carry _Atomic members.
+ */
+#define BBFFR_LOAD_OWN(p) __atomic_load_n(&(p), __ATOMIC_RELAXED)             // index owned by the calling side
+#define BBFFR_LOAD_ACQ(p) __atomic_load_n(&(p), __ATOMIC_ACQUIRE)             // index owned by the other side
+#define BBFFR_STORE_REL(p, v) __atomic_store_n(&(p), (v), __ATOMIC_RELEASE)   // publish own index after data copy
+#define BBFFR_STAT_ADD(s, n) __atomic_store_n(&(s), (s) + (n), __ATOMIC_RELAXED)  // counter written only by its owning side
 
-void bbffr_init(bbuffer_t *bbffr, char * rawBuffer, uint16_t bufferSz)
+/* Buffer state macros operate on a local head/tail snapshot, never re-reading the shared indexes
+ */
+#define BBFFR_SIZE (bbffr->bufferEnd - bbffr->buffer)
+#define BBFFR_WRAPPED(h, t) ((h) < (t))
+#define BBFFR_RIGHTEDGE(h, t) ((BBFFR_WRAPPED(h, t)) ? bbffr->bufferEnd : (h))
+#define BBFFR_OCCUPIED(h, t) (((h) >= (t)) ? (h) - (t) : BBFFR_SIZE - ((t) - (h)))
+#define BBFFR_VACANT(h, t) (BBFFR_SIZE - BBFFR_OCCUPIED(h, t) - 1)
+#define BBFFR_TOEDGE(p) ((bbffr->options & bbffrOption_mirrored) ? BBFFR_SIZE : bbffr->bufferEnd - (p))   // contiguous chars from position p
+#define BBFFR_LOAD_LIMIT() ((bbffr->options & bbffrOption_overwrite) ? BBFFR_LOAD_ACQ(bbffr->tail) : BBFFR_LOAD_ACQ(bbffr->rTail))  // producer fills up to here
+
+
+#pragma region Local Static Function Declarations
+static char *advancePtr(bbuffer_t *bbffr, char *ptr, bbffrSz_t advanceCnt);
+static bool matchesAt(bbuffer_t *bbffr, char *searchPtr, const char *pNeedle, bbffrSz_t needleLen);
+static char *copyIn(bbuffer_t *bbffr, char *bffrPtr, const char *src, bbffrSz_t copyCnt);
+static char *copyOut(bbuffer_t *bbffr, const char *bffrPtr, char *dest, bbffrSz_t copyCnt);
+static bool searchBounds(bbuffer_t *bbffr, char *head, char *tail, bbffrOffset_t searchOffset, bbffrSz_t searchWindowSz, bbffrSz_t needleLen, bbffrSz_t *searchStart, bbffrSz_t *searchEnd);
+static bbffrSz_t foundAt(bbuffer_t *bbffr, char *tail, bbffrSz_t offset, bool setTail);
+static bbffrSz_t horspoolScan(bbuffer_t *bbffr, char *tail, const bbffrNeedle_t *compiled, bbffrSz_t searchStart, bbffrSz_t searchEnd);
+static void mpscPublish(bbffrMpsc_t *mpsc);
+static uint8_t recordHeaderEncode(bbffrSz_t recordSz, char *header);
+static bbffrSz_t recordAtTail(bbuffer_t *bbffr, char **payloadPtr);
+static bbffrSz_t recordHeaderDecode(bbuffer_t *bbffr, char **recordPtr);
+static char *overwriteVacate(bbuffer_t *bbffr, char *head, bbffrSz_t needSz);
+static bbffrSz_t overwriteRead(bbuffer_t *bbffr, char *dest, bbffrSz_t requestSz, bool record, bool consume);
+static void publishHead(bbuffer_t *bbffr, char *head);
+static void publishTail(bbuffer_t *bbffr, char *tail);
+static void releaseTail(bbuffer_t *bbffr, char *tail);
+static void countDropped(bbuffer_t *bbffr, uint32_t droppedCnt);
+static bbffrSz_t delimScan(const char *segment, bbffrSz_t segmentLen, const char *delimSet, size_t delimCnt);
+static bbffrSz_t alignBlock(bbuffer_t *bbffr, char *blockStart, bbffrSz_t blockSz, bool partialOk);
+static void reverseChars(char *start, char *end);
+#pragma endregion
+
+
+void bbffr_init(bbuffer_t *bbffr, char * rawBuffer, bbffrSz_t bufferSz)
 {
     bbffr->buffer = rawBuffer;
     bbffr->bufferEnd = rawBuffer + bufferSz;
     bbffr->head = rawBuffer;
     bbffr->tail = rawBuffer;
-    bbffr->rbHead = NULL;
+    bbffr->pHead = NULL;
     bbffr->pTail = NULL;
+    bbffr->rTail = rawBuffer;
+    bbffr->checkpointCnt = 0;
+    bbffr->recordsIn = 0;
+    bbffr->recordsOut = 0;
+    bbffr->recordsDiscarded = 0;
+    bbffr->pRecordRemain = 0;
+    bbffr->pRecord = false;
+    memset(&bbffr->stats, 0, sizeof(bbffrStats_t));
+    bbffr->watermarkCB = NULL;
+    bbffr->highMark = 0;
+    bbffr->lowMark = 0;
+    bbffr->highCnt = 0;
+    bbffr->lowCnt = 0;
+    bbffr->overwriteSeq = 0;
+    bbffr->overwriteSeqSeen = 0;
+    bbffr->overrun = false;
+    bbffr->alignSz = 0;
+    bbffr->options = bbffrOption_none;
+}
+
+
+#if defined(__linux__)
+
+bool bbffr_initMirrored(bbuffer_t *bbffr, bbffrSz_t bufferSz)
+{
+    if (bufferSz == 0 || bufferSz % sysconf(_SC_PAGESIZE) != 0)
+        return false;
+
+    int fd = memfd_create("bbffr", 0);
+    if (fd < 0)
+        return false;
+    if (ftruncate(fd, bufferSz) != 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    char *base = mmap(NULL, 2 * bufferSz, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);      // reserve address range for both views
+    if (base != MAP_FAILED)
+    {
+        if (mmap(base, bufferSz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED ||
+            mmap(base + bufferSz, bufferSz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)
+        {
+            munmap(base, 2 * bufferSz);
+            base = MAP_FAILED;
+        }
+    }
+    close(fd);                                                              // mappings hold the memory object
+    if (base == MAP_FAILED)
+        return false;
+
+    bbffr_init(bbffr, base, bufferSz);
+    bbffr->options = bbffrOption_mirrored;
+    return true;
+}
+
+
+void bbffr_releaseMirrored(bbuffer_t *bbffr)
+{
+    if (bbffr->options & bbffrOption_mirrored)
+    {
+        munmap(bbffr->buffer, 2 * BBFFR_SIZE);
+        bbffr->buffer = NULL;
+        bbffr->bufferEnd = NULL;
+        bbffr->options = bbffrOption_none;
+    }
+}
+
+#endif  // __linux__
+
+
+void bbffr_initOverwrite(bbuffer_t *bbffr, char *rawBuffer, bbffrSz_t bufferSz, bool recordBoundary)
+{
+    bbffr_init(bbffr, rawBuffer, bufferSz);
+    bbffr->options = bbffrOption_overwrite | (recordBoundary ? bbffrOption_overwriteRecords : 0);
+}
+
+
+void bbffr_initAligned(bbuffer_t *bbffr, char *rawBuffer, bbffrSz_t bufferSz, bbffrSz_t alignSz)
+{
+    ASSERT(alignSz > 0 && (alignSz & (alignSz - 1)) == 0);
+    ASSERT(((uintptr_t)rawBuffer & (alignSz - 1)) == 0 && (bufferSz & (alignSz - 1)) == 0);
+
+    bbffr_init(bbffr, rawBuffer, bufferSz);
+    bbffr->alignSz = alignSz;
+    bbffr->options = bbffrOption_aligned;
 }
 
 
@@ -67,8 +199,21 @@ void bbffr_reset(bbuffer_t *bbffr)
 {
     bbffr->head = bbffr->buffer;
     bbffr->tail = bbffr->buffer;
-    bbffr->rbHead = NULL;
+    bbffr->pHead = NULL;
     bbffr->pTail = NULL;
+    bbffr->rTail = bbffr->buffer;
+    bbffr->checkpointCnt = 0;
+    bbffr->recordsIn = 0;
+    bbffr->recordsOut = 0;
+    bbffr->recordsDiscarded = 0;
+    bbffr->pRecordRemain = 0;
+    bbffr->pRecord = false;
+    memset(&bbffr->stats, 0, sizeof(bbffrStats_t));
+    bbffr->highCnt = 0;
+    bbffr->lowCnt = 0;
+    bbffr->overwriteSeq = 0;
+    bbffr->overwriteSeqSeen = 0;
+    bbffr->overrun = false;
     // temporary, not technically required just makes diag a little easier
     memset((void*)bbffr->buffer, 0, BBFFR_SIZE);
 }
@@ -78,18 +223,61 @@ void bbffr_reset(bbuffer_t *bbffr)
  */
 void bbffr_GETMACROS(bbuffer_t *bbffr, char *macrosRpt, uint8_t macrosRptSz)
 {
-    /*
-        #define BBFFR_WRAPPED (bbffr->head < bbffr->tail)
-        #define BBFFR_RIGHTEDGE ((BBFFR_WRAPPED) ? bbffr->bufferEnd : bbffr->head)
-        #define BBFFR_SIZE (bbffr->bufferEnd - bbffr->buffer)
+    char *tail = BBFFR_LOAD_ACQ(bbffr->tail);
+    char *head = BBFFR_LOAD_ACQ(bbffr->head);
+
+    bbffrStats_t stats;
+    bbffr_getStats(bbffr, &stats);
+
+    snprintf(macrosRpt, macrosRptSz, "BBFFR MACROS: size=%d, isWrap=%d, right=%p, occpd=%d, vacnt=%d, peak=%d, in=%lu, out=%lu, trunc=%lu, drop=%lu, ovrwr=%lu\r\r", 
+             (int)BBFFR_SIZE, BBFFR_WRAPPED(head, tail), BBFFR_RIGHTEDGE(head, tail), (int)BBFFR_OCCUPIED(head, tail), (int)BBFFR_VACANT(head, tail),
+             (int)stats.peakOccupied, (unsigned long)stats.bytesIn, (unsigned long)stats.bytesOut, (unsigned long)stats.truncatedPushes, (unsigned long)stats.droppedBytes,
+             (unsigned long)stats.overwrittenBytes);
+}
+
+
+/**
+ * @brief Set flow-control watermarks, callback fires on crossings with hysteresis.
+ */
+void bbffr_setWatermarks(bbuffer_t *bbffr, bbffrSz_t highMark, bbffrSz_t lowMark, bbffrWatermark_func watermarkCB)
+{
+    ASSERT(watermarkCB == NULL || lowMark < highMark);
+
+    bbffr->watermarkCB = NULL;                                              // disarm while marks change
+    bbffr->highMark = highMark;
+    bbffr->lowMark = lowMark;
+    bbffr->lowCnt = bbffr->highCnt;                                         // start below high
+    bbffr->watermarkCB = watermarkCB;
+}
+
+
+/**
+ * @brief Get a snapshot of the buffer's instrumentation counters.
+ */
+void bbffr_getStats(bbuffer_t *bbffr, bbffrStats_t *stats)
+{
+    stats->bytesIn = __atomic_load_n(&bbffr->stats.bytesIn, __ATOMIC_RELAXED);
+    stats->bytesOut = __atomic_load_n(&bbffr->stats.bytesOut, __ATOMIC_RELAXED);
+    stats->truncatedPushes = __atomic_load_n(&bbffr->stats.truncatedPushes, __ATOMIC_RELAXED);
+    stats->droppedBytes = __atomic_load_n(&bbffr->stats.droppedBytes, __ATOMIC_RELAXED);
+    stats->overruns = __atomic_load_n(&bbffr->stats.overruns, __ATOMIC_RELAXED);
+    stats->overwrittenBytes = __atomic_load_n(&bbffr->stats.overwrittenBytes, __ATOMIC_RELAXED);
+    stats->peakOccupied = __atomic_load_n(&bbffr->stats.peakOccupied, __ATOMIC_RELAXED);
+    stats->occupied = bbffr_getOccupied(bbffr);
+}
 
-        // effective "tail" not to be overritten by head increments. It is the tail or (rollback) pTail 
-        #define BBFFR_VTAIL ((bbffr->bTail == NULL) ? bbffr->tail : bbffr->bTail)
 
-        #define BBFFR_OCCUPIED ((bbffr->head >= BBFFR_VTAIL) ? bbffr->head - BBFFR_VTAIL : BBFFR_SIZE - (BBFFR_VTAIL - bbffr->head)) 
-        #define BBFFR_VACANT  ((bbffr->head >= BBFFR_VTAIL) ? BBFFR_SIZE - (bbffr->head - BBFFR_VTAIL) - 1 : BBFFR_VTAIL - bbffr->head - 1) 
-    */
-    snprintf(macrosRpt, macrosRptSz, "CBFFR MACROS: size=%d, isWrap=%d, right=%p, occpd=%d, vacnt=%d\r\r", BBFFR_SIZE, BBFFR_WRAPPED, BBFFR_RIGHTEDGE, BBFFR_OCCUPIED, BBFFR_VACANT);
+/**
+ * @brief Consumer: check if reads since the last check skipped chars discarded by an overwrite mode producer.
+ */
+bool bbffr_checkOverrun(bbuffer_t *bbffr)
+{
+    if (!(bbffr->options & bbffrOption_overwrite))
+        return false;
+
+    bool overrun = bbffr->overrun;                                          // set by reads, discards are detected by the following read
+    bbffr->overrun = false;
+    return overrun;
 }
 
 
@@ -98,7 +286,7 @@ void bbffr_GETMACROS(bbuffer_t *bbffr, char *macrosRpt, uint8_t macrosRptSz)
  * @param [in] bbffr pointer to buffer to report on.
  * @return Buffer capacity in bytes (uint8_t type).
  */
-uint16_t bbffr_getCapacity(bbuffer_t *bbffr)
+bbffrSz_t bbffr_getCapacity(bbuffer_t *bbffr)
 {
     return BBFFR_SIZE - 1;
 }
@@ -107,51 +295,44 @@ uint16_t bbffr_getCapacity(bbuffer_t *bbffr)
 /**
  * @brief Get count of characters occupying the buffer.
  */
-uint16_t bbffr_getOccupied(bbuffer_t *bbffr)
+bbffrSz_t bbffr_getOccupied(bbuffer_t *bbffr)
 {
-    return BBFFR_OCCUPIED;
+    char *tail = BBFFR_LOAD_ACQ(bbffr->tail);
+    char *head = BBFFR_LOAD_ACQ(bbffr->head);
+    return BBFFR_OCCUPIED(head, tail);
 }
 
 
 /**
  * @brief Get count of available space in the buffer.
  */
-uint16_t bbffr_getVacant(bbuffer_t *bbffr)
+bbffrSz_t bbffr_getVacant(bbuffer_t *bbffr)
 {
-    return BBFFR_VACANT;
+    char *head = BBFFR_LOAD_ACQ(bbffr->head);
+    char *tail = BBFFR_LOAD_LIMIT();
+    return BBFFR_VACANT(head, tail);
 }
 
 
 /* Basic push/pop/find/grab
  ----------------------------------------------------------------------------------------------- */
 
-uint16_t bbffr_push(bbuffer_t *bbffr, const char *src, uint16_t srcSz)
+bbffrSz_t bbffr_push(bbuffer_t *bbffr, const char *src, bbffrSz_t srcSz)
 {
-    ASSERT(bbffr->buffer <= bbffr->head && bbffr->head < bbffr->bufferEnd);
-    ASSERT(bbffr->buffer <= bbffr->tail && bbffr->tail < bbffr->bufferEnd);
+    ASSERT(bbffr->pHead == NULL);                                           // pending pushBlock() owns head
 
-    uint16_t pushCnt;
-    if (BBFFR_WRAPPED)                                                      // WRAPPED: space avail = tail-head-1
-    {
-        pushCnt = MIN(srcSz, bbffr->tail - bbffr->head - 1);
-        memcpy(bbffr->head, src, pushCnt);
-        bbffr->head += pushCnt;
-    }
-    else                                                                    // LINEAR: space avail = (bffrEnd-head) + (tail-bffr-1)
-    {
-        pushCnt = MIN(srcSz, bbffr->bufferEnd - bbffr->head - 1);
-        memcpy(bbffr->head, src, pushCnt);                                      // 1st copy: right-side of buffer
-        bbffr->head += pushCnt;
+    char *head = BBFFR_LOAD_OWN(bbffr->head);
+    char *tail = (bbffr->options & bbffrOption_overwrite) ? overwriteVacate(bbffr, head, MIN(srcSz, BBFFR_SIZE - 1)) : 
+                                                            BBFFR_LOAD_ACQ(bbffr->rTail);   // consumer index: read once
+    ASSERT(bbffr->buffer <= head && head < bbffr->bufferEnd);
+    ASSERT(bbffr->buffer <= tail && tail < bbffr->bufferEnd);
 
-        if (pushCnt < srcSz)
-        {                                                                       // have not pushed all of srcSz
-            uint16_t leftCnt = MIN(srcSz - pushCnt, bbffr->tail - bbffr->head - 1);
-            memcpy(bbffr->buffer, src, leftCnt);
-            bbffr->head = bbffr->buffer + leftCnt;
-            pushCnt += leftCnt;
-        }
-    }
-    ASSERT(bbffr->buffer <= bbffr->head && bbffr->head < bbffr->bufferEnd);
+    bbffrSz_t pushCnt = MIN(srcSz, BBFFR_VACANT(head, tail));
+    head = copyIn(bbffr, head, src, pushCnt);
+
+    publishHead(bbffr, head);                                               // publish only after copy is complete
+    if (pushCnt < srcSz)
+        countDropped(bbffr, srcSz - pushCnt);
     return pushCnt;
 }
 
@@ -159,31 +340,25 @@ uint16_t bbffr_push(bbuffer_t *bbffr, const char *src, uint16_t srcSz)
 /**
  * @brief Get address/length of contiguous block of chars from head (incoming). Distance to tail or buffer-wrap.
  */
-uint16_t bbffr_pushBlock(bbuffer_t *bbffr, char **copyTo, uint16_t requestSz)
+bbffrSz_t bbffr_pushBlock(bbuffer_t *bbffr, char **copyTo, bbffrSz_t requestSz)
 {
-    ASSERT(bbffr->rbHead == 0);
-    ASSERT(bbffr->buffer <= bbffr->head && bbffr->head < bbffr->bufferEnd);
-    ASSERT(bbffr->buffer <= bbffr->tail && bbffr->tail < bbffr->bufferEnd);
+    ASSERT(bbffr->pHead == NULL);                                           // pending pushBlock already, no nesting pushBlock()
 
-    *copyTo = bbffr->head;
-    bbffr->rbHead = bbffr->head;                                             // save current for possible rollback
+    char *head = BBFFR_LOAD_OWN(bbffr->head);
+    char *tail;
+    if (bbffr->options & bbffrOption_overwrite)                             // discard only what the contiguous grant needs
+        tail = overwriteVacate(bbffr, head, alignBlock(bbffr, head, MIN(requestSz, MIN(BBFFR_TOEDGE(head), BBFFR_SIZE - 1)), false));
+    else
+        tail = BBFFR_LOAD_ACQ(bbffr->rTail);
+    ASSERT(bbffr->buffer <= head && head < bbffr->bufferEnd);
+    ASSERT(bbffr->buffer <= tail && tail < bbffr->bufferEnd);
 
-    uint16_t pushCnt;
-    if (BBFFR_WRAPPED)                                                      // WRAPPED
-    {
-        pushCnt =  MIN(requestSz, (bbffr->tail - bbffr->head) - 1);
-        bbffr->head += pushCnt;
-    }
-    else                                                                    // LINEAR
-    {
-        pushCnt = MIN(requestSz, bbffr->bufferEnd - bbffr->head);
-        bbffr->head +=  pushCnt;
-        if (bbffr->head == bbffr->bufferEnd)
-        {
-            bbffr->head = bbffr->buffer;
-        }
-    }
-    ASSERT(bbffr->buffer <= bbffr->head && bbffr->head < bbffr->bufferEnd);
+    bbffrSz_t vacant = BBFFR_VACANT(head, tail);
+    bbffrSz_t pushCnt = alignBlock(bbffr, head, MIN(requestSz, MIN(vacant, BBFFR_TOEDGE(head))), false);
+
+    *copyTo = head;
+    if (pushCnt > 0)
+        bbffr->pHead = advancePtr(bbffr, head, pushCnt);                    // head moves (visible to consumer) on commit
     return pushCnt;
 }
 
@@ -193,84 +368,209 @@ uint16_t bbffr_pushBlock(bbuffer_t *bbffr, char **copyTo, uint16_t requestSz)
  */
 void bbffr_pushBlockFinalize(bbuffer_t *bbffr, bool commit)
 {
-    if (!commit && bbffr->rbHead != NULL)
-        bbffr->head = bbffr->rbHead;
-    bbffr->rbHead = NULL;
+    if (bbffr->pRecord && bbffr->pRecordRemain > 0)
+        commit = false;                                                     // incomplete record is never published
+
+    if (commit && bbffr->pHead != NULL)
+    {
+        publishHead(bbffr, bbffr->pHead);
+        if (bbffr->pRecord)
+            BBFFR_STORE_REL(bbffr->recordsIn, bbffr->recordsIn + 1);        // after head, a counted record is always complete
+    }
+    bbffr->pHead = NULL;
+    bbffr->pRecord = false;
 }
 
 
+/* Multi-producer reservations
+ ----------------------------------------------------------------------------------------------- */
+
+enum
+{
+    mpscMark__committed = 1,
+    mpscMark__void = 2
+};
+
+#define MPSC_OFFSETBITS (8 * sizeof(bbffrSz_t))
+#define MPSC_STATE(seq, offset) (((bbffrMpscState_t)(uint16_t)(seq) << MPSC_OFFSETBITS) | (bbffrSz_t)(offset))
+
+
 /**
- * @brief Pop a number of uint8_ts from buffer at buffer-tail. Number of characters "popped" will be the lesser of available and requestSz.
+ * @brief Attach multi-producer control to a buffer.
  */
-uint16_t bbffr_pop(bbuffer_t *bbffr, char *dest, uint16_t requestSz)
+void bbffr_mpscInit(bbffrMpsc_t *mpsc, bbuffer_t *bbffr)
 {
-    ASSERT(bbffr->buffer <= bbffr->head && bbffr->head < bbffr->bufferEnd);
-    ASSERT(bbffr->buffer <= bbffr->tail && bbffr->tail < bbffr->bufferEnd);
+    ASSERT(!(bbffr->options & bbffrOption_overwrite));                      // reservations are not overrun safe
 
-    uint16_t popCnt;
-    if (BBFFR_WRAPPED)                                                      // WRAPPED
-    {
-        uint16_t popCnt = MIN(requestSz, bbffr->bufferEnd - bbffr->tail);       // get right-side of buffer
-        memcpy(dest, bbffr->tail, popCnt);
+    memset(mpsc, 0, sizeof(bbffrMpsc_t));
+    mpsc->bbffr = bbffr;
+    __atomic_store_n(&mpsc->reserveState, MPSC_STATE(0, bbffr->head - bbffr->buffer), __ATOMIC_RELEASE);
+}
 
-        bbffr->tail += popCnt;
-        if (bbffr->tail == bbffr->bufferEnd)                                    // edge case: pop exhausted right-side, move tail to buffer start
-        {
-            bbffr->tail = bbffr->buffer;
-        }
 
-        if (popCnt < requestSz)                                                 // not complete, now get left-side of buffer
+/**
+ * @brief Reserve a contiguous region at the reservation head for a producer to fill.
+ */
+bbffrSz_t bbffr_mpscReserve(bbffrMpsc_t *mpsc, bbffrReservation_t *resv, bbffrSz_t requestSz)
+{
+    bbuffer_t *bbffr = mpsc->bbffr;
+    bbffrMpscState_t state = __atomic_load_n(&mpsc->reserveState, __ATOMIC_ACQUIRE);
+    bbffrMpscState_t newState;
+    uint16_t seq;
+    bbffrSz_t grant;
+    bbffrSz_t skipped;
+    char *reserveAt;
+
+    do
+    {
+        seq = state >> MPSC_OFFSETBITS;
+        reserveAt = bbffr->buffer + (bbffrSz_t)state;
+        uint16_t inFlight = seq - __atomic_load_n(&mpsc->publishSeq, __ATOMIC_ACQUIRE);
+        if (inFlight >= BBFFR_MPSC_SLOTS)
+            return 0;                                                       // all slots in flight
+
+        char *tail = BBFFR_LOAD_ACQ(bbffr->rTail);
+        bbffrSz_t vacant = BBFFR_VACANT(reserveAt, tail);
+        bbffrSz_t toEdge = BBFFR_TOEDGE(reserveAt);
+        grant = MIN(requestSz, MIN(vacant, toEdge));
+        skipped = 0;
+        if (requestSz > toEdge && vacant > toEdge && MIN(requestSz, vacant - toEdge) > grant && inFlight + 1 < BBFFR_MPSC_SLOTS)
         {
-            uint16_t leftCnt = MIN((requestSz - popCnt), (bbffr->head - bbffr->buffer));
-            memcpy(dest + popCnt, bbffr->buffer, leftCnt);
-            popCnt += leftCnt;
-            bbffr->tail = bbffr->buffer + leftCnt;
+            skipped = toEdge;                                               // skip the wrap, grant from buffer start
+            grant = MIN(requestSz, vacant - toEdge);
         }
-    }
-    else                                                                    // LINEAR
+        if (grant == 0)
+            return 0;
+        newState = MPSC_STATE(seq + (skipped ? 2 : 1), advancePtr(bbffr, reserveAt, skipped + grant) - bbffr->buffer);
+    } while (!__atomic_compare_exchange_n(&mpsc->reserveState, &state, newState, true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+    if (skipped)
     {
-        popCnt = MIN(requestSz, BBFFR_OCCUPIED);
-        memcpy(dest, bbffr->tail, popCnt);
-        bbffr->tail += popCnt;
+        mpsc->slots[seq % BBFFR_MPSC_SLOTS].len = skipped;
+        __atomic_store_n(&mpsc->slots[seq % BBFFR_MPSC_SLOTS].mark, ((uint32_t)seq << 2) | mpscMark__void, __ATOMIC_SEQ_CST);
+        reserveAt = bbffr->buffer;
+        seq++;
     }
-    ASSERT(bbffr->buffer <= bbffr->tail && bbffr->tail < bbffr->bufferEnd);
-    return popCnt;
+    mpsc->slots[seq % BBFFR_MPSC_SLOTS].len = grant;                        // slot is owned until finalize marks it
+    resv->ptr = reserveAt;
+    resv->len = grant;
+    resv->seq = seq;
+    return grant;
 }
 
 
 /**
- * @brief Allocate a POP of chars from buffer at buffer-tail. Number of chars accounted for will be the lesser of available and requestSz.
+ * @brief Commit or rollback a reservation; reservations may be finalized in any order.
  */
-uint16_t bbffr_popBlock(bbuffer_t *bbffr, char **copyFrom, uint16_t requestSz)
+bool bbffr_mpscFinalize(bbffrMpsc_t *mpsc, bbffrReservation_t *resv, bool commit)
 {
-    ASSERT(bbffr->pTail == 0);                                                  // pending popBlock already, no nesting popBlock()
-    ASSERT(bbffr->buffer <= bbffr->head && bbffr->head < bbffr->bufferEnd);
-    ASSERT(bbffr->buffer <= bbffr->tail && bbffr->tail < bbffr->bufferEnd);
+    bbuffer_t *bbffr = mpsc->bbffr;
 
-    uint16_t popCnt;
-    *copyFrom = bbffr->tail;                                                    // current tail 
-    bbffr->pTail = bbffr->tail;                                                 // now pop operating on pTail
-
-    // now advance tail in expectation of copy out
-    if (BBFFR_WRAPPED)                                                          // ** wrapped
+    if (!commit)
     {
-        popCnt = MIN(requestSz, bbffr->bufferEnd - bbffr->pTail);               // get right-side of buffer
-        bbffr->pTail += popCnt;
-        if (bbffr->pTail == bbffr->bufferEnd)                                   // edge case: pop exhausted right-side, move tail to buffer start
-        {
-            bbffr->pTail = bbffr->buffer;
-        }
+        /* Newest reservation: return the space and sequence, as if never reserved */
+        bbffrMpscState_t expected = MPSC_STATE(resv->seq + 1, advancePtr(bbffr, resv->ptr, resv->len) - bbffr->buffer);
+        bbffrMpscState_t restored = MPSC_STATE(resv->seq, resv->ptr - bbffr->buffer);
+        if (__atomic_compare_exchange_n(&mpsc->reserveState, &expected, restored, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            return false;
     }
-    else                                                                        // ** linear
+    /* later reservations follow a rollback, it is published as void for the consumer to skip */
+    __atomic_store_n(&mpsc->slots[resv->seq % BBFFR_MPSC_SLOTS].mark, ((uint32_t)resv->seq << 2) | (commit ? mpscMark__committed : mpscMark__void), __ATOMIC_SEQ_CST);
+    mpscPublish(mpsc);
+    return commit;
+}
+
+
+/**
+ * @brief Consumer: skip void regions at tail, get chars readable before the next void.
+ */
+bbffrSz_t bbffr_mpscReadable(bbffrMpsc_t *mpsc)
+{
+    bbuffer_t *bbffr = mpsc->bbffr;
+    char *head = BBFFR_LOAD_ACQ(bbffr->head);                               // before voidIn, voids are recorded before head passes them
+    uint16_t voidIn = __atomic_load_n(&mpsc->voidIn, __ATOMIC_ACQUIRE);
+    uint16_t voidOut = BBFFR_LOAD_OWN(mpsc->voidOut);
+    char *tail = BBFFR_LOAD_OWN(bbffr->tail);
+    bool skipped = false;
+
+    while (voidOut != voidIn && mpsc->voids[voidOut % BBFFR_MPSC_VOIDS].offset == (bbffrSz_t)(tail - bbffr->buffer) &&
+           BBFFR_OCCUPIED(head, tail) >= mpsc->voids[voidOut % BBFFR_MPSC_VOIDS].len)        // recorded before head passed it
     {
-        popCnt = MIN(requestSz, bbffr->head - bbffr->pTail);
-        bbffr->pTail += popCnt;
+        bbffr_skipTail(bbffr, mpsc->voids[voidOut % BBFFR_MPSC_VOIDS].len);
+        __atomic_store_n(&mpsc->voidOut, ++voidOut, __ATOMIC_SEQ_CST);
+        tail = BBFFR_LOAD_OWN(bbffr->tail);
+        skipped = true;
     }
-    if (popCnt == 0)
+    if (skipped)
+        mpscPublish(mpsc);                                                  // publishing may have paused on a full void list
+
+    bbffrSz_t readable = BBFFR_OCCUPIED(head, tail);
+    if (voidOut != voidIn)
+        readable = MIN(readable, BBFFR_OCCUPIED(bbffr->buffer + mpsc->voids[voidOut % BBFFR_MPSC_VOIDS].offset, tail));
+    return readable;
+}
+
+
+/**
+ * @brief Consumer: pop chars from a multi-producer buffer, void regions are skipped.
+ */
+bbffrSz_t bbffr_mpscPop(bbffrMpsc_t *mpsc, char *dest, bbffrSz_t requestSz)
+{
+    bbffrSz_t popped = 0;
+
+    while (popped < requestSz)
     {
-        bbffr->pTail = NULL;
+        bbffrSz_t readable = bbffr_mpscReadable(mpsc);
+        if (readable == 0)
+            break;
+        popped += bbffr_pop(mpsc->bbffr, dest + popped, MIN(readable, requestSz - popped));
     }
-    ASSERT(bbffr->buffer <= bbffr->tail && bbffr->tail < bbffr->bufferEnd);
+    return popped;
+}
+
+
+/**
+ * @brief Pop a number of uint8_ts from buffer at buffer-tail. Number of characters "popped" will be the lesser of available and requestSz.
+ */
+bbffrSz_t bbffr_pop(bbuffer_t *bbffr, char *dest, bbffrSz_t requestSz)
+{
+    ASSERT(bbffr->pTail == NULL);                                           // pending popBlock() owns tail
+
+    if (bbffr->options & bbffrOption_overwrite)
+        return overwriteRead(bbffr, dest, requestSz, false, true);
+
+    char *tail = BBFFR_LOAD_OWN(bbffr->tail);
+    char *head = BBFFR_LOAD_ACQ(bbffr->head);                               // producer index: read once
+    ASSERT(bbffr->buffer <= head && head < bbffr->bufferEnd);
+    ASSERT(bbffr->buffer <= tail && tail < bbffr->bufferEnd);
+
+    bbffrSz_t popCnt = MIN(requestSz, BBFFR_OCCUPIED(head, tail));
+    tail = copyOut(bbffr, tail, dest, popCnt);
+
+    publishTail(bbffr, tail);                                               // release space only after copy out
+    return popCnt;
+}
+
+
+/**
+ * @brief Allocate a POP of chars from buffer at buffer-tail. Number of chars accounted for will be the lesser of available and requestSz.
+ */
+bbffrSz_t bbffr_popBlock(bbuffer_t *bbffr, char **copyFrom, bbffrSz_t requestSz)
+{
+    ASSERT(bbffr->pTail == NULL);                                           // pending popBlock already, no nesting popBlock()
+    ASSERT(!(bbffr->options & bbffrOption_overwrite));                      // in-place read is not overrun safe
+
+    char *tail = BBFFR_LOAD_OWN(bbffr->tail);
+    char *head = BBFFR_LOAD_ACQ(bbffr->head);
+    ASSERT(bbffr->buffer <= head && head < bbffr->bufferEnd);
+    ASSERT(bbffr->buffer <= tail && tail < bbffr->bufferEnd);
+
+    bbffrSz_t occupied = BBFFR_OCCUPIED(head, tail);
+    bbffrSz_t popCnt = alignBlock(bbffr, tail, MIN(requestSz, MIN(occupied, BBFFR_TOEDGE(tail))), true);
+
+    *copyFrom = tail;                                                       // current tail 
+    if (popCnt > 0)
+        bbffr->pTail = advancePtr(bbffr, tail, popCnt);                     // tail moves (space released to producer) on commit
     return popCnt;
 }
 
@@ -282,7 +582,7 @@ uint16_t bbffr_popBlock(bbuffer_t *bbffr, char **copyFrom, uint16_t requestSz)
 void bbffr_popBlockFinalize(bbuffer_t *bbffr, bool commit)
 {
     if (commit && bbffr->pTail != NULL)
-        bbffr->tail = bbffr->pTail;         // move tail ahead (unprotecting popBlock() copy out space)
+        publishTail(bbffr, bbffr->pTail);                                   // move tail ahead (unprotecting popBlock() copy out space)
     bbffr->pTail = NULL;
 }
 
@@ -291,16 +591,12 @@ void bbffr_popBlockFinalize(bbuffer_t *bbffr, bool commit)
  * @brief Pop a number of chars from buffer at buffer-tail, leaving the leaveSz number of chars in buffer.
  * @details This allows for simplified trailer parsing. Number of characters "popped" will be the lesser of available and requestSz - leaveSz.
  */
-uint16_t bbffr_popLeave(bbuffer_t *bbffr, char *dest, uint16_t requestSz, uint16_t leaveSz)
+bbffrSz_t bbffr_popLeave(bbuffer_t *bbffr, char *dest, bbffrSz_t requestSz, bbffrSz_t leaveSz)
 {
-    if (BBFFR_OCCUPIED <= leaveSz)
+    bbffrSz_t occupied = bbffr_getOccupied(bbffr);
+    if (occupied <= leaveSz)
         return 0;
-    else
-    {
-        uint16_t popSz = 0;
-        popSz = MIN((BBFFR_OCCUPIED - leaveSz), requestSz);
-        return bbffr_pop(bbffr, dest, popSz);
-    }
+    return bbffr_pop(bbffr, dest, MIN((occupied - leaveSz), requestSz));
 }
 
 
@@ -308,199 +604,1226 @@ uint16_t bbffr_popLeave(bbuffer_t *bbffr, char *dest, uint16_t requestSz, uint16
  * @brief Peeks a number of chars ahead in the buffer starting at buffer-tail. 
  * @details Number of characters "peeked" will be the lesser of available and requestSz.
  */
-uint16_t bbffr_peek(bbuffer_t *bbffr, char *dest, uint16_t requestSz)
+bbffrSz_t bbffr_peek(bbuffer_t *bbffr, char *dest, bbffrSz_t requestSz)
 {
-    uint16_t available = BBFFR_OCCUPIED;
-    uint16_t peeked;
+    if (bbffr->options & bbffrOption_overwrite)
+        return overwriteRead(bbffr, dest, requestSz, false, false);
 
-    if (!BBFFR_WRAPPED)                                              // ** linear
-    {
-        peeked = MIN(available, requestSz);
-        memcpy(dest, bbffr->tail, peeked);
-    }
-    else                                                                // ** wrapped
-    {
-        peeked = MIN(requestSz, bbffr->bufferEnd - bbffr->tail);            // get right-side of buffer
-        memcpy(dest, bbffr->tail, peeked);
-        available -= peeked;                                                // peeked number of chars serviced from request 
+    char *tail = BBFFR_LOAD_OWN(bbffr->tail);
+    char *head = BBFFR_LOAD_ACQ(bbffr->head);
 
-        if (available > 0)                                                  // get left-side of buffer
-        {
-            memcpy(dest + peeked, bbffr->buffer, available);
-            peeked += available;                                            // add 2nd copy back to report request serviced to caller
-        }
-    }
+    bbffrSz_t peeked = MIN(requestSz, BBFFR_OCCUPIED(head, tail));
+    copyOut(bbffr, tail, dest, peeked);
     return peeked;
 }
 
 
 /**
- * @brief Find needle in the buffer, searching forward from the buffer-tail to buffer-head.
+ * @brief Zero-copy peek, describe the occupied region starting at buffer-tail as at most two spans.
  */
-uint16_t bbffr_find(bbuffer_t *bbffr, const char *pNeedle, int16_t searchOffset, uint16_t searchWindowSz, bool setTail)
+uint8_t bbffr_peekSpans(bbuffer_t *bbffr, bbffrSpan_t spans[2], bbffrSz_t requestSz)
 {
-    uint8_t needleLen = strlen(pNeedle);
-    uint8_t matchedCnt = 0;                                     // chars matched, 
-    uint8_t rightSideLen = 0;
-    char *searchPtr;
-    char *pMatchPtr;                                            // possible match pointer (right-side partial length)
+    ASSERT(!(bbffr->options & bbffrOption_overwrite));                      // in-place read is not overrun safe
 
-    /* Where to start searching
-     */
-    if (searchOffset == 0)
-        searchPtr = bbffr->tail;
-    else
+    char *tail = BBFFR_LOAD_OWN(bbffr->tail);
+    char *head = BBFFR_LOAD_ACQ(bbffr->head);
+
+    bbffrSz_t available = MIN(requestSz, BBFFR_OCCUPIED(head, tail));
+    bbffrSz_t rightCnt = MIN(available, BBFFR_TOEDGE(tail));
+
+    spans[0].ptr = (rightCnt > 0) ? tail : NULL;                            // right-side: tail toward buffer end
+    spans[0].len = rightCnt;
+    spans[1].ptr = (available > rightCnt) ? bbffr->buffer : NULL;           // left-side: buffer start toward head
+    spans[1].len = available - rightCnt;
+    return (spans[1].len > 0) ? 2 : (spans[0].len > 0);
+}
+
+
+/**
+ * @brief Zero-copy push, describe the vacant region at buffer-head as at most two spans.
+ */
+uint8_t bbffr_pushSpans(bbuffer_t *bbffr, bbffrSpan_t spans[2], bbffrSz_t requestSz)
+{
+    ASSERT(bbffr->pHead == NULL);                                           // pending pushBlock owns the region at head
+
+    char *head = BBFFR_LOAD_OWN(bbffr->head);
+    char *tail = BBFFR_LOAD_LIMIT();
+
+    bbffrSz_t available = MIN(requestSz, BBFFR_VACANT(head, tail));
+    bbffrSz_t rightCnt = MIN(available, BBFFR_TOEDGE(head));
+
+    spans[0].ptr = (rightCnt > 0) ? head : NULL;                            // right-side: head toward buffer end
+    spans[0].len = rightCnt;
+    spans[1].ptr = (available > rightCnt) ? bbffr->buffer : NULL;           // left-side: buffer start toward tail
+    spans[1].len = available - rightCnt;
+    return (spans[1].len > 0) ? 2 : (spans[0].len > 0);
+}
+
+
+/**
+ * @brief Gather push, push the concatenation of several source spans into buffer at buffer-head as one operation.
+ */
+bbffrSz_t bbffr_pushv(bbuffer_t *bbffr, const bbffrSpan_t *srcv, uint8_t srcCnt)
+{
+    ASSERT(bbffr->pHead == NULL);
+
+    char *head = BBFFR_LOAD_OWN(bbffr->head);
+    char *tail = BBFFR_LOAD_ACQ(bbffr->rTail);
+    if (bbffr->options & bbffrOption_overwrite)
     {
-        if (searchOffset > 0)                                               // (+) skip ahead from tail
-        {
-            if (BBFFR_WRAPPED) {
-                uint16_t rightside = MIN(bbffr->bufferEnd - bbffr->tail, searchOffset);
-                searchPtr = MIN(bbffr->buffer + rightside, bbffr->head);
-            }
-            else {
-                searchPtr = MIN(bbffr->tail + searchOffset, bbffr->head);
-            }
-        }
-        else                                                                // (-) skip back from head
-        {
-            searchOffset *= -1;                                                 // make positive
-            if (BBFFR_WRAPPED) {
-                searchPtr = MAX(bbffr->head - searchOffset, bbffr->tail);
-            }
-            else {
-                uint16_t leftSide = MAX(bbffr->head - bbffr->buffer, searchOffset);
-                searchPtr = bbffr->bufferEnd - (searchOffset - leftSide);
-            }
-        }
+        uint32_t totalSz = 0;
+        for (uint8_t i = 0; i < srcCnt; i++)
+            totalSz += srcv[i].len;
+        tail = overwriteVacate(bbffr, head, MIN(totalSz, (uint32_t)(BBFFR_SIZE - 1)));
     }
+    bbffrSz_t vacant = BBFFR_VACANT(head, tail);
+    bbffrSz_t pushCnt = 0;
+    uint32_t requestSz = 0;
 
-    /* Search right-side (start to buffer wrap)
-     */
-    rightSideLen = needleLen;
-    while (searchPtr < BBFFR_RIGHTEDGE)
+    for (uint8_t i = 0; i < srcCnt; i++)
     {
-        if (memcmp(searchPtr, pNeedle, rightSideLen) == 0)
-        {
-            if (rightSideLen == needleLen)                     // found full needle before right-edge
-            {
-                if (setTail)
-                    bbffr->tail = searchPtr;
-                return searchPtr - bbffr->tail;                 // return offset from tail
-            }
-            else
-            {
-                pMatchPtr = searchPtr;                          // POSSIBLE start here
-                matchedCnt = BBFFR_RIGHTEDGE - searchPtr;
-                break;                                          // found start of needle
-            }
-        }
-        searchPtr++;
-        rightSideLen = MIN(BBFFR_RIGHTEDGE - searchPtr, needleLen);
+        bbffrSz_t copyCnt = MIN(srcv[i].len, vacant - pushCnt);
+        if (copyCnt > 0)
+            head = copyIn(bbffr, head, srcv[i].ptr, copyCnt);
+        pushCnt += copyCnt;
+        requestSz += srcv[i].len;
     }
+    publishHead(bbffr, head);                                               // publish once, all spans are visible together
+    if (pushCnt < requestSz)
+        countDropped(bbffr, requestSz - pushCnt);
+    return pushCnt;
+}
 
-    if (!BBFFR_WRAPPED)                                                 // if not wrapped, no further opportunity to match
-        return BBFFR_NOTFOUND;
 
-    /* Handle partial match at right edge, remaining must be at left edge before head
-     */
-    if (matchedCnt > 0)                                                 // partial match at right edge
+/**
+ * @brief Scatter pop, pop chars from buffer-tail filling several destination spans in order as one operation.
+ */
+bbffrSz_t bbffr_popv(bbuffer_t *bbffr, const bbffrSpan_t *destv, uint8_t destCnt)
+{
+    ASSERT(bbffr->pTail == NULL);
+
+    if (bbffr->options & bbffrOption_overwrite)                             // each span is an overrun safe pop
     {
-        if (memcmp(bbffr->buffer, pNeedle + matchedCnt, needleLen - matchedCnt) == 0)
-        {
-            if (setTail)
-                bbffr->tail = searchPtr;
-            return searchPtr - bbffr->tail;
-        }
-        else
+        bbffrSz_t popCnt = 0;
+        for (uint8_t i = 0; i < destCnt; i++)
         {
-            matchedCnt = 0;                                             // any match from right side is orphaned, start over
+            bbffrSz_t readCnt = overwriteRead(bbffr, destv[i].ptr, destv[i].len, false, true);
+            popCnt += readCnt;
+            if (readCnt < destv[i].len)
+                break;
         }
+        return popCnt;
     }
-    searchPtr = bbffr->buffer;                                          // moving to left side
 
-    /* Continue searching left-side (wrap point to head)
-     */
-    while (searchPtr < bbffr->head)
+    char *tail = BBFFR_LOAD_OWN(bbffr->tail);
+    char *head = BBFFR_LOAD_ACQ(bbffr->head);
+    bbffrSz_t occupied = BBFFR_OCCUPIED(head, tail);
+    bbffrSz_t popCnt = 0;
+
+    for (uint8_t i = 0; i < destCnt && popCnt < occupied; i++)
     {
-        if (memcmp(searchPtr, pNeedle, needleLen) == 0)
-        {   
-            if (setTail)
-                bbffr->tail = searchPtr;
-            return (searchPtr - bbffr->buffer) + (bbffr->bufferEnd - bbffr->tail);
-        }
-        searchPtr++;
+        bbffrSz_t copyCnt = MIN(destv[i].len, occupied - popCnt);
+        tail = copyOut(bbffr, tail, destv[i].ptr, copyCnt);
+        popCnt += copyCnt;
     }
-    return BBFFR_NOTFOUND;
+    publishTail(bbffr, tail);
+    return popCnt;
 }
 
 
 /**
- * @brief Advances the buffer's head (incoming) by the requested number of chars.
+ * @brief Pop chars from buffer-tail up to the first of a set of delimiter chars, scanning and copying in a single pass.
  */
-void bbffr_skipHead(bbuffer_t *bbffr, uint16_t skipCnt)
+bbffrSz_t bbffr_popUntil(bbuffer_t *bbffr, const char *delimSet, char *dest, bbffrSz_t destSz, uint8_t flags, bbffrUntil_t *result)
 {
-    if (BBFFR_WRAPPED) {                                                        // ** wrapped
-        bbffr->head = MIN(bbffr->head + skipCnt, bbffr->tail-1);
+    ASSERT(bbffr->pTail == NULL);
+    ASSERT(!(bbffr->options & bbffrOption_overwrite));                      // in-place read is not overrun safe
+
+    char *tail = BBFFR_LOAD_OWN(bbffr->tail);
+    char *head = BBFFR_LOAD_ACQ(bbffr->head);
+    bbffrSz_t occupied = BBFFR_OCCUPIED(head, tail);
+    size_t delimCnt = strlen(delimSet);
+    bool copyDelim = flags & bbffrUntilFlag_includeDelim;
+
+    /* Scan only what can be copied, when the delimiter is not copied the char following a full dest may still be it */
+    bbffrSz_t scanLimit = (destSz < occupied) ? destSz + !copyDelim : occupied;
+    bbffrSz_t scanned = 0;
+    bbffrSz_t copied = 0;
+    bool found = false;
+    char *scanPtr = tail;
+
+    while (scanned < scanLimit && !found)                                   // right-side, then left-side of buffer
+    {
+        bbffrSz_t segmentLen = MIN(scanLimit - scanned, BBFFR_TOEDGE(scanPtr));
+        bbffrSz_t delimIndx = delimScan(scanPtr, segmentLen, delimSet, delimCnt);
+        found = delimIndx < segmentLen;
+
+        bbffrSz_t copyCnt = MIN(found ? delimIndx + copyDelim : segmentLen, destSz - copied);
+        memcpy(dest + copied, scanPtr, copyCnt);
+        copied += copyCnt;
+        scanned += found ? delimIndx : segmentLen;
+        scanPtr = advancePtr(bbffr, scanPtr, segmentLen);
     }
-    else 
-    {                                                                           // ** linear
-        if (bbffr->head + skipCnt < bbffr->bufferEnd)
-            bbffr->head += skipCnt;
-        else if (bbffr->head + skipCnt == bbffr->bufferEnd)
-            bbffr->head = bbffr->buffer;
-        else {
-            uint16_t leftSkip = skipCnt - (bbffr->bufferEnd - bbffr->head);
-            bbffr->head = MIN(bbffr->head + leftSkip, bbffr->tail-1);
+
+    bbffrUntil_t outcome = found ? bbffrUntil_found : (destSz < occupied) ? bbffrUntil_destFull : bbffrUntil_notFound;
+    bbffrSz_t popCnt = copied;
+    if (found && (flags & (bbffrUntilFlag_consumeDelim | bbffrUntilFlag_includeDelim)))
+        popCnt = scanned + 1;
+    else if (!found && (flags & bbffrUntilFlag_requireDelim))
+        popCnt = copied = 0;
+
+    publishTail(bbffr, advancePtr(bbffr, tail, popCnt));
+    if (result != NULL)
+        *result = outcome;
+    return copied;
+}
+
+
+/**
+ * @brief Pop one complete '\n' terminated line (CR/LF or LF) as a c-string.
+ */
+bbffrSz_t bbffr_popLine(bbuffer_t *bbffr, char *dest, bbffrSz_t destSz)
+{
+    bbffrUntil_t result;
+
+    if (destSz == 0)
+        return BBFFR_NOTFOUND;
+
+    bbffrSz_t lineLen = bbffr_popUntil(bbffr, "\n", dest, destSz - 1, bbffrUntilFlag_consumeDelim | bbffrUntilFlag_requireDelim, &result);
+    if (result != bbffrUntil_found)
+        return BBFFR_NOTFOUND;
+
+    if (lineLen > 0 && dest[lineLen - 1] == '\r')
+        lineLen--;
+    dest[lineLen] = '\0';
+    return lineLen;
+}
+
+
+/* File descriptor I/O (Linux host)
+ ----------------------------------------------------------------------------------------------- */
+
+#if defined(__linux__)
+
+/**
+ * @brief Read from a file descriptor directly into the buffer at buffer-head, one read()/readv() call.
+ */
+bbffrSz_t bbffr_readFromFd(bbuffer_t *bbffr, int fd, bbffrSz_t maxSz, bbffrIo_t *result)
+{
+    ASSERT(bbffr->pHead == NULL);                                           // pending pushBlock() owns head
+
+    char *head = BBFFR_LOAD_OWN(bbffr->head);
+    char *tail = BBFFR_LOAD_LIMIT();
+    bbffrSz_t readMax = MIN(maxSz, BBFFR_VACANT(head, tail));
+    bbffrSz_t rightCnt = MIN(readMax, BBFFR_TOEDGE(head));
+    struct iovec iov[2] = { { head, rightCnt }, { bbffr->buffer, readMax - rightCnt } };
+    bbffrIo_t status = bbffrIo_ok;
+    ssize_t readCnt = 0;
+
+    if (readMax > 0)
+    {
+        do
+            readCnt = (iov[1].iov_len > 0) ? readv(fd, iov, 2) : read(fd, head, rightCnt);  // kernel copies straight into the vacant spans
+        while (readCnt < 0 && errno == EINTR);
+
+        if (readCnt > 0)
+            publishHead(bbffr, advancePtr(bbffr, head, readCnt));
+        else
+        {
+            status = (readCnt == 0) ? bbffrIo_eof : (errno == EAGAIN || errno == EWOULDBLOCK) ? bbffrIo_wouldBlock : bbffrIo_error;
+            readCnt = 0;
         }
     }
+    if (result != NULL)
+        *result = status;
+    return readCnt;
 }
 
 
 /**
- * @brief Advances the buffer's tail (outgoing) by the requested number of chars.
+ * @brief Write from the buffer at buffer-tail directly to a file descriptor, one write()/writev() call.
  */
-void bbffr_skipTail(bbuffer_t *bbffr, uint16_t skipCnt)
+bbffrSz_t bbffr_writeToFd(bbuffer_t *bbffr, int fd, bbffrSz_t maxSz, bbffrIo_t *result)
 {
-    uint16_t skipped;
-
-    if (BBFFR_WRAPPED)                                                          // ** wrapped (head < tail)
+    ASSERT(bbffr->pTail == NULL);                                           // pending popBlock() owns tail
+    ASSERT(!(bbffr->options & bbffrOption_overwrite));                      // in-place read is not overrun safe
+
+    char *tail = BBFFR_LOAD_OWN(bbffr->tail);
+    char *head = BBFFR_LOAD_ACQ(bbffr->head);
+    bbffrSz_t writeMax = MIN(maxSz, BBFFR_OCCUPIED(head, tail));
+    bbffrSz_t rightCnt = MIN(writeMax, BBFFR_TOEDGE(tail));
+    struct iovec iov[2] = { { tail, rightCnt }, { bbffr->buffer, writeMax - rightCnt } };
+    bbffrIo_t status = bbffrIo_ok;
+    ssize_t writeCnt = 0;
+
+    if (writeMax > 0)
     {
-        skipped = MIN(skipCnt, bbffr->bufferEnd - bbffr->tail);                         // right-side
-        if (skipped < skipCnt)                                                          // right side did not satisfy request
+        do
+            writeCnt = (iov[1].iov_len > 0) ? writev(fd, iov, 2) : write(fd, tail, rightCnt);
+        while (writeCnt < 0 && errno == EINTR);
+
+        if (writeCnt > 0)
+            publishTail(bbffr, advancePtr(bbffr, tail, writeCnt));          // release only what the descriptor accepted
+        else if (writeCnt < 0)
         {
-            bbffr->tail = MIN(bbffr->buffer + (skipCnt - skipped), bbffr->head);    // consume remaining to skip, up to buffer-head
+            status = (errno == EAGAIN || errno == EWOULDBLOCK) ? bbffrIo_wouldBlock : bbffrIo_error;
+            writeCnt = 0;
         }
     }
-    else                                                                        // ** linear (tail < head)
+    if (result != NULL)
+        *result = status;
+    return writeCnt;
+}
+
+#endif  // __linux__
+
+
+/* Record (framed) mode
+ ----------------------------------------------------------------------------------------------- */
+
+#define RECORD_HDRMAX ((8 * sizeof(bbffrSz_t) + 6) / 7)                     // varint chars to encode a bbffrSz_t length (3 or 5)
+
+
+/**
+ * @brief Push a whole record (length header + payload) into buffer at buffer-head; all or nothing.
+ */
+bool bbffr_pushRecord(bbuffer_t *bbffr, const char *src, bbffrSz_t srcSz)
+{
+    if (!bbffr_pushRecordStart(bbffr, srcSz))
     {
-            bbffr->tail = MIN(bbffr->tail + skipCnt, bbffr->head);
+        countDropped(bbffr, srcSz);
+        return false;
     }
+
+    bbffr_pushRecordAppend(bbffr, src, srcSz);
+    bbffr_pushBlockFinalize(bbffr, true);
+    return true;
+}
+
+
+/**
+ * @brief Start a record that is appended in pieces, space for the whole record is allocated up front.
+ */
+bool bbffr_pushRecordStart(bbuffer_t *bbffr, bbffrSz_t recordSz)
+{
+    ASSERT(bbffr->pHead == NULL);                                           // pending pushBlock already, no nesting
+
+    char *head = BBFFR_LOAD_OWN(bbffr->head);
+    char *tail = BBFFR_LOAD_ACQ(bbffr->rTail);
+    char header[RECORD_HDRMAX];
+    uint8_t headerSz = recordHeaderEncode(recordSz, header);
+
+    if ((bbffr->options & bbffrOption_overwrite) && recordSz <= BBFFR_SIZE - 1 - headerSz)
+        tail = overwriteVacate(bbffr, head, headerSz + recordSz);           // discard oldest records to fit
+    bbffrSz_t vacant = BBFFR_VACANT(head, tail);
+    if (recordSz == 0 || recordSz > vacant || headerSz > vacant - recordSz)
+        return false;
+
+    bbffr->pHead = copyIn(bbffr, head, header, headerSz);                   // header in place, visible on commit
+    bbffr->pRecordRemain = recordSz;
+    bbffr->pRecord = true;
+    return true;
+}
+
+
+/**
+ * @brief Append payload to a record started with bbffr_pushRecordStart().
+ */
+bbffrSz_t bbffr_pushRecordAppend(bbuffer_t *bbffr, const char *src, bbffrSz_t srcSz)
+{
+    if (!bbffr->pRecord)
+        return 0;
+
+    bbffrSz_t appendCnt = MIN(srcSz, bbffr->pRecordRemain);
+    bbffr->pHead = copyIn(bbffr, bbffr->pHead, src, appendCnt);             // space was allocated by pushRecordStart()
+    bbffr->pRecordRemain -= appendCnt;
+    return appendCnt;
 }
 
 
-// /* Transaction
-//  ----------------------------------------------------------------------------------------------- */
+/**
+ * @brief Pop the next whole record from buffer-tail.
+ */
+bbffrSz_t bbffr_popRecord(bbuffer_t *bbffr, char *dest, bbffrSz_t destSz)
+{
+    ASSERT(bbffr->pTail == NULL);
 
-// bool bbffr_startTransaction(bbuffer_t *bbffr)
-// {
-//     if (bbffr->bTail == NULL)
-//     {
-//         bbffr->bTail = bbffr->tail;
-//         return true;
-//     }
-//     return false;
-// }
+    if (bbffr->options & bbffrOption_overwrite)
+        return overwriteRead(bbffr, dest, destSz, true, true);
 
+    char *payload;
+    bbffrSz_t recordSz = recordAtTail(bbffr, &payload);
+    if (recordSz == 0 || recordSz > destSz)
+        return 0;
 
-// void bbffr_commitTransaction(bbuffer_t *bbffr)
-// {
-//     bbffr->tail = bbffr->bTail;
-//     bbffr->bTail = NULL;
-// }
+    publishTail(bbffr, copyOut(bbffr, payload, dest, recordSz));
+    BBFFR_STORE_REL(bbffr->recordsOut, bbffr->recordsOut + 1);
+    return recordSz;
+}
 
 
-// void bbffr_rollbackTransaction(bbuffer_t *bbffr)
-// {
-//     bbffr->bTail = NULL;
-// }
+/**
+ * @brief Zero-copy peek of the next whole record's payload, as at most two spans.
+ */
+bbffrSz_t bbffr_peekRecord(bbuffer_t *bbffr, bbffrSpan_t spans[2])
+{
+    ASSERT(!(bbffr->options & bbffrOption_overwrite));                      // in-place read is not overrun safe
+
+    char *payload;
+    bbffrSz_t recordSz = recordAtTail(bbffr, &payload);
+    bbffrSz_t rightCnt = MIN(recordSz, BBFFR_TOEDGE(payload));
+
+    spans[0].ptr = (rightCnt > 0) ? payload : NULL;
+    spans[0].len = rightCnt;
+    spans[1].ptr = (recordSz > rightCnt) ? bbffr->buffer : NULL;
+    spans[1].len = recordSz - rightCnt;
+    return recordSz;
+}
+
+
+/**
+ * @brief Discard the next whole record at buffer-tail.
+ */
+bbffrSz_t bbffr_skipRecord(bbuffer_t *bbffr)
+{
+    ASSERT(bbffr->pTail == NULL);
+
+    if (bbffr->options & bbffrOption_overwrite)
+        return overwriteRead(bbffr, NULL, BBFFR_SIZE, true, true);
+
+    char *payload;
+    bbffrSz_t recordSz = recordAtTail(bbffr, &payload);
+    if (recordSz == 0)
+        return 0;
+
+    publishTail(bbffr, advancePtr(bbffr, payload, recordSz));
+    BBFFR_STORE_REL(bbffr->recordsOut, bbffr->recordsOut + 1);
+    return recordSz;
+}
+
+
+/**
+ * @brief Get number of complete records in the buffer.
+ */
+uint16_t bbffr_getRecordCount(bbuffer_t *bbffr)
+{
+    uint16_t recordsDiscarded = BBFFR_LOAD_ACQ(bbffr->recordsDiscarded);   // before recordsIn, which covers every discarded record
+    return (uint16_t)(BBFFR_LOAD_ACQ(bbffr->recordsIn) - BBFFR_LOAD_ACQ(bbffr->recordsOut) - recordsDiscarded);
+}
+
+
+/**
+ * @brief Get payload length of the next record at buffer-tail.
+ */
+bbffrSz_t bbffr_getRecordSize(bbuffer_t *bbffr)
+{
+    char *payload;
+    return recordAtTail(bbffr, &payload);
+}
+
+
+/**
+ * @brief Find needle in the buffer, searching forward from the buffer-tail to buffer-head.
+ */
+bbffrSz_t bbffr_find(bbuffer_t *bbffr, const char *pNeedle, bbffrOffset_t searchOffset, bbffrSz_t searchWindowSz, bool setTail)
+{
+    ASSERT(!(bbffr->options & bbffrOption_overwrite));                      // in-place read is not overrun safe
+
+    char *tail = BBFFR_LOAD_OWN(bbffr->tail);
+    char *head = BBFFR_LOAD_ACQ(bbffr->head);                               // search is bounded by head at time of call
+    size_t needleLen = strlen(pNeedle);
+    bbffrSz_t searchStart;
+    bbffrSz_t searchEnd;
+
+    if (needleLen == 0 || needleLen >= BBFFR_NOTFOUND)
+        return BBFFR_NOTFOUND;
+    if (!searchBounds(bbffr, head, tail, searchOffset, searchWindowSz, needleLen, &searchStart, &searchEnd))
+        return BBFFR_NOTFOUND;
+
+    char *searchPtr = advancePtr(bbffr, tail, searchStart);
+    for (bbffrSz_t offset = searchStart; offset + needleLen <= searchEnd; offset++)
+    {
+        if (matchesAt(bbffr, searchPtr, pNeedle, needleLen))
+            return foundAt(bbffr, tail, offset, setTail);
+        searchPtr = advancePtr(bbffr, searchPtr, 1);
+    }
+    return BBFFR_NOTFOUND;
+}
+
+
+/**
+ * @brief Prepare a needle for repeated searches with bbffr_findCompiled().
+ */
+bool bbffr_compileNeedle(bbffrNeedle_t *compiled, const char *pNeedle)
+{
+    size_t needleLen = strlen(pNeedle);
+    if (needleLen == 0 || needleLen >= BBFFR_NOTFOUND)
+        return false;
+
+    compiled->needle = pNeedle;
+    compiled->needleLen = needleLen;
+
+    /* Horspool bad-character shifts, shift is distance from a char's last occurrence (excluding final char) to needle end. 
+     * Shifts are clamped to 255, a shorter shift is always safe (only slower) for long needles.
+     */
+    memset(compiled->skip, MIN(needleLen, UINT8_MAX), sizeof(compiled->skip));
+    for (bbffrSz_t i = 0; i < needleLen - 1; i++)
+    {
+        compiled->skip[(uint8_t)pNeedle[i]] = MIN(needleLen - 1 - i, UINT8_MAX);
+    }
+    return true;
+}
+
+
+/**
+ * @brief Find a compiled needle in the buffer, same search semantics and results as bbffr_find().
+ */
+bbffrSz_t bbffr_findCompiled(bbuffer_t *bbffr, const bbffrNeedle_t *compiled, bbffrOffset_t searchOffset, bbffrSz_t searchWindowSz, bool setTail)
+{
+    ASSERT(!(bbffr->options & bbffrOption_overwrite));                      // in-place read is not overrun safe
+
+    char *tail = BBFFR_LOAD_OWN(bbffr->tail);
+    char *head = BBFFR_LOAD_ACQ(bbffr->head);
+    bbffrSz_t needleLen = compiled->needleLen;
+    bbffrSz_t searchStart;
+    bbffrSz_t searchEnd;
+
+    if (!searchBounds(bbffr, head, tail, searchOffset, searchWindowSz, needleLen, &searchStart, &searchEnd))
+        return BBFFR_NOTFOUND;
+
+    bbffrSz_t offset = horspoolScan(bbffr, tail, compiled, searchStart, searchEnd);
+    if (offset == BBFFR_NOTFOUND)
+        return BBFFR_NOTFOUND;
+    return foundAt(bbffr, tail, offset, setTail);
+}
+
+
+/**
+ * @brief Start (or restart) an incremental search for a compiled needle at the buffer-tail.
+ */
+void bbffr_searchInit(bbuffer_t *bbffr, bbffrSearch_t *search, const bbffrNeedle_t *compiled)
+{
+    search->needle = compiled;
+    search->resumePtr = BBFFR_LOAD_OWN(bbffr->tail);
+}
+
+
+/**
+ * @brief Continue an incremental search, examining only chars pushed since the previous call.
+ */
+bbffrSz_t bbffr_searchNext(bbuffer_t *bbffr, bbffrSearch_t *search, bool setTail)
+{
+    ASSERT(!(bbffr->options & bbffrOption_overwrite));                      // in-place read is not overrun safe
+
+    char *tail = BBFFR_LOAD_OWN(bbffr->tail);
+    char *head = BBFFR_LOAD_ACQ(bbffr->head);
+    bbffrSz_t occupied = BBFFR_OCCUPIED(head, tail);
+    bbffrSz_t needleLen = search->needle->needleLen;
+
+    bbffrSz_t resumeOffset = BBFFR_OCCUPIED(search->resumePtr, tail);       // distance tail to resume position
+    if (resumeOffset > occupied)                                            // tail moved beyond resume position, restart at tail
+        resumeOffset = 0;
+
+    bbffrSz_t offset = horspoolScan(bbffr, tail, search->needle, resumeOffset, occupied);
+    if (offset == BBFFR_NOTFOUND)
+    {
+        /* Chars scanned are ruled out as needle start, except the final (needleLen - 1) which may hold a partial needle 
+         * completed by a later push
+         */
+        if (occupied >= needleLen)
+            resumeOffset = MAX(resumeOffset, occupied - needleLen + 1);
+        search->resumePtr = advancePtr(bbffr, tail, resumeOffset);
+        return BBFFR_NOTFOUND;
+    }
+    search->resumePtr = advancePtr(bbffr, tail, offset);                    // found: repeated calls report the same needle
+    return foundAt(bbffr, tail, offset, setTail);
+}
+
+
+/**
+ * @brief Build a multi-pattern matcher from a table of patterns.
+ */
+bool bbffr_buildMatcher(bbffrMatcher_t *matcher, const char * const *patterns, uint8_t patternCnt)
+{
+    uint8_t fail[BBFFR_MATCHER_MAXSTATES];
+    uint8_t queue[BBFFR_MATCHER_MAXSTATES];
+    uint8_t stateCnt = 1;                                                   // state 0 is the root
+    uint8_t classCnt = 1;                                                   // class 0 is "other"
+
+    if (patternCnt == 0 || patternCnt > BBFFR_MATCHER_MAXPATTERNS)
+        return false;
+
+    memset(matcher, 0, sizeof(bbffrMatcher_t));
+    matcher->minPatternLen = UINT8_MAX;
+
+    /* Build trie of the patterns, next[][] 0 means no child (root is never a child)
+     */
+    for (uint8_t p = 0; p < patternCnt; p++)
+    {
+        size_t patternLen = strlen(patterns[p]);
+        if (patternLen == 0 || patternLen > UINT8_MAX)
+            return false;
+
+        uint8_t state = 0;
+        for (size_t i = 0; i < patternLen; i++)
+        {
+            uint8_t chr = (uint8_t)patterns[p][i];
+            if (matcher->classMap[chr] == 0)
+            {
+                if (classCnt == BBFFR_MATCHER_MAXCLASSES)
+                    return false;
+                matcher->classMap[chr] = classCnt++;
+            }
+            uint8_t *child = &matcher->next[state][matcher->classMap[chr]];
+            if (*child == 0)
+            {
+                if (stateCnt == BBFFR_MATCHER_MAXSTATES)
+                    return false;
+                *child = stateCnt++;
+            }
+            state = *child;
+        }
+        if (matcher->output[state] == 0)                                    // duplicate pattern: first in table is reported
+            matcher->output[state] = p + 1;
+        matcher->patternLens[p] = patternLen;
+        matcher->maxPatternLen = MAX(matcher->maxPatternLen, patternLen);
+        matcher->minPatternLen = MIN(matcher->minPatternLen, patternLen);
+    }
+
+    /* Breadth-first: set failure links and complete the transition table (missing child = failure state's transition),
+     * a state's output falls back to the output of its failure state (the longest proper suffix that is a pattern)
+     */
+    uint8_t qHead = 0;
+    uint8_t qTail = 0;
+    for (uint8_t c = 0; c < classCnt; c++)
+    {
+        uint8_t child = matcher->next[0][c];
+        if (child != 0)
+        {
+            fail[child] = 0;
+            queue[qTail++] = child;
+        }
+    }
+    while (qHead < qTail)
+    {
+        uint8_t state = queue[qHead++];
+        if (matcher->output[state] == 0)
+            matcher->output[state] = matcher->output[fail[state]];
+
+        for (uint8_t c = 0; c < classCnt; c++)
+        {
+            uint8_t child = matcher->next[state][c];
+            if (child != 0)
+            {
+                fail[child] = matcher->next[fail[state]][c];
+                queue[qTail++] = child;
+            }
+            else
+                matcher->next[state][c] = matcher->next[fail[state]][c];
+        }
+    }
+    return true;
+}
+
+
+/**
+ * @brief Find the earliest occurrence of any of a matcher's patterns in one pass over the buffer.
+ */
+bbffrSz_t bbffr_findAny(bbuffer_t *bbffr, const bbffrMatcher_t *matcher, bbffrOffset_t searchOffset, bbffrSz_t searchWindowSz, bool setTail, uint8_t *patternIndx)
+{
+    ASSERT(!(bbffr->options & bbffrOption_overwrite));                      // in-place read is not overrun safe
+
+    char *tail = BBFFR_LOAD_OWN(bbffr->tail);
+    char *head = BBFFR_LOAD_ACQ(bbffr->head);
+    bbffrSz_t searchStart;
+    bbffrSz_t searchEnd;
+
+    if (!searchBounds(bbffr, head, tail, searchOffset, searchWindowSz, matcher->minPatternLen, &searchStart, &searchEnd))
+        return BBFFR_NOTFOUND;
+
+    uint8_t state = 0;
+    bbffrSz_t matchStart = BBFFR_NOTFOUND;
+    uint8_t matchPattern = 0;
+    bbffrSz_t offset = searchStart;
+    char *scanPtr = advancePtr(bbffr, tail, searchStart);
+
+    while (offset < searchEnd)
+    {
+        bbffrSz_t segmentEnd = MIN(searchEnd, offset + BBFFR_TOEDGE(scanPtr)); // right-side, then left-side of buffer
+        for (; offset < segmentEnd; offset++, scanPtr++)
+        {
+            state = matcher->next[state][matcher->classMap[(uint8_t)*scanPtr]];
+            if (matcher->output[state] == 0)
+                continue;
+
+            uint8_t pattern = matcher->output[state] - 1;
+            bbffrSz_t start = offset + 1 - matcher->patternLens[pattern];
+            if (matchStart == BBFFR_NOTFOUND || start < matchStart || 
+                (start == matchStart && matcher->patternLens[pattern] > matcher->patternLens[matchPattern]))
+            {
+                matchStart = start;
+                matchPattern = pattern;
+                searchEnd = matchStart + MIN(searchEnd - matchStart, matcher->maxPatternLen);    // only an earlier starting (or longer) match can still complete
+                segmentEnd = MIN(segmentEnd, searchEnd);
+            }
+        }
+        if (scanPtr >= bbffr->bufferEnd)
+            scanPtr -= BBFFR_SIZE;
+    }
+
+    if (matchStart == BBFFR_NOTFOUND)
+        return BBFFR_NOTFOUND;
+    *patternIndx = matchPattern;
+    return foundAt(bbffr, tail, matchStart, setTail);
+}
+
+
+/**
+ * @brief Advances the buffer's head (incoming) by the requested number of chars.
+ */
+void bbffr_skipHead(bbuffer_t *bbffr, bbffrSz_t skipCnt)
+{
+    char *head = BBFFR_LOAD_OWN(bbffr->head);
+    char *tail = BBFFR_LOAD_LIMIT();
+
+    skipCnt = MIN(skipCnt, BBFFR_VACANT(head, tail));
+    publishHead(bbffr, advancePtr(bbffr, head, skipCnt));
+}
+
+
+/**
+ * @brief Advances the buffer's tail (outgoing) by the requested number of chars.
+ */
+void bbffr_skipTail(bbuffer_t *bbffr, bbffrSz_t skipCnt)
+{
+    if (bbffr->options & bbffrOption_overwrite)
+    {
+        overwriteRead(bbffr, NULL, skipCnt, false, true);
+        return;
+    }
+
+    char *tail = BBFFR_LOAD_OWN(bbffr->tail);
+    char *head = BBFFR_LOAD_ACQ(bbffr->head);
+
+    skipCnt = MIN(skipCnt, BBFFR_OCCUPIED(head, tail));                     // consume up to buffer-head
+    publishTail(bbffr, advancePtr(bbffr, tail, skipCnt));
+}
+
+
+/**
+ * @brief Rotate contents in place to start at buffer, NUL terminated.
+ */
+char *bbffr_linearize(bbuffer_t *bbffr)
+{
+    ASSERT(bbffr->pHead == NULL && bbffr->pTail == NULL);
+    ASSERT(bbffr->checkpointCnt == 0);
+    ASSERT(!(bbffr->options & bbffrOption_overwrite));
+
+    char *head = BBFFR_LOAD_OWN(bbffr->head);
+    char *tail = BBFFR_LOAD_OWN(bbffr->tail);
+    bbffrSz_t occupied = BBFFR_OCCUPIED(head, tail);
+
+    if (!BBFFR_WRAPPED(head, tail))
+        memmove(bbffr->buffer, tail, occupied);
+    else
+    {
+        bbffrSz_t rightSz = bbffr->bufferEnd - tail;
+        if (rightSz <= (bbffrSz_t)(tail - head))                            // left-side slides up into the vacant gap
+        {
+            memmove(bbffr->buffer + rightSz, bbffr->buffer, head - bbffr->buffer);
+            memcpy(bbffr->buffer, tail, rightSz);
+        }
+        else                                                                // rotate whole storage left by tail offset
+        {
+            reverseChars(bbffr->buffer, tail);
+            reverseChars(tail, bbffr->bufferEnd);
+            reverseChars(bbffr->buffer, bbffr->bufferEnd);
+        }
+    }
+
+    head = bbffr->buffer + occupied;                                        // occupied < size, head slot is always vacant
+    *head = '\0';
+    BBFFR_STORE_REL(bbffr->tail, bbffr->buffer);
+    BBFFR_STORE_REL(bbffr->rTail, bbffr->buffer);
+    BBFFR_STORE_REL(bbffr->head, head);
+    return bbffr->buffer;
+}
+
+
+/* Transaction
+ ----------------------------------------------------------------------------------------------- */
+
+/**
+ * @brief Start a consumer transaction (nestable), checkpointing the current tail.
+ */
+bool bbffr_startTransaction(bbuffer_t *bbffr)
+{
+    ASSERT(bbffr->pTail == NULL);                                           // pending popBlock() must finalize first
+    ASSERT(!(bbffr->options & bbffrOption_overwrite));                      // producer does not honor checkpoints when overwriting
+
+    if (bbffr->checkpointCnt == BBFFR_CHECKPOINTS)
+        return false;
+
+    bbffrCheckpoint_t *checkpoint = &bbffr->checkpoints[bbffr->checkpointCnt++];
+    checkpoint->tail = BBFFR_LOAD_OWN(bbffr->tail);
+    checkpoint->recordsOut = bbffr->recordsOut;
+    return true;
+}
+
+
+/**
+ * @brief Commit the innermost transaction, keeping what was consumed.
+ */
+void bbffr_commitTransaction(bbuffer_t *bbffr)
+{
+    ASSERT(bbffr->pTail == NULL);
+
+    if (bbffr->checkpointCnt > 0 && --bbffr->checkpointCnt == 0)
+        releaseTail(bbffr, BBFFR_LOAD_OWN(bbffr->tail));                    // outermost: consumed space now free to producer
+}
+
+
+/**
+ * @brief Rollback the innermost transaction, restoring tail (and record count) to its checkpoint.
+ */
+void bbffr_rollbackTransaction(bbuffer_t *bbffr)
+{
+    ASSERT(bbffr->pTail == NULL);
+
+    if (bbffr->checkpointCnt == 0)
+        return;
+
+    bbffrCheckpoint_t *checkpoint = &bbffr->checkpoints[--bbffr->checkpointCnt];
+    BBFFR_STORE_REL(bbffr->recordsOut, checkpoint->recordsOut);
+    BBFFR_STORE_REL(bbffr->tail, checkpoint->tail);                         // chars were never released, still intact
+}
+
+
+#pragma region Static Local Functions
+
+/**
+ *  @brief STATIC Scope: Advance a buffer position pointer by a count of chars, wrapping at buffer end.
+ */
+static char *advancePtr(bbuffer_t *bbffr, char *ptr, bbffrSz_t advanceCnt)
+{
+    ptr += advanceCnt;
+    if (ptr >= bbffr->bufferEnd)
+        ptr -= BBFFR_SIZE;
+    return ptr;
+}
+
+
+/**
+ *  @brief STATIC Scope: Compare needle at a buffer position, comparison continues across the buffer wrap.
+ */
+static bool matchesAt(bbuffer_t *bbffr, char *searchPtr, const char *pNeedle, bbffrSz_t needleLen)
+{
+    bbffrSz_t rightSideLen = MIN(needleLen, BBFFR_TOEDGE(searchPtr));
+
+    if (memcmp(searchPtr, pNeedle, rightSideLen) != 0)
+        return false;
+    return memcmp(bbffr->buffer, pNeedle + rightSideLen, needleLen - rightSideLen) == 0;
+}
+
+
+/**
+ *  @brief STATIC Scope: Resolve find() offset/window arguments to a search range (offsets from tail). Returns false if needle cannot fit.
+ */
+static bool searchBounds(bbuffer_t *bbffr, char *head, char *tail, bbffrOffset_t searchOffset, bbffrSz_t searchWindowSz, bbffrSz_t needleLen, bbffrSz_t *searchStart, bbffrSz_t *searchEnd)
+{
+    bbffrSz_t occupied = BBFFR_OCCUPIED(head, tail);
+
+    *searchStart = 0;
+    if (searchOffset > 0)                                                   // (+) skip ahead from tail
+        *searchStart = MIN((bbffrSz_t)searchOffset, occupied);
+    else if (searchOffset < 0)                                              // (-) skip back from head
+        *searchStart = ((bbffrSz_t)-searchOffset < occupied) ? occupied + searchOffset : 0;
+
+    *searchEnd = (searchWindowSz == 0) ? occupied : *searchStart + MIN(occupied - *searchStart, searchWindowSz);
+    return *searchEnd - *searchStart >= needleLen;
+}
+
+
+/**
+ *  @brief STATIC Scope: Complete a successful find, optionally advancing tail to the match. Returns offset from (original) tail.
+ */
+static bbffrSz_t foundAt(bbuffer_t *bbffr, char *tail, bbffrSz_t offset, bool setTail)
+{
+    if (setTail)
+    {
+        ASSERT(bbffr->pTail == NULL);
+        publishTail(bbffr, advancePtr(bbffr, tail, offset));
+    }
+    return offset;
+}
+
+
+/**
+ *  @brief STATIC Scope: Horspool search for a compiled needle between offsets (from tail), returns offset of needle or BBFFR_NOTFOUND.
+ */
+static bbffrSz_t horspoolScan(bbuffer_t *bbffr, char *tail, const bbffrNeedle_t *compiled, bbffrSz_t searchStart, bbffrSz_t searchEnd)
+{
+    bbffrSz_t needleLen = compiled->needleLen;
+    bbffrSz_t lastIndx = needleLen - 1;
+    char lastChar = compiled->needle[lastIndx];
+
+    for (size_t offset = searchStart; offset + needleLen <= searchEnd; )     // size_t: skip cannot wrap offset
+    {
+        char windowLast = *advancePtr(bbffr, tail, offset + lastIndx);      // test window's last char first, then full compare
+        if (windowLast == lastChar && matchesAt(bbffr, advancePtr(bbffr, tail, offset), compiled->needle, lastIndx))
+            return offset;
+        offset += compiled->skip[(uint8_t)windowLast];
+    }
+    return BBFFR_NOTFOUND;
+}
+
+
+/**
+ *  @brief STATIC Scope: Advance buffer head over finalized reservations, in reservation order.
+ *  @details Only one producer publishes at a time (try-lock, never waited on); a producer finding the publisher busy 
+ *  leaves its finalized slot for the current publisher, which re-checks for late arrivals after releasing the lock.
+ */
+static void mpscPublish(bbffrMpsc_t *mpsc)
+{
+    bbuffer_t *bbffr = mpsc->bbffr;
+    uint16_t seq;
+    uint32_t mark;
+
+    do
+    {
+        uint32_t unlocked = 0;
+        if (!__atomic_compare_exchange_n(&mpsc->publishLock, &unlocked, 1, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+            return;
+
+        seq = mpsc->publishSeq;
+        char *head = BBFFR_LOAD_OWN(bbffr->head);
+        uint16_t voidIn = BBFFR_LOAD_OWN(mpsc->voidIn);
+        while (true)
+        {
+            mark = __atomic_load_n(&mpsc->slots[seq % BBFFR_MPSC_SLOTS].mark, __ATOMIC_ACQUIRE);
+            if ((mark & 0x03) == 0 || (uint16_t)(mark >> 2) != seq)       // next in order is not finalized
+                break;
+            bbffrSz_t len = mpsc->slots[seq % BBFFR_MPSC_SLOTS].len;
+            if ((mark & 0x03) == mpscMark__void)
+            {
+                if ((uint16_t)(voidIn - __atomic_load_n(&mpsc->voidOut, __ATOMIC_SEQ_CST)) >= BBFFR_MPSC_VOIDS)
+                    break;                                                  // void list full, consumer resumes publishing
+                mpsc->voids[voidIn % BBFFR_MPSC_VOIDS].offset = head - bbffr->buffer;
+                mpsc->voids[voidIn % BBFFR_MPSC_VOIDS].len = len;
+                __atomic_store_n(&mpsc->voidIn, ++voidIn, __ATOMIC_RELEASE);
+            }
+            head = advancePtr(bbffr, head, len);
+            seq++;
+            __atomic_store_n(&mpsc->publishSeq, seq, __ATOMIC_RELEASE);     // slot free for reuse
+        }
+        publishHead(bbffr, head);
+        __atomic_store_n(&mpsc->publishLock, 0, __ATOMIC_SEQ_CST);
+
+        mark = __atomic_load_n(&mpsc->slots[seq % BBFFR_MPSC_SLOTS].mark, __ATOMIC_SEQ_CST);
+        if ((mark & 0x03) == mpscMark__void && (uint16_t)(voidIn - __atomic_load_n(&mpsc->voidOut, __ATOMIC_SEQ_CST)) >= BBFFR_MPSC_VOIDS)
+            mark = 0;                                                       // still paused on a full void list
+    } while ((mark & 0x03) != 0 && (uint16_t)(mark >> 2) == seq);          // finalized (or void list drained) while we held the lock
+}
+
+
+/**
+ *  @brief STATIC Scope: Producer publishes a new head, then updates instrumentation and checks the high watermark.
+ */
+static void publishHead(bbuffer_t *bbffr, char *head)
+{
+    char *prevHead = BBFFR_LOAD_OWN(bbffr->head);
+    BBFFR_STORE_REL(bbffr->head, head);
+
+    char *tail = BBFFR_LOAD_LIMIT();
+    bbffrSz_t occupied = BBFFR_OCCUPIED(head, tail);
+    BBFFR_STAT_ADD(bbffr->stats.bytesIn, BBFFR_OCCUPIED(head, prevHead));  // distance moved
+    if (occupied > bbffr->stats.peakOccupied)
+        __atomic_store_n(&bbffr->stats.peakOccupied, occupied, __ATOMIC_RELAXED);
+
+    bbffrWatermark_func watermarkCB = bbffr->watermarkCB;
+    if (watermarkCB != NULL && occupied >= bbffr->highMark && bbffr->highCnt == BBFFR_LOAD_ACQ(bbffr->lowCnt))
+    {
+        watermarkCB(bbffr, bbffrWatermark_high, occupied);
+        BBFFR_STORE_REL(bbffr->highCnt, bbffr->highCnt + 1);                // after callback, low cannot fire ahead of it
+    }
+}
+
+
+/**
+ *  @brief STATIC Scope: Consumer publishes a new tail, space is released to the producer unless a transaction is open.
+ */
+static void publishTail(bbuffer_t *bbffr, char *tail)
+{
+    BBFFR_STORE_REL(bbffr->tail, tail);
+    if (bbffr->checkpointCnt == 0)
+        releaseTail(bbffr, tail);
+}
+
+
+/**
+ *  @brief STATIC Scope: Consumer releases space to the producer, then updates instrumentation and checks the low watermark.
+ */
+static void releaseTail(bbuffer_t *bbffr, char *tail)
+{
+    char *prevTail = BBFFR_LOAD_OWN(bbffr->rTail);
+    BBFFR_STORE_REL(bbffr->rTail, tail);
+    BBFFR_STAT_ADD(bbffr->stats.bytesOut, BBFFR_OCCUPIED(tail, prevTail));
+
+    bbffrWatermark_func watermarkCB = bbffr->watermarkCB;
+    uint16_t highCnt = BBFFR_LOAD_ACQ(bbffr->highCnt);
+    if (watermarkCB != NULL && highCnt != bbffr->lowCnt)                    // above high, checked even if nothing was popped
+    {
+        bbffrSz_t occupied = BBFFR_OCCUPIED(BBFFR_LOAD_ACQ(bbffr->head), tail);
+        if (occupied <= bbffr->lowMark)
+        {
+            watermarkCB(bbffr, bbffrWatermark_low, occupied);
+            BBFFR_STORE_REL(bbffr->lowCnt, highCnt);
+        }
+    }
+}
+
+
+/**
+ *  @brief STATIC Scope: Producer counts a push that could not push all of its chars.
+ */
+static void countDropped(bbuffer_t *bbffr, uint32_t droppedCnt)
+{
+    BBFFR_STAT_ADD(bbffr->stats.truncatedPushes, 1);
+    BBFFR_STAT_ADD(bbffr->stats.droppedBytes, droppedCnt);
+}
+
+
+/**
+ *  @brief STATIC Scope: Find first delimiter char in a contiguous segment. Returns index of delimiter, segmentLen if none.
+ */
+static bbffrSz_t delimScan(const char *segment, bbffrSz_t segmentLen, const char *delimSet, size_t delimCnt)
+{
+    if (delimCnt == 1)                                                      // common case (ex: '\n'), library scan
+    {
+        const char *delimPtr = memchr(segment, delimSet[0], segmentLen);
+        return (delimPtr != NULL) ? delimPtr - segment : segmentLen;
+    }
+    for (bbffrSz_t i = 0; i < segmentLen; i++)
+    {
+        if (memchr(delimSet, segment[i], delimCnt) != NULL)
+            return i;
+    }
+    return segmentLen;
+}
+
+
+/**
+ *  @brief STATIC Scope: Encode a record length as a varint header (low 7 bits first, high bit set on all but last). Returns header length.
+ */
+static uint8_t recordHeaderEncode(bbffrSz_t recordSz, char *header)
+{
+    uint8_t headerSz = 0;
+    do
+    {
+        header[headerSz] = recordSz & 0x7F;
+        recordSz >>= 7;
+        if (recordSz > 0)
+            header[headerSz] |= 0x80;                                       // more header chars follow
+        headerSz++;
+    } while (recordSz > 0);
+    return headerSz;
+}
+
+
+/**
+ *  @brief STATIC Scope: Decode the header of the record at buffer-tail (consumer). Returns payload length, 0 if no complete record.
+ */
+static bbffrSz_t recordAtTail(bbuffer_t *bbffr, char **payloadPtr)
+{
+    *payloadPtr = BBFFR_LOAD_OWN(bbffr->tail);
+    if (bbffr_getRecordCount(bbffr) == 0)                                   // acquire on recordsIn covers the record's chars
+        return 0;
+    return recordHeaderDecode(bbffr, payloadPtr);
+}
+
+
+/**
+ *  @brief STATIC Scope: Decode a record header at a buffer position, advancing the position to the payload. Returns payload length.
+ */
+static bbffrSz_t recordHeaderDecode(bbuffer_t *bbffr, char **recordPtr)
+{
+    char *ptr = *recordPtr;
+    bbffrSz_t recordSz = 0;
+
+    for (uint8_t shift = 0; shift < 7 * RECORD_HDRMAX; shift += 7)
+    {
+        uint8_t hdrChar = (uint8_t)*ptr;
+        ptr = advancePtr(bbffr, ptr, 1);
+        recordSz |= (bbffrSz_t)(hdrChar & 0x7F) << shift;
+        if ((hdrChar & 0x80) == 0)
+            break;
+    }
+    *recordPtr = ptr;
+    return recordSz;
+}
+
+
+/**
+ *  @brief STATIC Scope: Overwrite mode producer, discard oldest chars (whole records for overwriteRecords) until needSz
+ *  chars are vacant. Returns the tail the producer may fill up to.
+ *  @details Tail is shared with the consumer here, so it moves by compare-and-swap inside an odd overwriteSeq window.
+ *  If the consumer moves tail first the window is undone, overwriteSeq only ever advances by whole discards.
+ */
+static char *overwriteVacate(bbuffer_t *bbffr, char *head, bbffrSz_t needSz)
+{
+    char *tail = BBFFR_LOAD_ACQ(bbffr->tail);
+
+    while (BBFFR_VACANT(head, tail) < needSz)
+    {
+        char *newTail = tail;
+        uint16_t recordCnt = 0;
+        if (bbffr->options & bbffrOption_overwriteRecords)
+        {
+            while (BBFFR_VACANT(head, newTail) < needSz)                    // records between tail and head are complete
+            {
+                bbffrSz_t recordSz = recordHeaderDecode(bbffr, &newTail);
+                newTail = advancePtr(bbffr, newTail, recordSz);
+                recordCnt++;
+            }
+        }
+        else
+            newTail = advancePtr(bbffr, tail, needSz - BBFFR_VACANT(head, tail));
+
+        uint32_t seq = bbffr->overwriteSeq;
+        __atomic_store_n(&bbffr->overwriteSeq, seq + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);                            // odd seq visible before tail moves
+        if (__atomic_compare_exchange_n(&bbffr->tail, &tail, newTail, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        {
+            BBFFR_STORE_REL(bbffr->overwriteSeq, seq + 2);                  // chars are rewritten only behind the new tail
+            BBFFR_STAT_ADD(bbffr->stats.overruns, 1);
+            BBFFR_STAT_ADD(bbffr->stats.overwrittenBytes, BBFFR_OCCUPIED(newTail, tail));
+            BBFFR_STORE_REL(bbffr->recordsDiscarded, bbffr->recordsDiscarded + recordCnt);
+            tail = newTail;
+        }
+        else
+            BBFFR_STORE_REL(bbffr->overwriteSeq, seq);                      // consumer moved tail first (reloaded), nothing discarded
+    }
+    return tail;
+}
+
+
+/**
+ *  @brief STATIC Scope: Overwrite mode consumer read (copy to dest, or skip if dest is NULL) of chars or a whole record.
+ *  Returns chars/payload length read; for a record 0 if none is available or it is larger than requestSz.
+ *  @details Seqlock style: the copy is kept only if overwriteSeq was even and unchanged across it, then tail is claimed
+ *  by compare-and-swap so a discard racing the claim forces a retry. A read that lands inside the producer's (brief) odd
+ *  window returns 0 rather than spin, the producer may be an ISR that the consumer has interrupted.
+ */
+static bbffrSz_t overwriteRead(bbuffer_t *bbffr, char *dest, bbffrSz_t requestSz, bool record, bool consume)
+{
+    char *tail;
+    char *newTail;
+    bbffrSz_t readCnt;
+    uint32_t seq;
+
+    for (;;)
+    {
+        seq = BBFFR_LOAD_ACQ(bbffr->overwriteSeq);
+        if (seq & 0x01)
+            return 0;
+        tail = BBFFR_LOAD_ACQ(bbffr->tail);                                 // producer moves tail when it overwrites
+        char *head = BBFFR_LOAD_ACQ(bbffr->head);
+        bbffrSz_t occupied = BBFFR_OCCUPIED(head, tail);
+        char *readPtr = tail;
+        bool fits = true;
+
+        readCnt = MIN(requestSz, occupied);
+        if (record)
+        {
+            readCnt = 0;
+            if (occupied > 0)                                               // only complete records are published
+            {
+                bbffrSz_t recordSz = recordHeaderDecode(bbffr, &readPtr);
+                bbffrSz_t headerSz = BBFFR_OCCUPIED(readPtr, tail);
+                fits = (recordSz <= requestSz);
+                readCnt = fits ? MIN(recordSz, occupied - MIN(headerSz, occupied)) : 0;     // clamp only matters when overrun
+            }
+        }
+        newTail = (dest != NULL) ? copyOut(bbffr, readPtr, dest, readCnt) : advancePtr(bbffr, readPtr, readCnt);
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);                            // chars read before the seq re-check
+        if (__atomic_load_n(&bbffr->overwriteSeq, __ATOMIC_RELAXED) != seq)
+            continue;                                                       // overwritten while reading, retry at new tail
+        if (!consume || !fits)
+            break;
+        if (__atomic_compare_exchange_n(&bbffr->tail, &tail, newTail, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        {
+            BBFFR_STORE_REL(bbffr->rTail, tail);                            // rTail trails producer discards, bytesOut counts this read only
+            releaseTail(bbffr, newTail);
+            if (record && readCnt > 0)
+                BBFFR_STORE_REL(bbffr->recordsOut, bbffr->recordsOut + 1);
+            break;
+        }
+    }
+
+    if (seq != bbffr->overwriteSeqSeen)                                     // discards since the previous read, ahead of this one
+    {
+        bbffr->overrun = true;
+        bbffr->overwriteSeqSeen = seq;
+    }
+    return readCnt;
+}
+
+
+/**
+ *  @brief STATIC Scope: Copy chars into the buffer at a position, splitting at the buffer wrap. Returns the position following the copy.
+ */
+static char *copyIn(bbuffer_t *bbffr, char *bffrPtr, const char *src, bbffrSz_t copyCnt)
+{
+    bbffrSz_t rightCnt = MIN(copyCnt, BBFFR_TOEDGE(bffrPtr));
+
+    memcpy(bffrPtr, src, rightCnt);                                         // 1st copy: right-side of buffer (position to end)
+    memcpy(bbffr->buffer, src + rightCnt, copyCnt - rightCnt);              // 2nd copy: left-side of buffer, remainder (if any)
+    return advancePtr(bbffr, bffrPtr, copyCnt);
+}
+
+
+/**
+ *  @brief STATIC Scope: Copy chars out of the buffer from a position, splitting at the buffer wrap. Returns the position following the copy.
+ */
+static char *copyOut(bbuffer_t *bbffr, const char *bffrPtr, char *dest, bbffrSz_t copyCnt)
+{
+    bbffrSz_t rightCnt = MIN(copyCnt, BBFFR_TOEDGE(bffrPtr));
+
+    memcpy(dest, bffrPtr, rightCnt);                                        // get right-side of buffer
+    memcpy(dest + rightCnt, bbffr->buffer, copyCnt - rightCnt);             // get left-side of buffer (if wrapped)
+    return advancePtr(bbffr, (char*)bffrPtr, copyCnt);
+}
+
+
+/**
+ *  @brief STATIC Scope: Aligned mode, trim a block (at blockStart) to end on an alignSz boundary.
+ *  @details A block with no boundary within it is 0 (producer), or returned untrimmed if partialOk (consumer, data ends 
+ *  at head). The buffer edge is always a boundary.
+ */
+static bbffrSz_t alignBlock(bbuffer_t *bbffr, char *blockStart, bbffrSz_t blockSz, bool partialOk)
+{
+    if (!(bbffr->options & bbffrOption_aligned))
+        return blockSz;
+
+    bbffrSz_t trimCnt = (bbffrSz_t)((blockStart - bbffr->buffer) + blockSz) & (bbffr->alignSz - 1);
+    if (trimCnt < blockSz)
+        return blockSz - trimCnt;
+    return partialOk ? blockSz : 0;
+}
+
+
+/**
+ *  @brief STATIC Scope: Reverse chars in [start, end), building block of the in-place rotation in bbffr_linearize().
+ */
+static void reverseChars(char *start, char *end)
+{
+    while (start < --end)
+    {
+        char swap = *start;
+        *start++ = *end;
+        *end = swap;
+    }
+}
 
+#pragma endregion
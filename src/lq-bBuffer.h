@@ -32,8 +32,90 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+/* Buffer size/offset width. Default is 16-bit for embedded targets (buffer max 64KB); define BBFFR_LARGE (ex: -DBBFFR_LARGE)
+ * for 32-bit sizes on a Linux host streaming multi-MB data. Both widths build from the same implementation.
+ */
+#if defined(BBFFR_LARGE)
+    typedef uint32_t bbffrSz_t;                             ///< Buffer sizes, counts and offsets from tail
+    typedef int32_t bbffrOffset_t;                          ///< Signed search offset (from tail or head)
+    typedef uint64_t bbffrMpscState_t;                      ///< Packed multi-producer reservation state (sequence, offset)
+#else
+    typedef uint16_t bbffrSz_t;
+    typedef int16_t bbffrOffset_t;
+    typedef uint32_t bbffrMpscState_t;
+#endif
+
+/**
+ * @brief Block buffer options, set at initialization.
+ */
+typedef enum bbffrOption_tag
+{
+    bbffrOption_none = 0x00,
+    bbffrOption_mirrored = 0x01,                            ///< Storage is mapped twice back-to-back (Linux host), any region is contiguous
+    bbffrOption_overwrite = 0x02,                           ///< Full buffer discards oldest chars to make room, see bbffr_initOverwrite()
+    bbffrOption_overwriteRecords = 0x04,                    ///< Overwrite discards whole records (with bbffrOption_overwrite)
+    bbffrOption_aligned = 0x08                              ///< Block operations end on alignSz boundaries, see bbffr_initAligned()
+} bbffrOption_t;
+
+
+/**
+ * @brief Watermark crossing reported to a bbffrWatermark_func callback.
+ */
+typedef enum bbffrWatermark_tag
+{
+    bbffrWatermark_high = 1,                                ///< Occupancy rose to/above the high watermark (fired in producer context)
+    bbffrWatermark_low = 2                                  ///< Occupancy fell to/below the low watermark after a high (fired in consumer context)
+} bbffrWatermark_t;
+
+struct bbuffer_tag;
+typedef void (*bbffrWatermark_func)(struct bbuffer_tag *bbffr, bbffrWatermark_t watermark, bbffrSz_t occupied);
+
+
+/**
+ * @brief Block buffer instrumentation counters, see bbffr_getStats(). Counters are free running (wrap at 2^32).
+ */
+typedef struct bbffrStats_tag
+{
+    uint32_t bytesIn;                                       ///< Chars published by the producer
+    uint32_t bytesOut;                                      ///< Chars consumed
+    uint32_t truncatedPushes;                               ///< push/pushv/pushRecord calls that could not push all chars
+    uint32_t droppedBytes;                                  ///< Chars not pushed by truncated pushes
+    uint32_t overruns;                                      ///< Overwrite mode: times the producer discarded unread chars
+    uint32_t overwrittenBytes;                              ///< Overwrite mode: unread chars discarded
+    bbffrSz_t peakOccupied;                                 ///< Highest occupancy seen after a push
+    bbffrSz_t occupied;                                     ///< Occupancy at time of snapshot
+} bbffrStats_t;
+
+
+#ifndef BBFFR_CHECKPOINTS
+    #define BBFFR_CHECKPOINTS 4                             ///< Max nesting of consumer transactions (checkpoint stack depth)
+#endif
+
+/**
+ * @brief Consumer transaction checkpoint, see bbffr_startTransaction().
+ */
+typedef struct bbffrCheckpoint_tag
+{
+    char *tail;                                             ///< Tail at transaction start, restored on rollback
+    uint16_t recordsOut;                                    ///< Records consumed at transaction start
+} bbffrCheckpoint_t;
+
+
 /**
  * @brief Internal control structure for a block buffer.
+ * @details The buffer is safe for one producer context and one consumer context operating concurrently (ex: ISR pushing 
+ * while the main loop pops) without critical sections. The producer owns head: push, pushBlock, skipHead. The consumer
+ * owns tail: pop, popBlock, peek, find, skipTail. Each side reads the other side's index once per call (acquire) and 
+ * publishes its own index only after the data copy is complete (release).
+ * 
+ * Transactions (see bbffr_startTransaction()) let the consumer read ahead speculatively and rewind. The producer's limit
+ * is rTail, the outermost transaction's checkpoint (or tail when none), so checkpointed chars are never overwritten.
+ * 
+ * Record mode frames the stream into whole messages (varint length header + payload), see bbffr_pushRecord(). A buffer
+ * used for records should only be written/read with the record functions.
+ * 
+ * Overwrite mode (see bbffr_initOverwrite()) lets the producer advance tail itself, the consumer's copying reads (pop, 
+ * popv, peek, skipTail, popRecord, skipRecord) re-check overwriteSeq after copying and retry if they were overrun.
  */
 typedef struct bbuffer_tag
 {
@@ -42,12 +124,170 @@ typedef struct bbuffer_tag
 
     char * volatile head;                                   ///< Pointer to the head position, where new char are logically ADDED to the buffer (pushed to)
     char * volatile tail;                                   ///< Pointer to the tail position, where char are logically REMOVED from the buffer (popped from)
-    char * volatile rbHead;                                 ///< Pointer stash for possible rollback of head from a pushBlock operation
-    char * volatile pTail;                                  ///< Pointer stash for possible rollback of tail from a popBlock operation
+    char * volatile pHead;                                  ///< Pointer stash for pending head from a pushBlock operation, published on commit
+    char * volatile pTail;                                  ///< Pointer stash for pending tail from a popBlock operation, published on commit
+    char * volatile rTail;                                  ///< Released tail, producer fills up to here: tail or outermost transaction checkpoint
+    bbffrCheckpoint_t checkpoints[BBFFR_CHECKPOINTS];       ///< Consumer transaction stack
+    uint8_t checkpointCnt;                                  ///< Open (nested) transactions
+    volatile uint16_t recordsIn;                            ///< Record mode: records published by producer (free running)
+    volatile uint16_t recordsOut;                           ///< Record mode: records consumed (free running)
+    volatile uint16_t recordsDiscarded;                     ///< Record mode: records overwritten by producer (free running)
+    bbffrSz_t pRecordRemain;                                ///< Record mode: payload chars still to append to the pending record
+    bool pRecord;                                           ///< Record mode: pending pushBlock allocation is a record
+    bbffrStats_t stats;                                     ///< Instrumentation; producer and consumer each write only their own counters
+    bbffrWatermark_func watermarkCB;                        ///< Flow-control callback, NULL if watermarks not set
+    bbffrSz_t highMark;                                     ///< Occupancy firing bbffrWatermark_high
+    bbffrSz_t lowMark;                                      ///< Occupancy firing bbffrWatermark_low
+    volatile uint16_t highCnt;                              ///< High watermarks fired (producer), above high while highCnt != lowCnt
+    volatile uint16_t lowCnt;                               ///< Low watermarks fired (consumer)
+    volatile uint32_t overwriteSeq;                         ///< Overwrite mode: odd while the producer moves tail, +2 per discard
+    uint32_t overwriteSeqSeen;                              ///< Overwrite mode: overwriteSeq at the consumer's last read
+    bool overrun;                                           ///< Overwrite mode: a read found chars discarded ahead of it, see bbffr_checkOverrun()
+    bbffrSz_t alignSz;                                      ///< Aligned mode: block granule (power of 2), 0 if not aligned
+    uint8_t options;                                        ///< Buffer options (bbffrOption_t bits)
 } bbuffer_t;
 
 
-#define BBFFR_NOTFOUND 0xFFFF                               ///< Value returned from a buffer find operation signalling NOT FOUND
+/**
+ * @brief A contiguous region (pointer/length) within a buffer or caller memory; iovec-style.
+ */
+typedef struct bbffrSpan_tag
+{
+    char *ptr;                                              ///< Start of the region
+    bbffrSz_t len;                                          ///< Length of the region in chars
+} bbffrSpan_t;
+
+
+/**
+ * @brief Options for bbffr_popUntil(), may be combined.
+ */
+typedef enum bbffrUntilFlag_tag
+{
+    bbffrUntilFlag_none = 0x00,                             ///< Delimiter is left in the buffer (at tail)
+    bbffrUntilFlag_consumeDelim = 0x01,                     ///< Delimiter is removed from the buffer, not copied
+    bbffrUntilFlag_includeDelim = 0x02,                     ///< Delimiter is removed from the buffer and copied to dest
+    bbffrUntilFlag_requireDelim = 0x04                      ///< Pop nothing unless the delimiter is found (whole fields/lines only)
+} bbffrUntilFlag_t;
+
+
+/**
+ * @brief Outcome of a bbffr_popUntil().
+ */
+typedef enum bbffrUntil_tag
+{
+    bbffrUntil_notFound = 0,                                ///< Delimiter not in buffer (yet), chars popped (if any) are a partial field
+    bbffrUntil_found = 1,                                   ///< Delimiter found, chars popped are a complete field
+    bbffrUntil_destFull = 2                                 ///< Destination filled before a delimiter was found
+} bbffrUntil_t;
+
+
+/**
+ * @brief Outcome of a bbffr_readFromFd() or bbffr_writeToFd() transfer.
+ */
+typedef enum bbffrIo_tag
+{
+    bbffrIo_ok = 0,                                         ///< Transferred, count may be partial (0 if buffer was full/empty)
+    bbffrIo_wouldBlock = 1,                                 ///< Non-blocking descriptor not ready (EAGAIN/EWOULDBLOCK), nothing transferred
+    bbffrIo_eof = 2,                                        ///< Read found end of file (peer closed), nothing transferred
+    bbffrIo_error = 3                                       ///< Descriptor error, see errno; nothing transferred
+} bbffrIo_t;
+
+
+/**
+ * @brief A search needle prepared once for repeated bbffr_findCompiled() searches (Horspool skip table).
+ * @note The needle c-string is referenced, not copied; it must remain in scope while the compiled needle is used.
+ */
+typedef struct bbffrNeedle_tag
+{
+    const char *needle;                                     ///< The needle c-string
+    bbffrSz_t needleLen;                                    ///< Length of needle
+    uint8_t skip[256];                                      ///< Window shift by window's last char value
+} bbffrNeedle_t;
+
+
+/**
+ * @brief Incremental search context for streaming input, see bbffr_searchNext().
+ */
+typedef struct bbffrSearch_tag
+{
+    const bbffrNeedle_t *needle;                            ///< The compiled needle being searched for
+    char *resumePtr;                                        ///< Buffer position of the first needle-start candidate not yet ruled out
+} bbffrSearch_t;
+
+
+#ifndef BBFFR_MATCHER_MAXSTATES
+    #define BBFFR_MATCHER_MAXSTATES 48                      ///< Max automaton states (1 + total pattern chars, less shared prefixes), max 255
+#endif
+#ifndef BBFFR_MATCHER_MAXCLASSES
+    #define BBFFR_MATCHER_MAXCLASSES 24                     ///< Max distinct chars across all patterns + 1 
+#endif
+#ifndef BBFFR_MATCHER_MAXPATTERNS
+    #define BBFFR_MATCHER_MAXPATTERNS 8                     ///< Max patterns in a matcher
+#endif
+
+/**
+ * @brief Multi-pattern matcher (Aho-Corasick automaton) for bbffr_findAny(). Built once from a pattern table.
+ * @details The automaton is a complete state table over a compressed alphabet (chars present in the patterns + "other"),
+ * so searching is one table lookup per buffer char regardless of pattern count. Sizes are set by the BBFFR_MATCHER_x 
+ * defines; with defaults the structure is about 1.5KB.
+ */
+typedef struct bbffrMatcher_tag
+{
+    uint8_t classMap[256];                                  ///< Char value to alphabet class, class 0 is any char not in a pattern
+    uint8_t next[BBFFR_MATCHER_MAXSTATES][BBFFR_MATCHER_MAXCLASSES];   ///< State transitions by class
+    uint8_t output[BBFFR_MATCHER_MAXSTATES];                ///< Pattern (index + 1) of longest pattern ending at state, 0 if none
+    uint8_t patternLens[BBFFR_MATCHER_MAXPATTERNS];         ///< Length of each pattern
+    uint8_t maxPatternLen;                                  ///< Length of longest pattern
+    uint8_t minPatternLen;                                  ///< Length of shortest pattern
+} bbffrMatcher_t;
+
+
+#ifndef BBFFR_MPSC_SLOTS
+    #define BBFFR_MPSC_SLOTS 8                              ///< Max reservations in flight (reserved, not yet published) for a MPSC buffer
+#endif
+#ifndef BBFFR_MPSC_VOIDS
+    #define BBFFR_MPSC_VOIDS 8                              ///< Max void regions published but not yet skipped by the consumer
+#endif
+
+/**
+ * @brief A producer's region of buffer reserved by bbffr_mpscReserve().
+ */
+typedef struct bbffrReservation_tag
+{
+    char *ptr;                                              ///< Start of the reserved region, producer fills from here
+    bbffrSz_t len;                                          ///< Length of reserved region
+    uint16_t seq;                                           ///< Reservation sequence number (internal)
+} bbffrReservation_t;
+
+
+/**
+ * @brief Multi-producer/single-consumer control for a block buffer, see bbffr_mpscInit().
+ * @details Producers claim regions with a compare-and-swap on reserveState and fill them in parallel. Finalized regions
+ * are published to the buffer head in reservation order by whichever producer finds the publisher free; no producer
+ * ever waits on another. Requires 32-bit compare-and-swap (ESP32, Linux host).
+ */
+typedef struct bbffrMpsc_tag
+{
+    bbuffer_t *bbffr;                                       ///< The buffer being fed
+    volatile bbffrMpscState_t reserveState;                 ///< (next sequence << offset bits) | buffer offset of next reservation
+    volatile uint32_t publishLock;                          ///< Non-zero while a producer is advancing head
+    volatile uint16_t publishSeq;                           ///< Sequence of the oldest reservation not yet published
+    volatile uint16_t voidIn;                               ///< Void regions recorded by the publisher
+    volatile uint16_t voidOut;                              ///< Void regions skipped by the consumer
+    struct
+    {
+        bbffrSz_t len;                                      ///< Length of the reservation using the slot
+        volatile uint32_t mark;                             ///< (sequence << 2) | finalize state, set at finalize
+    } slots[BBFFR_MPSC_SLOTS];
+    struct
+    {
+        bbffrSz_t offset;                                   ///< Buffer offset of the void region
+        bbffrSz_t len;                                      ///< Length of the void region
+    } voids[BBFFR_MPSC_VOIDS];
+} bbffrMpsc_t;
+
+
+#define BBFFR_NOTFOUND ((bbffrSz_t)-1)                      ///< Value returned from a buffer find operation signalling NOT FOUND
 #define BBFFR_ISFOUND(x) (x != BBFFR_NOTFOUND)              ///< Convenience macro, returns True if search target is FOUND
 #define BBFFR_ISNOTFOUND(x) (x == BBFFR_NOTFOUND)           ///< Convenience macro, returns True if search target is NOT FOUND
 
@@ -64,7 +304,74 @@ extern "C"
  * @param rawBuffer 
  * @param bufferSz 
  */
-void bbffr_init(bbuffer_t *cbffr, char * rawBuffer, uint16_t bufferSz);
+void bbffr_init(bbuffer_t *cbffr, char * rawBuffer, bbffrSz_t bufferSz);
+
+
+#if defined(__linux__)
+/**
+ * @brief Initialize a buffer with virtually mirrored storage (Linux host builds).
+ * @details The buffer's physical pages are mapped twice back-to-back, so any occupied or vacant region starting within 
+ * the buffer is addressable as one contiguous span. pushBlock/popBlock return the full request (up to vacant/occupied)
+ * and find/peek/push/pop never split at the wrap. Storage is allocated by this call, release with bbffr_releaseMirrored().
+ * 
+ * @param cbffr The buffer control structure to initialize.
+ * @param bufferSz Size of buffer, must be a multiple of the system page size.
+ * @return true if the mirrored mapping was created, false otherwise (buffer is not initialized).
+ */
+bool bbffr_initMirrored(bbuffer_t *cbffr, bbffrSz_t bufferSz);
+
+
+/**
+ * @brief Release the storage of a buffer created by bbffr_initMirrored().
+ * 
+ * @param cbffr The buffer to release.
+ */
+void bbffr_releaseMirrored(bbuffer_t *cbffr);
+#endif
+
+
+/**
+ * @brief Initialize a lossy buffer that keeps the newest chars: a push into a full buffer discards the oldest chars.
+ * @details Intended for rolling telemetry/trace windows (ex: last 8KB of modem traffic). The producer advances tail 
+ * over unread chars, counting them in stats.overwrittenBytes, so pushes never block on occupancy; a single push larger
+ * than capacity still truncates. The consumer reads with pop, popv, peek, skipTail (or popRecord, skipRecord) which 
+ * retry if overrun mid-copy, and detects lost data with bbffr_checkOverrun(). In-place consumer access (popBlock, 
+ * peekSpans, peekRecord, the find and search functions, popUntil, popLine, linearize, transactions, writeToFd) and MPSC
+ * reservations are not overrun safe, they ASSERT on an overwrite mode buffer.
+ * 
+ * @param cbffr [in] The buffer control structure to initialize.
+ * @param rawBuffer [in] Storage for the buffer.
+ * @param bufferSz [in] Size of rawBuffer.
+ * @param recordBoundary [in] Buffer holds records (bbffr_pushRecord()), discard whole records only.
+ */
+void bbffr_initOverwrite(bbuffer_t *cbffr, char *rawBuffer, bbffrSz_t bufferSz, bool recordBoundary);
+
+
+/**
+ * @brief Initialize a buffer for DMA, pushBlock()/popBlock() regions end on alignSz boundaries (word or burst size).
+ * @details Block length is rounded down so the block ends on a boundary. A pushBlock() with no boundary in reach grants
+ * 0, as one char is always kept vacant the last granule before the tail can't be granted until the consumer moves 
+ * past it. A popBlock() with no boundary in reach is returned unrounded (the consumer is never starved of data ending
+ * at head). The buffer end is always a boundary. Starting from an aligned head/tail, blocks are therefore aligned and 
+ * a multiple of alignSz; after an unaligned push/pop the next block realigns.
+ * 
+ * @param cbffr [in] The buffer control structure to initialize.
+ * @param rawBuffer [in] Storage for the buffer, address aligned to alignSz (ex: __attribute__((aligned(32)))).
+ * @param bufferSz [in] Size of rawBuffer, a multiple of alignSz.
+ * @param alignSz [in] Alignment granule, a power of 2.
+ */
+void bbffr_initAligned(bbuffer_t *cbffr, char *rawBuffer, bbffrSz_t bufferSz, bbffrSz_t alignSz);
+
+
+/**
+ * @brief Consumer: check for an overrun, reads since the last check found unread chars discarded ahead of them.
+ * @details Discards are detected by the read that follows them (a read that finds the buffer empty included), so a 
+ * true result means stream continuity was lost before the first char of one of those reads.
+ * 
+ * @param cbffr [in] The buffer to check.
+ * @return true if the consumer was overrun since the previous call.
+ */
+bool bbffr_checkOverrun(bbuffer_t *cbffr);
 
 
 /**
@@ -81,7 +388,7 @@ void bbffr_reset(bbuffer_t *cbffr);
  * @param cbffr The buffer to report on.
  * @return The number of characters in the buffer.
  */
-uint16_t bbffr_getCapacity(bbuffer_t *cbffr);
+bbffrSz_t bbffr_getCapacity(bbuffer_t *cbffr);
 
 
 /**
@@ -90,7 +397,7 @@ uint16_t bbffr_getCapacity(bbuffer_t *cbffr);
  * @param cbffr The buffer to report on.
  * @return The number of characters in the buffer.
  */
-uint16_t bbffr_getOccupied(bbuffer_t *cbffr);
+bbffrSz_t bbffr_getOccupied(bbuffer_t *cbffr);
 
 
 /**
@@ -99,12 +406,34 @@ uint16_t bbffr_getOccupied(bbuffer_t *cbffr);
  * @param cbffr The buffer to report on.
  * @return The number of free bytes in the buffer.
  */
-uint16_t bbffr_getVacant(bbuffer_t *cbffr);
+bbffrSz_t bbffr_getVacant(bbuffer_t *cbffr);
+
+
+/**
+ * @brief Set flow-control watermarks, callback fires on crossings with hysteresis (high, then low, then high...).
+ * @details High is checked as the producer publishes chars, low as the consumer pops/skips (including pops that find 
+ * the buffer empty), so the callback runs in that side's context and should be brief (ex: set a flag, toggle RTS).
+ * 
+ * @param cbffr [in] The buffer to monitor.
+ * @param highMark [in] Occupancy at or above which bbffrWatermark_high fires.
+ * @param lowMark [in] Occupancy at or below which bbffrWatermark_low fires, must be less than highMark.
+ * @param watermarkCB [in] Callback, NULL to disable watermarks.
+ */
+void bbffr_setWatermarks(bbuffer_t *cbffr, bbffrSz_t highMark, bbffrSz_t lowMark, bbffrWatermark_func watermarkCB);
+
+
+/**
+ * @brief Get a snapshot of the buffer's instrumentation counters.
+ * 
+ * @param cbffr [in] The buffer to report on.
+ * @param stats [out] Snapshot of counters and current occupancy.
+ */
+void bbffr_getStats(bbuffer_t *cbffr, bbffrStats_t *stats);
 
 
 /**
- * @brief Diagnostic method to get information on all cBuffer internal macro values.
- * @note macros char buffer should be at least 128 chars in length
+ * @brief Diagnostic method to get information on all cBuffer internal macro values and counters.
+ * @note macros char buffer should be at least 200 chars in length
  * 
  * @param cbffr The buffer to report on.
  * @param macrosRpt Pointer to character buffer to fill with internal MACRO values info.
@@ -120,12 +449,11 @@ void bbffr_GETMACROS(bbuffer_t *bbffr, char *macrosRpt, uint8_t macrosRptSz);
  * @brief Push a series of characters into buffer at buffer-head and update buffer internals accordingly.
  * 
  * @param cbffr The buffer receiving the characters.
- * @param src 
- * @param requestSz 
- * @return true Buffer was updated with src characters. Only returns true if the full size of src can be accepted.
+ * @param src Pointer to the characters to be pushed.
+ * @param requestSz Number of characters to push.
  * @return Number of characters "pushed"; the lesser of available and requestSz.
  */
-uint16_t bbffr_push(bbuffer_t *cbffr, const char *src, uint16_t requestSz);
+bbffrSz_t bbffr_push(bbuffer_t *cbffr, const char *src, bbffrSz_t requestSz);
 
 
 /**
@@ -136,12 +464,13 @@ uint16_t bbffr_push(bbuffer_t *cbffr, const char *src, uint16_t requestSz);
  * @param requestSz [in] Requested (contiguous) space in buffer.
  * @return Number of characters available to be pushed; the lesser of contiguous vacant and requestSz.
  */
-uint16_t bbffr_pushBlock(bbuffer_t *cbffr, char **copyTo, uint16_t requestSz);
+bbffrSz_t bbffr_pushBlock(bbuffer_t *cbffr, char **copyTo, bbffrSz_t requestSz);
 
 
 /**
  * @brief Commit or rollback a pending push block. 
  * @details Required for complete a pushBlock() operation, pushBlock is blocking to additional buffer pushes until finalized.
+ * The pushed block is not visible to the consumer until committed.
  * 
  * @param cbffr [in] The buffer to be operated on.
  * @param commit [in] Commit pending push block (true) or roll-back pending push (false).
@@ -149,6 +478,66 @@ uint16_t bbffr_pushBlock(bbuffer_t *cbffr, char **copyTo, uint16_t requestSz);
 void bbffr_pushBlockFinalize(bbuffer_t *cbffr, bool commit);
 
 
+/**
+ * @brief Attach multi-producer control to a buffer. Producers then use only bbffr_mpscReserve()/bbffr_mpscFinalize(), 
+ * the consumer reads with bbffr_mpscPop(), or limits other consumer reads to bbffr_mpscReadable() chars.
+ * 
+ * @param mpsc [out] The MPSC control structure.
+ * @param cbffr [in] The buffer to feed, should be empty with no pending pushBlock.
+ */
+void bbffr_mpscInit(bbffrMpsc_t *mpsc, bbuffer_t *cbffr);
+
+
+/**
+ * @brief Reserve a contiguous region at the reservation head for a producer to fill; safe from multiple concurrent producers.
+ * @details Like pushBlock(), the region is contiguous. Reserved data is invisible to the consumer until it, and every
+ * reservation before it, is finalized. A request that does not fit before buffer-wrap, but fits better at the buffer 
+ * start, is granted there; the chars skipped at the wrap are published as void (uses 2 slots). Otherwise the grant is 
+ * the lesser of requestSz and the contiguous vacant space.
+ * 
+ * @param mpsc [in] The MPSC control.
+ * @param resv [out] The reservation, fill resv->ptr for resv->len chars.
+ * @param requestSz [in] Requested (contiguous) space.
+ * @return Number of chars reserved (resv->len), 0 if no space or BBFFR_MPSC_SLOTS reservations are already in flight.
+ */
+bbffrSz_t bbffr_mpscReserve(bbffrMpsc_t *mpsc, bbffrReservation_t *resv, bbffrSz_t requestSz);
+
+
+/**
+ * @brief Commit or rollback a reservation; reservations may be finalized in any order.
+ * @details Rollback returns the space if no later reservation exists. Otherwise the region is published as void, the
+ * consumer never sees it: bbffr_mpscReadable()/bbffr_mpscPop() skip it. If BBFFR_MPSC_VOIDS void regions are waiting
+ * for the consumer, publishing pauses at the next void until the consumer skips one.
+ * 
+ * @param mpsc [in] The MPSC control.
+ * @param resv [in] The reservation to finalize.
+ * @param commit [in] Commit (true) or roll-back (false) the reservation.
+ * @return true if committed; false if rolled back.
+ */
+bool bbffr_mpscFinalize(bbffrMpsc_t *mpsc, bbffrReservation_t *resv, bool commit);
+
+
+/**
+ * @brief Consumer: skip any void regions at buffer tail and get the count of chars readable before the next void.
+ * @details Any consumer read (pop, popBlock, find, skipTail) is valid for up to the returned count of chars.
+ * 
+ * @param mpsc [in] The MPSC control.
+ * @return Number of chars readable at tail, 0 if none.
+ */
+bbffrSz_t bbffr_mpscReadable(bbffrMpsc_t *mpsc);
+
+
+/**
+ * @brief Consumer: pop chars from a multi-producer buffer, void regions are skipped.
+ * 
+ * @param mpsc [in] The MPSC control.
+ * @param dest [out] Pointer to char array to receive popped chars.
+ * @param requestSz [in] The number of chars requested.
+ * @return Number of chars popped, the lesser of requestSz and committed chars available.
+ */
+bbffrSz_t bbffr_mpscPop(bbffrMpsc_t *mpsc, char *dest, bbffrSz_t requestSz);
+
+
 /**
  * @brief Pop a number of chars from buffer at buffer-tail. Number of characters "popped" will be the lesser of available and requestSz.
  * 
@@ -157,7 +546,7 @@ void bbffr_pushBlockFinalize(bbuffer_t *cbffr, bool commit);
  * @param requestSz Number of chars requested from the buffer.
  * @return Number of characters "popped"; the lesser of available and requestSz.
  */
-uint16_t bbffr_pop(bbuffer_t *cbffr, char *dest, uint16_t requestSz);
+bbffrSz_t bbffr_pop(bbuffer_t *cbffr, char *dest, bbffrSz_t requestSz);
 
 
 /**
@@ -169,7 +558,7 @@ uint16_t bbffr_pop(bbuffer_t *cbffr, char *dest, uint16_t requestSz);
  * @param requestSz [in] Number of chars requested from the buffer.
  * @return Number of characters available to be popped; the lesser of occupied and requestSz.
  */
-uint16_t bbffr_popBlock(bbuffer_t *cbffr, char **copyFrom, uint16_t requestSz);
+bbffrSz_t bbffr_popBlock(bbuffer_t *cbffr, char **copyFrom, bbffrSz_t requestSz);
 
 
 /**
@@ -188,9 +577,199 @@ void bbffr_popBlockFinalize(bbuffer_t *cbffr, bool commit);
  * @param cbffr The buffer sourcing the characters.
  * @param dest Pointer to memory location where peeked chars are copied.
  * @param requestSz Number of chars requested from the buffer.
- * @return uint16_t Number of characters "peeked" (the lesser of available and requestSz).
+ * @return bbffrSz_t Number of characters "peeked" (the lesser of available and requestSz).
+ */
+bbffrSz_t bbffr_peek(bbuffer_t *cbffr, char *dest, bbffrSz_t requestSz);
+
+
+/**
+ * @brief Zero-copy peek, describe the occupied region starting at buffer-tail as at most two spans.
+ * @details spans[0] is the right-side (tail toward buffer end), spans[1] the left-side (buffer start toward head) when
+ * the occupied region wraps. Data stays in the buffer: parse in place, then consume with bbffr_skipTail().
+ * 
+ * @param cbffr [in] The buffer sourcing the characters.
+ * @param spans [out] Array of 2 spans to describe the occupied region; unused spans are set to NULL/0.
+ * @param requestSz [in] Number of chars requested, spans cover the lesser of occupied and requestSz.
+ * @return Number of spans populated (0, 1 or 2).
  */
-uint16_t bbffr_peek(bbuffer_t *cbffr, char *dest, uint16_t requestSz);
+uint8_t bbffr_peekSpans(bbuffer_t *cbffr, bbffrSpan_t spans[2], bbffrSz_t requestSz);
+
+
+/**
+ * @brief Zero-copy push, describe the vacant region starting at buffer-head as at most two spans.
+ * @details spans[0] is the right-side (head toward buffer end), spans[1] the left-side (buffer start toward tail) when
+ * the vacant region wraps. Fill in place, then publish with bbffr_skipHead(); nothing is visible to the consumer until
+ * then, so a producer can abandon a partly written message by not publishing it. Overwrite mode does not discard for
+ * spans, only the vacant region is described.
+ * 
+ * @param cbffr [in] The buffer receiving the characters.
+ * @param spans [out] Array of 2 spans to describe the vacant region; unused spans are set to NULL/0.
+ * @param requestSz [in] Number of chars requested, spans cover the lesser of vacant and requestSz.
+ * @return Number of spans populated (0, 1 or 2).
+ */
+uint8_t bbffr_pushSpans(bbuffer_t *cbffr, bbffrSpan_t spans[2], bbffrSz_t requestSz);
+
+
+/**
+ * @brief Gather push, push the concatenation of several source spans into buffer at buffer-head as one operation.
+ * 
+ * @param cbffr The buffer receiving the characters.
+ * @param srcv Array of source spans, pushed in order.
+ * @param srcCnt Number of spans in srcv.
+ * @return Number of characters "pushed"; the lesser of available and the total of srcv lengths.
+ */
+bbffrSz_t bbffr_pushv(bbuffer_t *cbffr, const bbffrSpan_t *srcv, uint8_t srcCnt);
+
+
+/**
+ * @brief Scatter pop, pop chars from buffer-tail filling several destination spans in order as one operation.
+ * @details On an overwrite mode buffer each span is a separate overrun safe pop, chars the producer discards between
+ * spans are reported by bbffr_checkOverrun().
+ * 
+ * @param cbffr The buffer sourcing the characters.
+ * @param destv Array of destination spans, filled in order.
+ * @param destCnt Number of spans in destv.
+ * @return Number of characters "popped"; the lesser of occupied and the total of destv lengths.
+ */
+bbffrSz_t bbffr_popv(bbuffer_t *cbffr, const bbffrSpan_t *destv, uint8_t destCnt);
+
+
+/**
+ * @brief Pop chars from buffer-tail up to the first of a set of delimiter chars, scanning and copying in a single pass.
+ * @details Replaces the find(), pop(), skipTail() sequence. A single char delimiter set is scanned with memchr().
+ * 
+ * @param cbffr [in] The buffer sourcing the characters.
+ * @param delimSet [in] C-string of delimiter chars, any one ends the field (ex: "\n" or ",;").
+ * @param dest [out] Destination for the field (not NUL terminated).
+ * @param destSz [in] Size of dest.
+ * @param flags [in] Delimiter handling, bbffrUntilFlag_t values OR'd together.
+ * @param result [out] Optional (may be NULL), reports if the delimiter was found or dest filled.
+ * @return Number of chars copied to dest.
+ */
+bbffrSz_t bbffr_popUntil(bbuffer_t *cbffr, const char *delimSet, char *dest, bbffrSz_t destSz, uint8_t flags, bbffrUntil_t *result);
+
+
+/**
+ * @brief Pop one complete '\n' terminated line (CR/LF or LF) as a c-string; line ending is consumed and not copied.
+ * 
+ * @param cbffr [in] The buffer sourcing the characters.
+ * @param dest [out] Destination for the line, NUL terminated.
+ * @param destSz [in] Size of dest, including the NUL terminator.
+ * @return Length of the line; BBFFR_NOTFOUND if no complete line is available or it does not fit in dest (nothing popped,
+ * drain an over-long line with bbffr_popUntil()).
+ */
+bbffrSz_t bbffr_popLine(bbuffer_t *cbffr, char *dest, bbffrSz_t destSz);
+
+
+#if defined(__linux__)
+/**
+ * @brief Read from a file descriptor (socket, pty, pipe) directly into the buffer at buffer-head, one read()/readv() call.
+ * @details The vacant region is passed to the kernel as one span (read()) or two split at buffer-wrap (readv()), no
+ * scratch copy is made. Interrupted calls (EINTR) are retried.
+ * 
+ * @param cbffr [in] The buffer receiving the chars.
+ * @param fd [in] Descriptor to read, blocking or non-blocking.
+ * @param maxSz [in] Max chars to read.
+ * @param result [out] Optional (may be NULL), outcome of the read.
+ * @return Number of chars read into the buffer; the lesser of vacant, maxSz and what the descriptor had available.
+ */
+bbffrSz_t bbffr_readFromFd(bbuffer_t *cbffr, int fd, bbffrSz_t maxSz, bbffrIo_t *result);
+
+
+/**
+ * @brief Write from the buffer at buffer-tail directly to a file descriptor, one write()/writev() call; chars written are popped.
+ * @details The occupied region is passed to the kernel as one or two spans (split at buffer-wrap). A partial write pops
+ * only the chars the descriptor accepted. Not for overwrite mode buffers.
+ * 
+ * @param cbffr [in] The buffer sourcing the chars.
+ * @param fd [in] Descriptor to write, blocking or non-blocking.
+ * @param maxSz [in] Max chars to write.
+ * @param result [out] Optional (may be NULL), outcome of the write.
+ * @return Number of chars written (and popped).
+ */
+bbffrSz_t bbffr_writeToFd(bbuffer_t *cbffr, int fd, bbffrSz_t maxSz, bbffrIo_t *result);
+#endif
+
+
+/**
+ * @brief Push a whole record (length header + payload) into buffer at buffer-head; all or nothing.
+ * @details The header is a varint (7 bits per char, 1-3 chars) so short messages cost a single char of framing.
+ * Records may wrap, the consumer sees a record only once it is complete.
+ * 
+ * @param cbffr [in] The buffer receiving the record.
+ * @param src [in] Record payload.
+ * @param srcSz [in] Payload length, must be greater than 0.
+ * @return true if the record was pushed; false if vacant space is less than header + payload (nothing pushed).
+ */
+bool bbffr_pushRecord(bbuffer_t *cbffr, const char *src, bbffrSz_t srcSz);
+
+
+/**
+ * @brief Start a record that is appended in pieces, space for the whole record is allocated up front.
+ * @details Complete with bbffr_pushRecordAppend() calls then bbffr_pushBlockFinalize(). A commit before recordSz chars 
+ * have been appended is treated as a rollback. Like pushBlock(), further pushes are blocked until finalized.
+ * 
+ * @param cbffr [in] The buffer receiving the record.
+ * @param recordSz [in] Payload length of the record, must be greater than 0.
+ * @return true if the record space was allocated; false if vacant space is less than header + payload.
+ */
+bool bbffr_pushRecordStart(bbuffer_t *cbffr, bbffrSz_t recordSz);
+
+
+/**
+ * @brief Append payload to a record started with bbffr_pushRecordStart().
+ * 
+ * @param cbffr [in] The buffer receiving the record.
+ * @param src [in] Payload chars to append.
+ * @param srcSz [in] Number of chars to append.
+ * @return Number of chars appended; the lesser of srcSz and the record's remaining payload length.
+ */
+bbffrSz_t bbffr_pushRecordAppend(bbuffer_t *cbffr, const char *src, bbffrSz_t srcSz);
+
+
+/**
+ * @brief Pop the next whole record from buffer-tail.
+ * 
+ * @param cbffr [in] The buffer sourcing the record.
+ * @param dest [out] Destination for the record payload.
+ * @param destSz [in] Size of dest.
+ * @return Payload length of the record popped; 0 if no record is available or it is larger than destSz (not popped).
+ */
+bbffrSz_t bbffr_popRecord(bbuffer_t *cbffr, char *dest, bbffrSz_t destSz);
+
+
+/**
+ * @brief Zero-copy peek of the next whole record's payload, as at most two spans (see bbffr_peekSpans()).
+ * @details The record remains in the buffer; consume it with bbffr_skipRecord().
+ * 
+ * @param cbffr [in] The buffer sourcing the record.
+ * @param spans [out] Array of 2 spans describing the payload; unused spans are set to NULL/0.
+ * @return Payload length of the record; 0 if no record is available.
+ */
+bbffrSz_t bbffr_peekRecord(bbuffer_t *cbffr, bbffrSpan_t spans[2]);
+
+
+/**
+ * @brief Discard the next whole record at buffer-tail.
+ * 
+ * @param cbffr [in] The buffer sourcing the record.
+ * @return Payload length of the record discarded; 0 if no record is available.
+ */
+bbffrSz_t bbffr_skipRecord(bbuffer_t *cbffr);
+
+
+/**
+ * @brief Get number of complete records in the buffer, O(1).
+ */
+uint16_t bbffr_getRecordCount(bbuffer_t *cbffr);
+
+
+/**
+ * @brief Get payload length of the next record at buffer-tail, O(1).
+ * 
+ * @return Payload length; 0 if no record is available.
+ */
+bbffrSz_t bbffr_getRecordSize(bbuffer_t *cbffr);
 
 
 /**
@@ -203,9 +782,98 @@ uint16_t bbffr_peek(bbuffer_t *cbffr, char *dest, uint16_t requestSz);
  * @param searchOffset The number of characters to skip forward from tail -OR- skip back from head to start search. If 0: this is ignored and search starts at buffer-tail.
  * @param searchWindowSz The number of chars from search start to examine for find. If 0, count is ignored and searching continues until buffer-head.
  * @param setTail If true, the buffer tail is advanced to the first character of found needle.
- * @return Offset from buffer TAIL to the position of the needle within the buffer. If no find returns CBFFR_NOFIND (UINT16_MAX: 0xFFFF)
+ * @return Offset from buffer TAIL (prior to any setTail) to the position of the needle within the buffer. If no find returns BBFFR_NOTFOUND (max bbffrSz_t)
+ */
+bbffrSz_t bbffr_find(bbuffer_t *cbffr, const char *needle, bbffrOffset_t searchOffset, bbffrSz_t searchWindowSz, bool setTail);
+
+
+/**
+ * @brief Prepare a needle for repeated searches with bbffr_findCompiled(). 
+ * @details Compile frequently polled needles (ex: response terminators) once at startup.
+ * 
+ * @param compiled [out] The compiled needle structure to populate.
+ * @param needle [in] The character sequence to search for (NULL terminated, up to 65535 chars). Referenced, not copied.
+ * @return true if compiled, false if the needle is empty or too long.
+ */
+bool bbffr_compileNeedle(bbffrNeedle_t *compiled, const char *needle);
+
+
+/**
+ * @brief Find a compiled needle in the buffer. Arguments and result are the same as bbffr_find(), with sublinear average search cost.
+ * 
+ * @param cbffr The buffer to be searched.
+ * @param compiled The compiled needle (see bbffr_compileNeedle()).
+ * @param searchOffset The number of characters to skip forward from tail -OR- skip back from head to start search. If 0: search starts at buffer-tail.
+ * @param searchWindowSz The number of chars from search start to examine for find. If 0, searching continues until buffer-head.
+ * @param setTail If true, the buffer tail is advanced to the first character of found needle.
+ * @return Offset from buffer TAIL (prior to any setTail) to the position of the needle within the buffer, or BBFFR_NOTFOUND.
+ */
+bbffrSz_t bbffr_findCompiled(bbuffer_t *cbffr, const bbffrNeedle_t *compiled, bbffrOffset_t searchOffset, bbffrSz_t searchWindowSz, bool setTail);
+
+
+/**
+ * @brief Start (or restart) an incremental search for a compiled needle at the buffer-tail.
+ * 
+ * @param cbffr The buffer to be searched.
+ * @param search [out] The search context to initialize.
+ * @param compiled The compiled needle (see bbffr_compileNeedle()), referenced by the search context.
+ */
+void bbffr_searchInit(bbuffer_t *cbffr, bbffrSearch_t *search, const bbffrNeedle_t *compiled);
+
+
+/**
+ * @brief Continue an incremental search, examining only chars pushed since the previous call.
+ * @details For responses that trickle into the buffer over many pushes, call after each push. The context remembers the
+ * scan position (including a partial needle at buffer-head), so total work is linear in the response length. Pops or 
+ * tail skips that stay short of the scan position are allowed between calls; if chars beyond the scan position are 
+ * consumed, restart with bbffr_searchInit().
+ * 
+ * @param cbffr The buffer to be searched.
+ * @param search The search context.
+ * @param setTail If true, the buffer tail is advanced to the first character of found needle.
+ * @return Offset from the current buffer TAIL (prior to any setTail) to the needle, or BBFFR_NOTFOUND (not yet arrived).
  */
-uint16_t bbffr_find(bbuffer_t *cbffr, const char *needle, int16_t searchOffset, uint16_t searchWindowSz, bool setTail);
+bbffrSz_t bbffr_searchNext(bbuffer_t *cbffr, bbffrSearch_t *search, bool setTail);
+
+
+/**
+ * @brief Build a multi-pattern matcher from a table of patterns.
+ * 
+ * @param matcher [out] The matcher to build.
+ * @param patterns [in] Table of pattern c-strings (ex: ASCII_sOK, "ERROR", "+CME ERROR:", "> "). Each 1 to 255 chars.
+ * @param patternCnt [in] Number of patterns in table, up to BBFFR_MATCHER_MAXPATTERNS.
+ * @return true if built, false if the patterns exceed the matcher's BBFFR_MATCHER_x limits (or a pattern is empty).
+ */
+bool bbffr_buildMatcher(bbffrMatcher_t *matcher, const char * const *patterns, uint8_t patternCnt);
+
+
+/**
+ * @brief Find the earliest occurrence of any of a matcher's patterns in one pass over the buffer.
+ * @details The match starting earliest (nearest tail) is reported; if several patterns start at the same position the
+ * longest is reported. Search range arguments are the same as bbffr_find().
+ * 
+ * @param cbffr The buffer to be searched.
+ * @param matcher The matcher (see bbffr_buildMatcher()).
+ * @param searchOffset The number of characters to skip forward from tail -OR- skip back from head to start search. If 0: search starts at buffer-tail.
+ * @param searchWindowSz The number of chars from search start to examine for find. If 0, searching continues until buffer-head.
+ * @param setTail If true, the buffer tail is advanced to the first character of the match.
+ * @param patternIndx [out] Index (in build table) of the pattern matched. Unchanged if not found.
+ * @return Offset from buffer TAIL (prior to any setTail) to the start of the match, or BBFFR_NOTFOUND.
+ */
+bbffrSz_t bbffr_findAny(bbuffer_t *cbffr, const bbffrMatcher_t *matcher, bbffrOffset_t searchOffset, bbffrSz_t searchWindowSz, bool setTail, uint8_t *patternIndx);
+
+
+/**
+ * @brief Rotate the buffer contents in place so the occupied chars start at the beginning of the buffer storage and 
+ * are NUL terminated, for parsers that need a contiguous c-string.
+ * @details Unwrapped contents are moved with one memmove; wrapped contents with two copies when the vacant gap allows,
+ * else by in-place reversal (no scratch memory). Record framing is preserved. Incremental searches must be restarted.
+ * @note Not safe while the producer is active (head moves), no pending block operation or transaction may be open.
+ * 
+ * @param cbffr [in] The buffer to linearize, not in overwrite mode.
+ * @return Pointer to the occupied chars as a NUL terminated c-string (the NUL is in vacant space, it is not occupied).
+ */
+char *bbffr_linearize(bbuffer_t *cbffr);
 
 
 /**
@@ -216,7 +884,7 @@ uint16_t bbffr_find(bbuffer_t *cbffr, const char *needle, int16_t searchOffset,
  * @param cbffr The buffer to be operated on.
  * @param skipCnt The number of chars to advance the tail.
  */
-void bbffr_skipTail(bbuffer_t *cbffr, uint16_t skipCnt);
+void bbffr_skipTail(bbuffer_t *cbffr, bbffrSz_t skipCnt);
 
 
 /**
@@ -226,7 +894,36 @@ void bbffr_skipTail(bbuffer_t *cbffr, uint16_t skipCnt);
  * @param cbffr The buffer to be operated on.
  * @param skipCnt The number of chars to advance the head.
  */
-void bbffr_skipHead(bbuffer_t *cbffr, uint16_t skipCnt);
+void bbffr_skipHead(bbuffer_t *cbffr, bbffrSz_t skipCnt);
+
+
+/**
+ * @brief Start a consumer transaction (nestable), checkpointing the current tail.
+ * @details Consumer operations (pop, find w/setTail, skipTail, popRecord, etc.) proceed normally inside a transaction,
+ * but the chars consumed remain occupied to the producer until the outermost transaction commits. Parsers can try a
+ * grammar in place and back out with bbffr_rollbackTransaction() instead of copying data out first.
+ * 
+ * @param cbffr [in] The buffer to be operated on.
+ * @return true if started; false if BBFFR_CHECKPOINTS transactions are already open.
+ */
+bool bbffr_startTransaction(bbuffer_t *cbffr);
+
+
+/**
+ * @brief Commit the innermost transaction, keeping what was consumed. Space is released to the producer when the 
+ * outermost transaction commits.
+ * 
+ * @param cbffr [in] The buffer to be operated on.
+ */
+void bbffr_commitTransaction(bbuffer_t *cbffr);
+
+
+/**
+ * @brief Rollback the innermost transaction, restoring tail (and record count) to its checkpoint.
+ * 
+ * @param cbffr [in] The buffer to be operated on.
+ */
+void bbffr_rollbackTransaction(bbuffer_t *cbffr);
 
 
 #ifdef __cplusplus
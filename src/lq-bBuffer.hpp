@@ -0,0 +1,297 @@
+/******************************************************************************
+ *  \file lq-bBuffer.hpp
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2022 LooUQ Incorporated.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ * LooUQ block buffer for C++, header-only template with embedded storage
+ *
+ * lq::BlockBuffer<N> follows bbuffer_t semantics (one slot kept empty, single
+ * producer/single consumer safe via acquire/release index publication) with
+ * capacity fixed at compile time. Contents are exposed through random access
+ * iterators and two-span views, so <algorithm> works in place without copying:
+ *
+ *   lq::BlockBuffer<1024> rx;
+ *   auto it = std::search(rx.begin(), rx.end(), okStr, okStr + 4);
+ *   for (char c : rx) { ... }
+ *****************************************************************************/
+
+#ifndef __LQ_BBFFR_HPP__
+#define __LQ_BBFFR_HPP__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <iterator>
+#include <algorithm>
+
+namespace lq
+{
+
+/**
+ * @brief Block buffer with N chars of embedded storage (capacity N - 1).
+ * @details Wrap arithmetic is compile time: for N a power of two it reduces to a mask. The class is move-only, a move
+ * copies the occupied chars (storage is embedded) and leaves the source empty.
+ */
+template <size_t N>
+class BlockBuffer
+{
+    static_assert(N >= 2, "BlockBuffer requires N >= 2");
+
+public:
+    typedef char value_type;
+    typedef size_t size_type;
+    static constexpr size_type npos = static_cast<size_type>(-1);           ///< find() result signalling NOT FOUND
+
+    /**
+     * @brief A contiguous region of the buffer, iterable (bbffrSpan_t equivalent).
+     */
+    struct Span
+    {
+        const char *ptr;                                                    ///< Start of the region
+        size_type len;                                                      ///< Length of the region in chars
+
+        const char *begin() const { return ptr; }
+        const char *end() const { return ptr + len; }
+        size_type size() const { return len; }
+    };
+
+    /**
+     * @brief The occupied region as right-side (tail toward buffer end) and left-side (buffer start, if wrapped) spans.
+     */
+    struct Spans
+    {
+        Span first;
+        Span second;
+    };
+
+    /**
+     * @brief Random access iterator over the occupied chars, tail to head. Positions are unwrapped (0 to 2N) and
+     * folded into the storage on dereference.
+     */
+    class const_iterator
+    {
+    public:
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef char value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const char *pointer;
+        typedef const char &reference;
+
+        const_iterator() : data_(nullptr), pos_(0) {}
+        const_iterator(const char *data, size_type pos) : data_(data), pos_(pos) {}
+
+        reference operator*() const { return data_[wrap(pos_)]; }
+        reference operator[](difference_type n) const { return data_[wrap(pos_ + n)]; }
+        const_iterator &operator++() { ++pos_; return *this; }
+        const_iterator operator++(int) { const_iterator prev = *this; ++pos_; return prev; }
+        const_iterator &operator--() { --pos_; return *this; }
+        const_iterator operator--(int) { const_iterator prev = *this; --pos_; return prev; }
+        const_iterator &operator+=(difference_type n) { pos_ += n; return *this; }
+        const_iterator &operator-=(difference_type n) { pos_ -= n; return *this; }
+        const_iterator operator+(difference_type n) const { return const_iterator(data_, pos_ + n); }
+        const_iterator operator-(difference_type n) const { return const_iterator(data_, pos_ - n); }
+        friend const_iterator operator+(difference_type n, const const_iterator &it) { return it + n; }
+        difference_type operator-(const const_iterator &other) const { return static_cast<difference_type>(pos_ - other.pos_); }
+        bool operator==(const const_iterator &other) const { return pos_ == other.pos_; }
+        bool operator!=(const const_iterator &other) const { return pos_ != other.pos_; }
+        bool operator<(const const_iterator &other) const { return pos_ < other.pos_; }
+        bool operator>(const const_iterator &other) const { return pos_ > other.pos_; }
+        bool operator<=(const const_iterator &other) const { return pos_ <= other.pos_; }
+        bool operator>=(const const_iterator &other) const { return pos_ >= other.pos_; }
+
+    private:
+        const char *data_;
+        size_type pos_;
+    };
+    typedef const_iterator iterator;
+
+
+    BlockBuffer() : head_(0), tail_(0) {}
+
+    BlockBuffer(const BlockBuffer &) = delete;
+    BlockBuffer &operator=(const BlockBuffer &) = delete;
+
+    BlockBuffer(BlockBuffer &&other) : head_(0), tail_(0) { moveFrom(other); }
+    BlockBuffer &operator=(BlockBuffer &&other)
+    {
+        if (this != &other)
+        {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+
+    static constexpr size_type capacity() { return N - 1; }
+
+    /** @brief Get count of chars occupying the buffer. */
+    size_type size() const { return occupied(head_.load(std::memory_order_acquire), tail_.load(std::memory_order_acquire)); }
+
+    /** @brief Get count of available space in the buffer. */
+    size_type vacant() const { return N - 1 - size(); }
+
+    bool empty() const { return size() == 0; }
+
+    /** @brief Empty the buffer, not safe while the other side is active. */
+    void reset()
+    {
+        head_.store(0, std::memory_order_relaxed);
+        tail_.store(0, std::memory_order_relaxed);
+    }
+
+
+    /**
+     * @brief Producer: push chars at head. Returns number of chars pushed; the lesser of vacant and srcSz.
+     */
+    size_type push(const char *src, size_type srcSz)
+    {
+        size_type head = head_.load(std::memory_order_relaxed);
+        size_type tail = tail_.load(std::memory_order_acquire);
+        size_type pushCnt = std::min(srcSz, N - 1 - occupied(head, tail));
+        size_type rightCnt = std::min(pushCnt, N - head);
+
+        copyChars(data_ + head, src, rightCnt);
+        copyChars(data_, src + rightCnt, pushCnt - rightCnt);
+        head_.store(wrap(head + pushCnt), std::memory_order_release);     // publish only after copy is complete
+        return pushCnt;
+    }
+
+
+    /**
+     * @brief Consumer: pop chars from tail. Returns number of chars popped; the lesser of occupied and requestSz.
+     */
+    size_type pop(char *dest, size_type requestSz)
+    {
+        size_type tail = tail_.load(std::memory_order_relaxed);
+        size_type popCnt = peekFrom(tail, dest, requestSz);
+        tail_.store(wrap(tail + popCnt), std::memory_order_release);       // release space only after copy out
+        return popCnt;
+    }
+
+
+    /**
+     * @brief Consumer: copy chars from tail without consuming them.
+     */
+    size_type peek(char *dest, size_type requestSz) const
+    {
+        return peekFrom(tail_.load(std::memory_order_relaxed), dest, requestSz);
+    }
+
+
+    /**
+     * @brief Consumer: consume chars at tail (ex: after find() or parsing in place).
+     */
+    void skip(size_type skipCnt)
+    {
+        size_type tail = tail_.load(std::memory_order_relaxed);
+        skipCnt = std::min(skipCnt, occupied(head_.load(std::memory_order_acquire), tail));
+        tail_.store(wrap(tail + skipCnt), std::memory_order_release);
+    }
+
+
+    /**
+     * @brief Consumer: view the occupied chars (snapshot of head) as at most two contiguous spans.
+     */
+    Spans spans() const
+    {
+        size_type tail = tail_.load(std::memory_order_relaxed);
+        size_type available = occupied(head_.load(std::memory_order_acquire), tail);
+        size_type rightCnt = std::min(available, N - tail);
+
+        Spans view = { { data_ + tail, rightCnt }, { data_, available - rightCnt } };
+        return view;
+    }
+
+
+    /** @brief Iterators over the occupied chars; end() snapshots head. */
+    const_iterator begin() const { return const_iterator(data_, tail_.load(std::memory_order_relaxed)); }
+    const_iterator end() const { return begin() + static_cast<ptrdiff_t>(size()); }
+
+    /** @brief Char at offset from tail, offset must be less than size(). */
+    char operator[](size_type offset) const { return data_[wrap(tail_.load(std::memory_order_relaxed) + offset)]; }
+
+
+    /**
+     * @brief Consumer: find needle in the occupied chars. Returns offset from tail, or npos.
+     */
+    size_type find(const char *needle, size_type needleLen) const
+    {
+        const_iterator first = begin();
+        const_iterator last = first + static_cast<ptrdiff_t>(size());
+        const_iterator found = std::search(first, last, needle, needle + needleLen);
+        return (found == last || needleLen == 0) ? npos : static_cast<size_type>(found - first);
+    }
+
+    size_type find(const char *needle) const { return find(needle, strlen(needle)); }
+
+
+private:
+    static constexpr bool isPow2 = (N & (N - 1)) == 0;
+
+    /* Fold a position in [0, 2N) into the storage, a mask for power of two N */
+    static constexpr size_type wrap(size_type pos) { return isPow2 ? (pos & (N - 1)) : (pos >= N ? pos - N : pos); }
+
+    static constexpr size_type occupied(size_type head, size_type tail) { return wrap(head + N - tail); }
+
+    /* Out of line memcpy: with the copy length provably <= N, GCC otherwise inlines a "rep movs" that is several
+     * times slower than the library memcpy for the short copies typical of a stream buffer */
+#if defined(__GNUC__)
+    __attribute__((noinline))
+#endif
+    static void copyChars(char *dest, const char *src, size_type cnt)
+    {
+        if (cnt > 0)
+            memcpy(dest, src, cnt);
+    }
+
+    size_type peekFrom(size_type tail, char *dest, size_type requestSz) const
+    {
+        size_type popCnt = std::min(requestSz, occupied(head_.load(std::memory_order_acquire), tail));
+        size_type rightCnt = std::min(popCnt, N - tail);
+
+        copyChars(dest, data_ + tail, rightCnt);
+        copyChars(dest + rightCnt, data_, popCnt - rightCnt);
+        return popCnt;
+    }
+
+    void moveFrom(BlockBuffer &other)
+    {
+        Spans view = other.spans();
+        memcpy(data_, view.first.ptr, view.first.len);
+        memcpy(data_ + view.first.len, view.second.ptr, view.second.len);
+        head_.store(view.first.len + view.second.len, std::memory_order_release);
+        other.reset();
+    }
+
+    char data_[N];                                                          ///< Embedded storage
+    std::atomic<size_type> head_;                                           ///< Producer index, where chars are pushed
+    std::atomic<size_type> tail_;                                           ///< Consumer index, where chars are popped
+};
+
+template <size_t N>
+constexpr typename BlockBuffer<N>::size_type BlockBuffer<N>::npos;
+
+}   // namespace lq
+
+#endif  /* !__LQ_BBFFR_HPP__ */
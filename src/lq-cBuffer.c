@@ -24,17 +24,20 @@
  *****************************************************************************/
 
 #include <stdio.h>
+#include <string.h>
 
-#include "lq-cbuffer.h"
+#include "lq-cBuffer.h"
+
+/* Index arithmetic is compare-and-reset, never % (Cortex-M0+ has no hardware divide, % is a library call) */
 
 /**
  *  @brief Pushes a character on to stack buffer.
 */
 uint8_t cbffr_push(cbuffer_t *bufStruct, uint8_t data)
 {
-    int next = (bufStruct->head + 1) % bufStruct->maxlen;   // updt control
-    // if (next >= bufStruct->maxlen)
-    //     next = 0;
+    int next = bufStruct->head + 1;                         // updt control
+    if (next >= bufStruct->maxlen)
+        next = 0;
     if (next == bufStruct->tail)                            // if full, not pushing
         return 0;
 
@@ -52,11 +55,61 @@ uint8_t cbffr_pop(cbuffer_t *bufStruct, uint8_t *data)
     if (bufStruct->head == bufStruct->tail)                 // if the head == tail, we don't have any data
         return 0;
 
-    int next = (bufStruct->tail + 1) % bufStruct->maxlen;   // next is where tail will point to after this read.
-    // if(next >= bufStruct->maxlen)
-    //     next = 0;
+    int next = bufStruct->tail + 1;                         // next is where tail will point to after this read.
+    if (next >= bufStruct->maxlen)
+        next = 0;
 
     *data = bufStruct->buffer[bufStruct->tail];
     bufStruct->tail = next;
     return 1;
 }
+
+
+/**
+ *  @brief Pushes a block of characters on to buffer, at most two memcpy segments.
+*/
+int cbffr_pushN(cbuffer_t *bufStruct, const uint8_t *src, int srcSz)
+{
+    int head = bufStruct->head;
+    int vacant = bufStruct->tail - head - 1;                // one position is kept open, full != empty
+    if (vacant < 0)
+        vacant += bufStruct->maxlen;
+
+    int pushCnt = (srcSz < vacant) ? srcSz : vacant;
+    int rightCnt = bufStruct->maxlen - head;                // contiguous to buffer end
+    if (rightCnt > pushCnt)
+        rightCnt = pushCnt;
+
+    memcpy(bufStruct->buffer + head, src, rightCnt);
+    memcpy(bufStruct->buffer, src + rightCnt, pushCnt - rightCnt);
+    head += pushCnt;
+    if (head >= bufStruct->maxlen)
+        head -= bufStruct->maxlen;
+    bufStruct->head = head;                                 // updt control after data is in place
+    return pushCnt;
+}
+
+
+/**
+ *  @brief Pops a block of characters from buffer, at most two memcpy segments.
+*/
+int cbffr_popN(cbuffer_t *bufStruct, uint8_t *dest, int requestSz)
+{
+    int tail = bufStruct->tail;
+    int occupied = bufStruct->head - tail;
+    if (occupied < 0)
+        occupied += bufStruct->maxlen;
+
+    int popCnt = (requestSz < occupied) ? requestSz : occupied;
+    int rightCnt = bufStruct->maxlen - tail;
+    if (rightCnt > popCnt)
+        rightCnt = popCnt;
+
+    memcpy(dest, bufStruct->buffer + tail, rightCnt);
+    memcpy(dest + rightCnt, bufStruct->buffer, popCnt - rightCnt);
+    tail += popCnt;
+    if (tail >= bufStruct->maxlen)
+        tail -= bufStruct->maxlen;
+    bufStruct->tail = tail;                                 // release space after data is copied out
+    return popCnt;
+}
@@ -64,6 +64,26 @@ uint8_t cbffr_push(cbuffer_t *c, uint8_t data);
 uint8_t cbffr_pop(cbuffer_t *c, uint8_t *data);
 
 
+/**
+ *  @brief Pushes a block of characters on to buffer, copied in at most two segments (split at buffer wrap).
+ *  @param bufStruct [in] - The destination buffer.
+ *  @param src [in] - Characters to add to buffer.
+ *  @param srcSz [in] - Number of characters to add.
+ *  @return Number of characters pushed; the lesser of space available and srcSz. 
+*/
+int cbffr_pushN(cbuffer_t *c, const uint8_t *src, int srcSz);
+
+
+/**
+ *  @brief Pops a block of characters from buffer, copied out in at most two segments (split at buffer wrap).
+ *  @param bufStruct [in] - The source buffer.
+ *  @param dest [out] - Where to place popped characters.
+ *  @param requestSz [in] - Max number of characters to pop.
+ *  @return Number of characters popped; the lesser of characters available and requestSz. 
+*/
+int cbffr_popN(cbuffer_t *c, uint8_t *dest, int requestSz);
+
+
 #ifdef __cplusplus
 }
 #endif // !__cplusplus
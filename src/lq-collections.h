@@ -114,6 +114,8 @@ void lq_getQryStrDictionaryValue(const char *key, keyValueDict_t dict, char *val
 
 /**
  * @brief JSON (body) Documents
+ * @note Each call scans the document text; to read several properties from one document index it once with 
+ * lq_jsonIndex() (lq-json.h) and use lq_jsonGetPropValue(), which returns the same lqJsonPropValue_t.
  * 
  * @param jsonSrc 
  * @param propName 
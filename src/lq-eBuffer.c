@@ -0,0 +1,165 @@
+/******************************************************************************
+ *  \file lq-eBuffer.c
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2022 LooUQ Incorporated.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ * LooUQ element buffer, a single producer/single consumer ring of fixed size
+ * elements. See lq-eBuffer.h
+ *****************************************************************************/
+
+#include <string.h>
+
+#include "lq-eBuffer.h"
+
+/* Index publication (C11 acquire/release via compiler builtins, as lq-bBuffer): each side loads its own index relaxed,
+ * the other side's with acquire, and stores its own with release only after the element copy is complete.
+ * Index arithmetic is compare-and-reset, never % (Cortex-M0+ has no hardware divide).
+ */
+#define EBFFR_LOAD_OWN(p) __atomic_load_n(&(p), __ATOMIC_RELAXED)
+#define EBFFR_LOAD_ACQ(p) __atomic_load_n(&(p), __ATOMIC_ACQUIRE)
+#define EBFFR_STORE_REL(p, v) __atomic_store_n(&(p), (v), __ATOMIC_RELEASE)
+
+
+#pragma region Local Static Function Declarations
+static uint16_t occupiedCnt(ebuffer_t *ebffr, uint16_t head, uint16_t tail);
+static uint16_t advanceIndex(ebuffer_t *ebffr, uint16_t index, uint16_t cnt);
+#pragma endregion
+
+
+void ebffr_init(ebuffer_t *ebffr, void *storage, uint16_t elemSz, uint16_t elemCnt)
+{
+    ebffr->buffer = (uint8_t *)storage;
+    ebffr->elemSz = elemSz;
+    ebffr->elemCnt = elemCnt;
+    ebffr->head = 0;
+    ebffr->tail = 0;
+}
+
+
+void ebffr_reset(ebuffer_t *ebffr)
+{
+    ebffr->head = 0;
+    ebffr->tail = 0;
+}
+
+
+uint16_t ebffr_getOccupied(ebuffer_t *ebffr)
+{
+    return occupiedCnt(ebffr, EBFFR_LOAD_ACQ(ebffr->head), EBFFR_LOAD_ACQ(ebffr->tail));
+}
+
+
+uint16_t ebffr_getVacant(ebuffer_t *ebffr)
+{
+    return ebffr->elemCnt - 1 - ebffr_getOccupied(ebffr);
+}
+
+
+bool ebffr_enqueue(ebuffer_t *ebffr, const void *elem)
+{
+    uint16_t head = EBFFR_LOAD_OWN(ebffr->head);
+    uint16_t next = advanceIndex(ebffr, head, 1);
+
+    if (next == EBFFR_LOAD_ACQ(ebffr->tail))                                // full
+        return false;
+
+    memcpy(ebffr->buffer + (uint32_t)head * ebffr->elemSz, elem, ebffr->elemSz);
+    EBFFR_STORE_REL(ebffr->head, next);                                     // publish after element is in place
+    return true;
+}
+
+
+uint16_t ebffr_enqueueN(ebuffer_t *ebffr, const void *src, uint16_t srcCnt)
+{
+    uint16_t head = EBFFR_LOAD_OWN(ebffr->head);
+    uint16_t vacant = ebffr->elemCnt - 1 - occupiedCnt(ebffr, head, EBFFR_LOAD_ACQ(ebffr->tail));
+    uint16_t enqueueCnt = (srcCnt < vacant) ? srcCnt : vacant;
+    uint16_t rightCnt = ebffr->elemCnt - head;                              // slots contiguous to storage end
+    if (rightCnt > enqueueCnt)
+        rightCnt = enqueueCnt;
+
+    memcpy(ebffr->buffer + (uint32_t)head * ebffr->elemSz, src, (uint32_t)rightCnt * ebffr->elemSz);
+    memcpy(ebffr->buffer, (const uint8_t *)src + (uint32_t)rightCnt * ebffr->elemSz, (uint32_t)(enqueueCnt - rightCnt) * ebffr->elemSz);
+    EBFFR_STORE_REL(ebffr->head, advanceIndex(ebffr, head, enqueueCnt));    // whole batch published at once
+    return enqueueCnt;
+}
+
+
+bool ebffr_dequeue(ebuffer_t *ebffr, void *elem)
+{
+    if (!ebffr_peek(ebffr, elem))
+        return false;
+
+    EBFFR_STORE_REL(ebffr->tail, advanceIndex(ebffr, EBFFR_LOAD_OWN(ebffr->tail), 1));     // release slot after copy out
+    return true;
+}
+
+
+uint16_t ebffr_dequeueN(ebuffer_t *ebffr, void *dest, uint16_t requestCnt)
+{
+    uint16_t tail = EBFFR_LOAD_OWN(ebffr->tail);
+    uint16_t occupied = occupiedCnt(ebffr, EBFFR_LOAD_ACQ(ebffr->head), tail);
+    uint16_t dequeueCnt = (requestCnt < occupied) ? requestCnt : occupied;
+    uint16_t rightCnt = ebffr->elemCnt - tail;
+    if (rightCnt > dequeueCnt)
+        rightCnt = dequeueCnt;
+
+    memcpy(dest, ebffr->buffer + (uint32_t)tail * ebffr->elemSz, (uint32_t)rightCnt * ebffr->elemSz);
+    memcpy((uint8_t *)dest + (uint32_t)rightCnt * ebffr->elemSz, ebffr->buffer, (uint32_t)(dequeueCnt - rightCnt) * ebffr->elemSz);
+    EBFFR_STORE_REL(ebffr->tail, advanceIndex(ebffr, tail, dequeueCnt));
+    return dequeueCnt;
+}
+
+
+bool ebffr_peek(ebuffer_t *ebffr, void *elem)
+{
+    uint16_t tail = EBFFR_LOAD_OWN(ebffr->tail);
+
+    if (tail == EBFFR_LOAD_ACQ(ebffr->head))                                // empty
+        return false;
+
+    memcpy(elem, ebffr->buffer + (uint32_t)tail * ebffr->elemSz, ebffr->elemSz);
+    return true;
+}
+
+
+#pragma region Static Local Functions
+
+/**
+ *  @brief STATIC Scope: Count of elements between tail and head (snapshot values).
+ */
+static uint16_t occupiedCnt(ebuffer_t *ebffr, uint16_t head, uint16_t tail)
+{
+    return (head >= tail) ? head - tail : head + ebffr->elemCnt - tail;
+}
+
+
+/**
+ *  @brief STATIC Scope: Move an index forward cnt slots (cnt < elemCnt), wrapping at storage end.
+ */
+static uint16_t advanceIndex(ebuffer_t *ebffr, uint16_t index, uint16_t cnt)
+{
+    uint32_t next = (uint32_t)index + cnt;
+    return (next >= ebffr->elemCnt) ? (uint16_t)(next - ebffr->elemCnt) : (uint16_t)next;
+}
+
+#pragma endregion
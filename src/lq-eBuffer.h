@@ -0,0 +1,165 @@
+/******************************************************************************
+ *  \file lq-eBuffer.h
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2022 LooUQ Incorporated.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ * LooUQ element buffer, a ring of fixed size elements (ex: event records)
+ *
+ * Single producer/single consumer safe without locks or critical sections, ex:
+ * an ISR enqueues and a task dequeues. Element size is set at init; for type
+ * checked access declare wrappers with EBFFR_TYPED():
+ *
+ *   typedef struct { uint8_t pin; uint8_t code; uint32_t timestamp; } pinEvent_t;
+ *   EBFFR_TYPED(pinEvents, pinEvent_t)
+ *
+ *   static pinEvent_t eventStore[16];
+ *   static ebuffer_t eventQueue;
+ *   pinEvents_init(&eventQueue, eventStore, 16);           // capacity 15 events
+ *   pinEvents_enqueue(&eventQueue, &event);                // ISR
+ *   while (pinEvents_dequeue(&eventQueue, &event)) { ... } // task
+ *****************************************************************************/
+
+#ifndef __LQ_EBUFFER_H__
+#define __LQ_EBUFFER_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ *  @brief Element buffer control, storage is supplied by the application at init.
+*/
+typedef struct ebuffer_tag
+{
+    uint8_t *buffer;                                        ///< Element storage, elemSz * elemCnt bytes
+    uint16_t elemSz;                                        ///< Size of one element in bytes
+    uint16_t elemCnt;                                       ///< Number of element slots; one is kept open, capacity is elemCnt - 1
+    volatile uint16_t head;                                 ///< Slot where the next element is enqueued, written only by producer
+    volatile uint16_t tail;                                 ///< Slot where the next element is dequeued, written only by consumer
+} ebuffer_t;
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+/**
+ *  @brief Initialize an element buffer.
+ *  @param ebffr [in] - The buffer control to initialize.
+ *  @param storage [in] - Element storage, at least elemSz * elemCnt bytes.
+ *  @param elemSz [in] - Size of one element in bytes (ex: sizeof(pinEvent_t)).
+ *  @param elemCnt [in] - Number of element slots in storage (2 or more), buffer holds elemCnt - 1 elements.
+*/
+void ebffr_init(ebuffer_t *ebffr, void *storage, uint16_t elemSz, uint16_t elemCnt);
+
+
+/**
+ *  @brief Empty the buffer, not safe while the producer or consumer is active.
+ *  @param ebffr [in] - The buffer to reset.
+*/
+void ebffr_reset(ebuffer_t *ebffr);
+
+
+/**
+ *  @brief Get number of elements waiting in the buffer.
+ *  @param ebffr [in] - The buffer to report on.
+ *  @return Count of elements occupying the buffer.
+*/
+uint16_t ebffr_getOccupied(ebuffer_t *ebffr);
+
+
+/**
+ *  @brief Get number of elements that can be enqueued before the buffer is full.
+ *  @param ebffr [in] - The buffer to report on.
+ *  @return Count of vacant element slots.
+*/
+uint16_t ebffr_getVacant(ebuffer_t *ebffr);
+
+
+/**
+ *  @brief Producer: copy one element into the buffer.
+ *  @param ebffr [in] - The destination buffer.
+ *  @param elem [in] - Element to enqueue (elemSz bytes).
+ *  @return true if enqueued, false if buffer is full.
+*/
+bool ebffr_enqueue(ebuffer_t *ebffr, const void *elem);
+
+
+/**
+ *  @brief Producer: copy up to srcCnt elements into the buffer as one operation (at most two copy segments).
+ *  @param ebffr [in] - The destination buffer.
+ *  @param src [in] - Array of elements to enqueue.
+ *  @param srcCnt [in] - Number of elements in src.
+ *  @return Number of elements enqueued; the lesser of vacant and srcCnt. The consumer sees all of them at once.
+*/
+uint16_t ebffr_enqueueN(ebuffer_t *ebffr, const void *src, uint16_t srcCnt);
+
+
+/**
+ *  @brief Consumer: copy one element out of the buffer and remove it.
+ *  @param ebffr [in] - The source buffer.
+ *  @param elem [out] - Where to place the element (elemSz bytes).
+ *  @return true if dequeued, false if buffer is empty.
+*/
+bool ebffr_dequeue(ebuffer_t *ebffr, void *elem);
+
+
+/**
+ *  @brief Consumer: copy up to requestCnt elements out of the buffer and remove them (at most two copy segments).
+ *  @param ebffr [in] - The source buffer.
+ *  @param dest [out] - Array to receive the elements.
+ *  @param requestCnt [in] - Max number of elements to dequeue.
+ *  @return Number of elements dequeued; the lesser of occupied and requestCnt.
+*/
+uint16_t ebffr_dequeueN(ebuffer_t *ebffr, void *dest, uint16_t requestCnt);
+
+
+/**
+ *  @brief Consumer: copy the oldest element without removing it.
+ *  @param ebffr [in] - The source buffer.
+ *  @param elem [out] - Where to place the element (elemSz bytes).
+ *  @return true if an element was copied, false if buffer is empty.
+*/
+bool ebffr_peek(ebuffer_t *ebffr, void *elem);
+
+
+#ifdef __cplusplus
+}
+#endif // !__cplusplus
+
+
+/**
+ *  @brief Declare type checked static inline wrappers (NAME_init, NAME_enqueue, NAME_enqueueN, NAME_dequeue,
+ *  NAME_dequeueN, NAME_peek) over an ebuffer_t holding TYPE elements.
+*/
+#define EBFFR_TYPED(NAME, TYPE)                                                                                         \
+    static inline void NAME##_init(ebuffer_t *ebffr, TYPE *storage, uint16_t elemCnt)                                  \
+        { ebffr_init(ebffr, storage, (uint16_t)sizeof(TYPE), elemCnt); }                                                \
+    static inline bool NAME##_enqueue(ebuffer_t *ebffr, const TYPE *elem) { return ebffr_enqueue(ebffr, elem); }        \
+    static inline uint16_t NAME##_enqueueN(ebuffer_t *ebffr, const TYPE *src, uint16_t srcCnt)                         \
+        { return ebffr_enqueueN(ebffr, src, srcCnt); }                                                                  \
+    static inline bool NAME##_dequeue(ebuffer_t *ebffr, TYPE *elem) { return ebffr_dequeue(ebffr, elem); }              \
+    static inline uint16_t NAME##_dequeueN(ebuffer_t *ebffr, TYPE *dest, uint16_t requestCnt)                          \
+        { return ebffr_dequeueN(ebffr, dest, requestCnt); }                                                             \
+    static inline bool NAME##_peek(ebuffer_t *ebffr, TYPE *elem) { return ebffr_peek(ebffr, elem); }
+
+#endif  /* !__LQ_EBUFFER_H__ */
@@ -0,0 +1,1137 @@
+/******************************************************************************
+ *  \file lq-json.c
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2022 LooUQ Incorporated.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ ******************************************************************************
+ * JSON document index: one pass tokenizer and lookups over the token array.
+ *****************************************************************************/
+
+#include <lq-embed.h>
+#define LOG_LEVEL LOGLEVEL_DBG
+//#define DISABLE_ASSERTS                                   // ASSERT/ASSERT_W enabled by default, can be disabled 
+#define SRCFILE "JSN"                                       // create SRCFILE (3 char) MACRO for lq-diagnostics ASSERT
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "lq-json.h"
+
+
+/* Tokenizer states, what the next non-whitespace char may be */
+typedef enum parseState_tag
+{
+    parseState_value = 0,                                   ///< Any value (document start, after ':' or array ',')
+    parseState_valueOrClose,                                ///< Value or ']' (after '[')
+    parseState_key,                                         ///< Property key (after object ',')
+    parseState_keyOrClose,                                  ///< Property key or '}' (after '{')
+    parseState_colon,                                       ///< ':' after a key
+    parseState_commaOrClose,                                ///< ',' or close after a complete value
+    parseState_done                                         ///< Root value complete, only whitespace may follow
+} parseState_t;
+
+
+/* Streaming parser, token in progress when a chunk ends */
+typedef enum streamScan_tag
+{
+    streamScan_none = 0,
+    streamScan_string,                                      ///< Inside a key or text value
+    streamScan_escape,                                      ///< Inside a string, after '\\'
+    streamScan_primitive                                    ///< Inside a number or literal
+} streamScan_t;
+
+
+/* One step of a path: a property name or an array element index */
+typedef struct pathSegment_tag
+{
+    const char *name;                                       ///< Property name (not NULL terminated), NULL for an element
+    uint16_t nameLen;                                       ///< Length of name
+    uint16_t elementIndx;                                   ///< Array element index
+} pathSegment_t;
+
+
+#pragma region Local Static Function Declarations
+static uint16_t addToken(lqJsonIndex_t *index, uint16_t parent, lqJsonPropType_t type, uint16_t start, bool isKey);
+static parseState_t valueComplete(lqJsonIndex_t *index, uint16_t tok, uint16_t *parent);
+static lqJsonResult_t scanString(const char *json, uint16_t jsonLen, uint16_t *pos);
+static lqJsonResult_t scanPrimitive(const char *json, uint16_t jsonLen, uint16_t *pos, lqJsonPropType_t *type);
+static bool scanDigits(const char *json, uint16_t jsonLen, uint16_t *pos);
+static bool nextPathSegment(const char **path, pathSegment_t *segment);
+static uint16_t skipWhitespace(const char *json, uint16_t jsonLen, uint16_t pos);
+static lqJsonResult_t skipValue(const char *json, uint16_t jsonLen, uint16_t *pos, lqJsonPropType_t *type);
+static void bindProperty(const lqJsonBinding_t *bindings, uint8_t bindingCnt, void *target, lqJsonBindStatus_t *status, 
+                         const char *key, uint16_t keyLen, const char *value, uint16_t len, lqJsonPropType_t type);
+static bool bindValue(const lqJsonBinding_t *binding, void *target, const char *value, uint16_t len, lqJsonPropType_t type);
+static bool bindInteger(const lqJsonBinding_t *binding, void *field, const char *value, uint16_t len);
+static bool bindText(char *field, uint16_t fieldSz, const char *value, uint16_t len);
+static bool decodeHex4(const char *hex, uint16_t *codePoint);
+static bool streamAppend(lqJsonStream_t *stream, const char *src, uint16_t srcLen);
+static lqJsonResult_t streamString(lqJsonStream_t *stream, const char *chunk, uint16_t chunkLen, uint16_t *pos);
+static void streamValue(lqJsonStream_t *stream, lqJsonPropType_t type);
+static void streamEvent(lqJsonStream_t *stream, lqJsonEventType_t eventType, lqJsonPropType_t type, bool withKey);
+#pragma endregion
+
+
+/**
+ *  @brief Tokenize a JSON document in a single pass into a token index.
+ *  @details The container (or key) being filled is tracked in parent; open containers use their own next link to hold
+ *  their last child while open, so nesting depth needs no stack beyond the token array.
+*/
+lqJsonResult_t lq_jsonIndex(lqJsonIndex_t *index, const char *json, uint16_t jsonLen, lqJsonToken_t *tokens, uint16_t tokenCap)
+{
+    index->json = json;
+    index->tokens = tokens;
+    index->tokenCap = tokenCap;
+    index->tokenCnt = 0;
+
+    parseState_t state = parseState_value;
+    uint16_t parent = LQJSON_NONE;
+    uint16_t pos = 0;
+    uint16_t tok;
+
+    while (pos < jsonLen)
+    {
+        char c = json[pos];
+
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+        {
+            pos++;
+            continue;
+        }
+        if (state == parseState_done)
+            return lqJsonResult_invalid;
+
+        switch (c)
+        {
+            case '{':
+            case '[':
+                if (state != parseState_value && state != parseState_valueOrClose)
+                    return lqJsonResult_invalid;
+                if ((tok = addToken(index, parent, (c == '{') ? lqcJsonPropType_object : lqcJsonPropType_array, pos, false)) == LQJSON_NONE)
+                    return lqJsonResult_noTokens;
+                parent = tok;
+                state = (c == '{') ? parseState_keyOrClose : parseState_valueOrClose;
+                pos++;
+                break;
+
+            case '}':
+            case ']':
+            {
+                lqJsonPropType_t closing = (c == '}') ? lqcJsonPropType_object : lqcJsonPropType_array;
+                bool emptyClose = (c == '}') ? (state == parseState_keyOrClose) : (state == parseState_valueOrClose);
+                if (parent == LQJSON_NONE || tokens[parent].type != closing || (state != parseState_commaOrClose && !emptyClose))
+                    return lqJsonResult_invalid;
+                tok = parent;
+                tokens[tok].len = pos - tokens[tok].start + 1;
+                tokens[tok].next = LQJSON_NONE;                                         // was last child while open
+                state = valueComplete(index, tok, &parent);
+                pos++;
+                break;
+            }
+
+            case ':':
+                if (state != parseState_colon)
+                    return lqJsonResult_invalid;
+                state = parseState_value;
+                pos++;
+                break;
+
+            case ',':
+                if (state != parseState_commaOrClose)
+                    return lqJsonResult_invalid;
+                state = (tokens[parent].type == lqcJsonPropType_object) ? parseState_key : parseState_value;
+                pos++;
+                break;
+
+            case '"':
+            {
+                bool isKey = (state == parseState_key || state == parseState_keyOrClose);
+                if (!isKey && state != parseState_value && state != parseState_valueOrClose)
+                    return lqJsonResult_invalid;
+                if ((tok = addToken(index, parent, lqcJsonPropType_text, pos + 1, isKey)) == LQJSON_NONE)
+                    return lqJsonResult_noTokens;
+                lqJsonResult_t scanResult = scanString(json, jsonLen, &pos);
+                if (scanResult != lqJsonResult_ok)
+                    return scanResult;
+                tokens[tok].len = pos - 1 - tokens[tok].start;                          // pos is past the closing quote
+                if (isKey)
+                {
+                    parent = tok;                                                       // key is parent of its value
+                    state = parseState_colon;
+                }
+                else
+                    state = valueComplete(index, tok, &parent);
+                break;
+            }
+
+            default:
+            {
+                lqJsonPropType_t type;
+                uint16_t start = pos;
+                if (state != parseState_value && state != parseState_valueOrClose)
+                    return lqJsonResult_invalid;
+                lqJsonResult_t scanResult = scanPrimitive(json, jsonLen, &pos, &type);
+                if (scanResult != lqJsonResult_ok)
+                    return scanResult;
+                if ((tok = addToken(index, parent, type, start, false)) == LQJSON_NONE)
+                    return lqJsonResult_noTokens;
+                tokens[tok].len = pos - start;
+                state = valueComplete(index, tok, &parent);
+                break;
+            }
+        }
+    }
+    return (state == parseState_done) ? lqJsonResult_ok : lqJsonResult_partial;
+}
+
+
+/**
+ *  @brief Find an object's property by name, walking the object's key links.
+*/
+uint16_t lq_jsonFindProp(const lqJsonIndex_t *index, uint16_t objectTok, const char *propName)
+{
+    if (objectTok >= index->tokenCnt || index->tokens[objectTok].type != lqcJsonPropType_object)
+        return LQJSON_NONE;
+
+    size_t nameLen = strlen(propName);
+    uint16_t keyTok = (index->tokens[objectTok].size > 0) ? objectTok + 1 : LQJSON_NONE;
+
+    while (keyTok != LQJSON_NONE)
+    {
+        const lqJsonToken_t *key = &index->tokens[keyTok];
+        if (key->len == nameLen && memcmp(index->json + key->start, propName, nameLen) == 0)
+            return keyTok + 1;                                                          // value follows its key
+        keyTok = key->next;
+    }
+    return LQJSON_NONE;
+}
+
+
+/**
+ *  @brief Get the value of a token in lq_getJsonPropValue() result form.
+*/
+lqJsonPropValue_t lq_jsonGetValue(const lqJsonIndex_t *index, uint16_t tok)
+{
+    lqJsonPropValue_t results = {0, 0, lqcJsonPropType_notFound};
+
+    if (tok < index->tokenCnt)
+    {
+        results.value = (char*)index->json + index->tokens[tok].start;
+        results.len = index->tokens[tok].len;
+        results.type = (lqJsonPropType_t)index->tokens[tok].type;
+    }
+    return results;
+}
+
+
+/**
+ *  @brief Get an object property's value.
+*/
+lqJsonPropValue_t lq_jsonGetPropValue(const lqJsonIndex_t *index, uint16_t objectTok, const char *propName)
+{
+    return lq_jsonGetValue(index, lq_jsonFindProp(index, objectTok, propName));
+}
+
+
+/**
+ *  @brief Get an array element, following element sibling links.
+*/
+uint16_t lq_jsonGetElement(const lqJsonIndex_t *index, uint16_t arrayTok, uint16_t elementIndx)
+{
+    if (arrayTok >= index->tokenCnt || index->tokens[arrayTok].type != lqcJsonPropType_array || elementIndx >= index->tokens[arrayTok].size)
+        return LQJSON_NONE;
+
+    uint16_t elementTok = arrayTok + 1;
+    while (elementIndx-- > 0)
+        elementTok = index->tokens[elementTok].next;
+    return elementTok;
+}
+
+
+/**
+ *  @brief Resolve a path to a token.
+*/
+uint16_t lq_jsonFindPath(const lqJsonIndex_t *index, uint16_t fromTok, const char *path)
+{
+    pathSegment_t segment;
+    uint16_t tok = (fromTok < index->tokenCnt) ? fromTok : LQJSON_NONE;
+
+    while (tok != LQJSON_NONE && *path != '\0')
+    {
+        if (!nextPathSegment(&path, &segment))
+            return LQJSON_NONE;
+
+        if (segment.name == NULL)
+            tok = lq_jsonGetElement(index, tok, segment.elementIndx);
+        else
+        {
+            if (index->tokens[tok].type != lqcJsonPropType_object)
+                return LQJSON_NONE;
+            uint16_t keyTok = (index->tokens[tok].size > 0) ? tok + 1 : LQJSON_NONE;
+            while (keyTok != LQJSON_NONE &&
+                   (index->tokens[keyTok].len != segment.nameLen || memcmp(index->json + index->tokens[keyTok].start, segment.name, segment.nameLen) != 0))
+                keyTok = index->tokens[keyTok].next;
+            tok = (keyTok != LQJSON_NONE) ? keyTok + 1 : LQJSON_NONE;
+        }
+    }
+    return tok;
+}
+
+
+/**
+ *  @brief Get the value at a path.
+*/
+lqJsonPropValue_t lq_jsonGetPathValue(const lqJsonIndex_t *index, uint16_t fromTok, const char *path)
+{
+    return lq_jsonGetValue(index, lq_jsonFindPath(index, fromTok, path));
+}
+
+
+/**
+ *  @brief Get the value at a path from the document text, skipping values not on the path whole.
+*/
+lqJsonPropValue_t lq_jsonScanPathValue(const char *json, uint16_t jsonLen, const char *path)
+{
+    lqJsonPropValue_t results = {0, 0, lqcJsonPropType_notFound};
+    pathSegment_t segment;
+    lqJsonPropType_t type;
+    uint16_t pos = skipWhitespace(json, jsonLen, 0);
+
+    while (*path != '\0')
+    {
+        if (!nextPathSegment(&path, &segment) || pos >= jsonLen)
+            return results;
+
+        char open = (segment.name != NULL) ? '{' : '[';
+        if (json[pos] != open)
+            return results;
+        pos = skipWhitespace(json, jsonLen, pos + 1);
+
+        for (uint16_t memberIndx = 0; ; memberIndx++)                                   // walk members, skip those not on path
+        {
+            if (pos >= jsonLen || json[pos] == ((open == '{') ? '}' : ']'))
+                return results;
+
+            bool onPath;
+            if (open == '{')
+            {
+                uint16_t keyStart = pos + 1;
+                if (json[pos] != '"' || scanString(json, jsonLen, &pos) != lqJsonResult_ok)
+                    return results;
+                onPath = (pos - 1 - keyStart == segment.nameLen && memcmp(json + keyStart, segment.name, segment.nameLen) == 0);
+                pos = skipWhitespace(json, jsonLen, pos);
+                if (pos >= jsonLen || json[pos] != ':')
+                    return results;
+                pos = skipWhitespace(json, jsonLen, pos + 1);
+            }
+            else
+                onPath = (memberIndx == segment.elementIndx);
+
+            if (onPath)
+                break;
+            if (skipValue(json, jsonLen, &pos, &type) != lqJsonResult_ok)               // whole subtree in one step
+                return results;
+            pos = skipWhitespace(json, jsonLen, pos);
+            if (pos < jsonLen && json[pos] == ',')
+                pos = skipWhitespace(json, jsonLen, pos + 1);
+        }
+    }
+
+    uint16_t valueStart = pos;
+    if (pos >= jsonLen || skipValue(json, jsonLen, &pos, &type) != lqJsonResult_ok)
+        return results;
+    results.type = type;
+    results.value = (char*)json + valueStart;
+    results.len = pos - valueStart;
+    if (type == lqcJsonPropType_text)                                                   // text excludes quotes
+    {
+        results.value++;
+        results.len -= 2;
+    }
+    return results;
+}
+
+
+/**
+ *  @brief Fill struct fields from an object's properties in one pass.
+*/
+lqJsonResult_t lq_jsonBind(const char *json, uint16_t jsonLen, const lqJsonBinding_t *bindings, uint8_t bindingCnt, void *target, lqJsonBindStatus_t *status)
+{
+    lqJsonPropType_t type;
+    uint16_t pos = skipWhitespace(json, jsonLen, 0);
+
+    status->present = 0;
+    status->mismatch = 0;
+    if (bindingCnt > LQJSON_BIND_MAX)
+        bindingCnt = LQJSON_BIND_MAX;
+
+    if (pos >= jsonLen)
+        return lqJsonResult_partial;
+    if (json[pos] != '{')
+        return lqJsonResult_invalid;
+    pos = skipWhitespace(json, jsonLen, pos + 1);
+    if (pos < jsonLen && json[pos] == '}')
+        return lqJsonResult_ok;
+
+    while (pos < jsonLen)
+    {
+        uint16_t keyStart = pos + 1;
+        if (json[pos] != '"')
+            return lqJsonResult_invalid;
+        if (scanString(json, jsonLen, &pos) != lqJsonResult_ok)
+            return lqJsonResult_partial;
+        uint16_t keyLen = pos - 1 - keyStart;
+
+        pos = skipWhitespace(json, jsonLen, pos);
+        if (pos >= jsonLen)
+            break;
+        if (json[pos] != ':')
+            return lqJsonResult_invalid;
+        pos = skipWhitespace(json, jsonLen, pos + 1);
+        if (pos >= jsonLen)
+            break;
+
+        uint16_t valueStart = pos;
+        lqJsonResult_t result = skipValue(json, jsonLen, &pos, &type);
+        if (result != lqJsonResult_ok)
+            return result;
+        if (pos >= jsonLen)                                                             // number may continue in unseen text
+            break;
+
+        if (type == lqcJsonPropType_text)                                               // text excludes quotes
+            bindProperty(bindings, bindingCnt, target, status, json + keyStart, keyLen, json + valueStart + 1, pos - valueStart - 2, type);
+        else
+            bindProperty(bindings, bindingCnt, target, status, json + keyStart, keyLen, json + valueStart, pos - valueStart, type);
+
+        pos = skipWhitespace(json, jsonLen, pos);
+        if (pos >= jsonLen)
+            break;
+        if (json[pos] == '}')
+            return lqJsonResult_ok;
+        if (json[pos] != ',')
+            return lqJsonResult_invalid;
+        pos = skipWhitespace(json, jsonLen, pos + 1);
+    }
+    return lqJsonResult_partial;
+}
+
+
+/**
+ *  @brief Start a streamed document parse.
+*/
+void lq_jsonStreamInit(lqJsonStream_t *stream, char *tokenBuffer, uint16_t tokenBufferSz, lqJsonEvent_func eventCB, void *context)
+{
+    memset(stream, 0, sizeof(lqJsonStream_t));
+    stream->token = tokenBuffer;
+    stream->tokenSz = tokenBufferSz;
+    stream->eventCB = eventCB;
+    stream->context = context;
+    stream->state = parseState_value;
+    stream->scan = streamScan_none;
+    stream->result = lqJsonResult_partial;
+}
+
+
+/**
+ *  @brief Bind the root object's scalar properties as they complete.
+*/
+void lq_jsonStreamBind(lqJsonStream_t *stream, const lqJsonBinding_t *bindings, uint8_t bindingCnt, void *target)
+{
+    stream->bindings = bindings;
+    stream->bindingCnt = (bindingCnt > LQJSON_BIND_MAX) ? LQJSON_BIND_MAX : bindingCnt;
+    stream->target = target;
+    stream->status.present = 0;
+    stream->status.mismatch = 0;
+}
+
+
+/**
+ *  @brief Parse the next chunk of a streamed document.
+*/
+lqJsonResult_t lq_jsonStreamFeed(lqJsonStream_t *stream, const char *chunk, uint16_t chunkLen)
+{
+    uint16_t pos = 0;
+
+    while (pos < chunkLen && (stream->result == lqJsonResult_partial || stream->result == lqJsonResult_ok))
+    {
+        if (stream->scan == streamScan_string || stream->scan == streamScan_escape)
+        {
+            stream->result = streamString(stream, chunk, chunkLen, &pos);
+            continue;
+        }
+
+        char c = chunk[pos];
+        if (stream->scan == streamScan_primitive)
+        {
+            uint16_t runStart = pos;
+            while ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || c == '-' || c == '+' || c == '.' || c == 'E')
+            {
+                if (++pos == chunkLen)
+                    break;
+                c = chunk[pos];
+            }
+            if (!streamAppend(stream, chunk + runStart, pos - runStart) || pos == chunkLen)
+                break;                                                                  // may continue in next chunk
+
+            lqJsonPropType_t type;
+            uint16_t scan = 0;
+            if (scanPrimitive(stream->token + stream->keyLen, stream->valueLen, &scan, &type) != lqJsonResult_ok || scan != stream->valueLen)
+            {
+                stream->result = lqJsonResult_invalid;
+                break;
+            }
+            stream->scan = streamScan_none;
+            streamValue(stream, type);                                                  // c is handled below
+        }
+
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+        {
+            pos++;
+            continue;
+        }
+        if (stream->state == parseState_done)
+        {
+            stream->result = lqJsonResult_invalid;
+            break;
+        }
+
+        bool inObject = (stream->depth > 0) && (stream->isObject & ((uint32_t)1 << (stream->depth - 1)));
+        switch (c)
+        {
+            case '{':
+            case '[':
+                if (stream->state != parseState_value && stream->state != parseState_valueOrClose)
+                    stream->result = lqJsonResult_invalid;
+                else if (stream->depth == LQJSON_STREAM_MAXDEPTH)
+                    stream->result = lqJsonResult_noTokens;
+                else
+                {
+                    if (c == '{')
+                        streamEvent(stream, lqJsonEventType_objectStart, lqcJsonPropType_object, inObject);
+                    else
+                        streamEvent(stream, lqJsonEventType_arrayStart, lqcJsonPropType_array, inObject);
+                    if (c == '{')
+                        stream->isObject |= (uint32_t)1 << stream->depth;
+                    else
+                        stream->isObject &= ~((uint32_t)1 << stream->depth);
+                    stream->depth++;
+                    stream->keyLen = 0;
+                    stream->state = (c == '{') ? parseState_keyOrClose : parseState_valueOrClose;
+                }
+                break;
+
+            case '}':
+            case ']':
+            {
+                bool emptyClose = (c == '}') ? (stream->state == parseState_keyOrClose) : (stream->state == parseState_valueOrClose);
+                if (stream->depth == 0 || inObject != (c == '}') || (stream->state != parseState_commaOrClose && !emptyClose))
+                    stream->result = lqJsonResult_invalid;
+                else
+                {
+                    stream->depth--;
+                    if (c == '}')
+                        streamEvent(stream, lqJsonEventType_objectEnd, lqcJsonPropType_object, false);
+                    else
+                        streamEvent(stream, lqJsonEventType_arrayEnd, lqcJsonPropType_array, false);
+                    stream->state = (stream->depth == 0) ? parseState_done : parseState_commaOrClose;
+                    if (stream->depth == 0)
+                        stream->result = lqJsonResult_ok;
+                }
+                break;
+            }
+
+            case ':':
+                if (stream->state != parseState_colon)
+                    stream->result = lqJsonResult_invalid;
+                stream->state = parseState_value;
+                break;
+
+            case ',':
+                if (stream->state != parseState_commaOrClose)
+                    stream->result = lqJsonResult_invalid;
+                stream->state = inObject ? parseState_key : parseState_value;
+                break;
+
+            case '"':
+                if (stream->state != parseState_key && stream->state != parseState_keyOrClose && 
+                    stream->state != parseState_value && stream->state != parseState_valueOrClose)
+                    stream->result = lqJsonResult_invalid;
+                stream->scan = streamScan_string;                                       // state tells key from value
+                break;
+
+            default:
+                if ((stream->state != parseState_value && stream->state != parseState_valueOrClose) ||
+                    !(c == '-' || (c >= '0' && c <= '9') || c == 't' || c == 'f' || c == 'n'))
+                    stream->result = lqJsonResult_invalid;
+                stream->scan = streamScan_primitive;
+                continue;                                                               // primitive scan takes c
+        }
+        pos++;
+    }
+    return stream->result;
+}
+
+
+#pragma region Static Local Functions
+
+/**
+ *  @brief STATIC Scope: Append a token (document order) and link it as the last child of parent. Returns the token 
+ *  index, LQJSON_NONE if the token array is full.
+ */
+static uint16_t addToken(lqJsonIndex_t *index, uint16_t parent, lqJsonPropType_t type, uint16_t start, bool isKey)
+{
+    if (index->tokenCnt >= index->tokenCap)
+        return LQJSON_NONE;
+
+    uint16_t tok = index->tokenCnt++;
+    lqJsonToken_t *token = &index->tokens[tok];
+    token->start = start;
+    token->len = 0;
+    token->parent = parent;
+    token->next = LQJSON_NONE;
+    token->size = 0;
+    token->type = type;
+    token->isKey = isKey;
+
+    if (parent != LQJSON_NONE)
+    {
+        lqJsonToken_t *parentToken = &index->tokens[parent];
+        if (parentToken->size > 0)
+            index->tokens[parentToken->next].next = tok;                                // open parent's next is its last child
+        parentToken->next = tok;
+        parentToken->size++;
+    }
+    return tok;
+}
+
+
+/**
+ *  @brief STATIC Scope: A value (tok) is complete, step parent out to the enclosing container and return the next state.
+ */
+static parseState_t valueComplete(lqJsonIndex_t *index, uint16_t tok, uint16_t *parent)
+{
+    uint16_t valueParent = index->tokens[tok].parent;
+
+    if (valueParent == LQJSON_NONE)
+        return parseState_done;
+
+    if (index->tokens[valueParent].isKey)                                               // property value, key is done
+    {
+        index->tokens[valueParent].next = LQJSON_NONE;
+        valueParent = index->tokens[valueParent].parent;
+    }
+    *parent = valueParent;
+    return parseState_commaOrClose;
+}
+
+
+/**
+ *  @brief STATIC Scope: Scan a string from its opening quote at *pos, leaving *pos past the closing quote.
+ *  @details Quotes are located with memchr(), a quote is the closing quote unless preceded by an odd run of '\\'.
+ */
+static lqJsonResult_t scanString(const char *json, uint16_t jsonLen, uint16_t *pos)
+{
+    const char *scan = json + *pos + 1;
+    const char *jsonEnd = json + jsonLen;
+
+    while ((scan = memchr(scan, '"', jsonEnd - scan)) != NULL)
+    {
+        const char *escape = scan;
+        while (escape[-1] == '\\')                                                    // opening quote bounds the run
+            escape--;
+        if (((scan - escape) & 0x01) == 0)
+        {
+            *pos = scan - json + 1;
+            return lqJsonResult_ok;
+        }
+        scan++;                                                                         // escaped quote
+    }
+    return lqJsonResult_partial;
+}
+
+
+/**
+ *  @brief STATIC Scope: Scan a number or literal (true, false, null) at *pos, leaving *pos past it.
+ *  @details Numbers must follow the JSON grammar; one cut short by jsonLen is partial.
+ */
+static lqJsonResult_t scanPrimitive(const char *json, uint16_t jsonLen, uint16_t *pos, lqJsonPropType_t *type)
+{
+    static const char *literals[] = { "true", "false", "null" };
+    static const lqJsonPropType_t literalTypes[] = { lqcJsonPropType_bool, lqcJsonPropType_bool, lqcJsonPropType_null };
+    uint16_t scan = *pos;
+    char c = json[scan];
+
+    if (c == '-' || (c >= '0' && c <= '9'))
+    {
+        /* -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?, the char after is the caller's to judge */
+        *type = lqcJsonPropType_int;
+        if (c == '-')
+            scan++;
+        if (scan == jsonLen)
+            return lqJsonResult_partial;
+        if (json[scan] == '0')
+            scan++;
+        else if (!scanDigits(json, jsonLen, &scan))
+            return lqJsonResult_invalid;
+
+        if (scan < jsonLen && json[scan] == '.')
+        {
+            *type = lqcJsonPropType_float;
+            scan++;
+            if (scan == jsonLen)
+                return lqJsonResult_partial;
+            if (!scanDigits(json, jsonLen, &scan))
+                return lqJsonResult_invalid;
+        }
+        if (scan < jsonLen && (json[scan] == 'e' || json[scan] == 'E'))
+        {
+            *type = lqcJsonPropType_float;
+            scan++;
+            if (scan < jsonLen && (json[scan] == '+' || json[scan] == '-'))
+                scan++;
+            if (scan == jsonLen)
+                return lqJsonResult_partial;
+            if (!scanDigits(json, jsonLen, &scan))
+                return lqJsonResult_invalid;
+        }
+        *pos = scan;
+        return lqJsonResult_ok;
+    }
+
+    for (size_t i = 0; i < sizeof(literals) / sizeof(literals[0]); i++)
+    {
+        if (c != literals[i][0])
+            continue;
+        size_t literalLen = strlen(literals[i]);
+        size_t available = jsonLen - scan;
+        if (memcmp(json + scan, literals[i], (available < literalLen) ? available : literalLen) != 0)
+            return lqJsonResult_invalid;
+        if (available < literalLen)
+            return lqJsonResult_partial;
+        *type = literalTypes[i];
+        *pos = scan + literalLen;
+        return lqJsonResult_ok;
+    }
+    return lqJsonResult_invalid;
+}
+
+
+/**
+ *  @brief STATIC Scope: Parse the next path segment, advancing *path past it. Returns false if the path is malformed.
+ */
+static bool nextPathSegment(const char **path, pathSegment_t *segment)
+{
+    const char *scan = *path;
+
+    if (*scan == '.')
+        scan++;
+    if (*scan == '[')
+    {
+        uint32_t elementIndx = 0;
+        const char *digits = ++scan;
+        while (*scan >= '0' && *scan <= '9')
+            elementIndx = elementIndx * 10 + (*scan++ - '0');
+        if (scan == digits || *scan != ']' || elementIndx >= LQJSON_NONE)
+            return false;
+        segment->name = NULL;
+        segment->elementIndx = (uint16_t)elementIndx;
+        *path = scan + 1;
+        return true;
+    }
+
+    segment->name = scan;
+    while (*scan != '\0' && *scan != '.' && *scan != '[')
+        scan++;
+    segment->nameLen = scan - segment->name;
+    *path = scan;
+    return segment->nameLen > 0;
+}
+
+
+/**
+ *  @brief STATIC Scope: Scan a run of one or more decimal digits at *pos, leaving *pos past it.
+ */
+static bool scanDigits(const char *json, uint16_t jsonLen, uint16_t *pos)
+{
+    uint16_t start = *pos;
+
+    while (*pos < jsonLen && json[*pos] >= '0' && json[*pos] <= '9')
+        (*pos)++;
+    return *pos > start;
+}
+
+
+/**
+ *  @brief STATIC Scope: Position of the first non-whitespace char at or after pos (jsonLen if none).
+ */
+static uint16_t skipWhitespace(const char *json, uint16_t jsonLen, uint16_t pos)
+{
+    while (pos < jsonLen && (json[pos] == ' ' || json[pos] == '\t' || json[pos] == '\r' || json[pos] == '\n'))
+        pos++;
+    return pos;
+}
+
+
+/**
+ *  @brief STATIC Scope: Skip the complete value at *pos, leaving *pos past it and reporting its type. Objects and 
+ *  arrays are skipped by bracket matching (contents not validated), brackets inside strings are passed over with the strings.
+ */
+static lqJsonResult_t skipValue(const char *json, uint16_t jsonLen, uint16_t *pos, lqJsonPropType_t *type)
+{
+    char c = json[*pos];
+
+    if (c == '"')
+    {
+        *type = lqcJsonPropType_text;
+        return scanString(json, jsonLen, pos);
+    }
+    if (c != '{' && c != '[')
+        return scanPrimitive(json, jsonLen, pos, type);
+
+    *type = (c == '{') ? lqcJsonPropType_object : lqcJsonPropType_array;
+    uint16_t depth = 0;
+    uint16_t scan = *pos;
+    while (scan < jsonLen)
+    {
+        c = json[scan];
+        if (c == '"')
+        {
+            if (scanString(json, jsonLen, &scan) != lqJsonResult_ok)
+                return lqJsonResult_partial;
+            continue;
+        }
+        if (c == '{' || c == '[')
+            depth++;
+        else if ((c == '}' || c == ']') && --depth == 0)
+        {
+            *pos = scan + 1;
+            return lqJsonResult_ok;
+        }
+        scan++;
+    }
+    return lqJsonResult_partial;
+}
+
+
+
+/**
+ *  @brief STATIC Scope: Convert a property value into its bound field. Returns false (field unchanged) if it does not fit.
+ */
+static bool bindValue(const lqJsonBinding_t *binding, void *target, const char *value, uint16_t len, lqJsonPropType_t type)
+{
+    void *field = (uint8_t*)target + binding->offset;
+
+    switch (binding->type)
+    {
+        case lqJsonBindType_int:
+        case lqJsonBindType_uint:
+            return type == lqcJsonPropType_int && bindInteger(binding, field, value, len);
+
+        case lqJsonBindType_float:
+        {
+            char numberText[32];                                                        // value is not delimited in a stream's token buffer
+            if ((type != lqcJsonPropType_int && type != lqcJsonPropType_float) || len >= sizeof(numberText))
+                return false;
+            memcpy(numberText, value, len);
+            numberText[len] = '\0';
+            double number = strtod(numberText, NULL);
+            if (binding->size == sizeof(float))
+                *(float*)field = (float)number;
+            else if (binding->size == sizeof(double))
+                *(double*)field = number;
+            else
+                return false;
+            return true;
+        }
+
+        case lqJsonBindType_bool:
+            if (type != lqcJsonPropType_bool || binding->size != sizeof(bool))
+                return false;
+            *(bool*)field = (value[0] == 't');
+            return true;
+
+        case lqJsonBindType_text:
+            return type == lqcJsonPropType_text && bindText((char*)field, binding->size, value, len);
+    }
+    return false;
+}
+
+
+/**
+ *  @brief STATIC Scope: Convert a JSON integer into an int/uint field of 1, 2, 4 or 8 bytes, range checked.
+ */
+static bool bindInteger(const lqJsonBinding_t *binding, void *field, const char *value, uint16_t len)
+{
+    bool negative = (value[0] == '-');
+    uint64_t magnitude = 0;
+    uint64_t limit;
+
+    if (binding->size == 0 || binding->size > sizeof(uint64_t) || (binding->size & (binding->size - 1)) != 0)
+        return false;
+    if (binding->type == lqJsonBindType_uint)
+        limit = (binding->size == 8) ? UINT64_MAX : ((uint64_t)1 << (binding->size * 8)) - 1;
+    else
+        limit = ((uint64_t)1 << (binding->size * 8 - 1)) - (negative ? 0 : 1);          // one more below zero
+
+    for (uint16_t i = negative ? 1 : 0; i < len; i++)
+    {
+        uint8_t digit = value[i] - '0';
+        if (digit > 9 || magnitude > (limit - digit) / 10)
+            return false;
+        magnitude = magnitude * 10 + digit;
+    }
+    if (negative && binding->type == lqJsonBindType_uint && magnitude > 0)
+        return false;
+
+    if (binding->type == lqJsonBindType_uint)
+    {
+        switch (binding->size)
+        {
+            case 1: *(uint8_t*)field = (uint8_t)magnitude; break;
+            case 2: *(uint16_t*)field = (uint16_t)magnitude; break;
+            case 4: *(uint32_t*)field = (uint32_t)magnitude; break;
+            default: *(uint64_t*)field = magnitude; break;
+        }
+        return true;
+    }
+    int64_t number = negative ? (int64_t)(0 - magnitude) : (int64_t)magnitude;
+    switch (binding->size)
+    {
+        case 1: *(int8_t*)field = (int8_t)number; break;
+        case 2: *(int16_t*)field = (int16_t)number; break;
+        case 4: *(int32_t*)field = (int32_t)number; break;
+        default: *(int64_t*)field = number; break;
+    }
+    return true;
+}
+
+
+/**
+ *  @brief STATIC Scope: Copy JSON string content into a char[] field, decoding escapes (\uXXXX to UTF-8). Returns 
+ *  false if truncated to fit (field NULL terminated), or if a \u escape is not 4 hex digits or is \u0000 (field unchanged).
+ */
+static bool bindText(char *field, uint16_t fieldSz, const char *value, uint16_t len)
+{
+    uint16_t out = 0;
+    uint16_t codePoint;
+
+    if (fieldSz == 0)
+        return false;
+    for (uint16_t i = 0; i + 1 < len; i++)                                              // \u must be 4 hex digits, not NUL
+    {
+        if (value[i] == '\\' && value[++i] == 'u' && (i + 4 >= len || !decodeHex4(value + i + 1, &codePoint) || codePoint == 0))
+            return false;                                                               // field unchanged
+    }
+
+    for (uint16_t i = 0; i < len; i++)
+    {
+        char utf8[3];
+        uint8_t utf8Len = 1;
+        utf8[0] = value[i];
+
+        if (value[i] == '\\' && i + 1 < len)
+        {
+            switch (value[++i])
+            {
+                case 'b': utf8[0] = '\b'; break;
+                case 'f': utf8[0] = '\f'; break;
+                case 'n': utf8[0] = '\n'; break;
+                case 'r': utf8[0] = '\r'; break;
+                case 't': utf8[0] = '\t'; break;
+                case 'u':
+                {
+                    decodeHex4(value + i + 1, &codePoint);
+                    i += 4;
+                    if (codePoint < 0x80)
+                        utf8[0] = (char)codePoint;
+                    else if (codePoint < 0x800)
+                    {
+                        utf8[0] = (char)(0xC0 | (codePoint >> 6));
+                        utf8[1] = (char)(0x80 | (codePoint & 0x3F));
+                        utf8Len = 2;
+                    }
+                    else                                                                // surrogate pairs are not combined
+                    {
+                        utf8[0] = (char)(0xE0 | (codePoint >> 12));
+                        utf8[1] = (char)(0x80 | ((codePoint >> 6) & 0x3F));
+                        utf8[2] = (char)(0x80 | (codePoint & 0x3F));
+                        utf8Len = 3;
+                    }
+                    break;
+                }
+                default: utf8[0] = value[i]; break;                                     // \" \\ \/
+            }
+        }
+        if (out + utf8Len >= fieldSz)
+        {
+            field[out] = '\0';
+            return false;
+        }
+        memcpy(field + out, utf8, utf8Len);
+        out += utf8Len;
+    }
+    field[out] = '\0';
+    return true;
+}
+
+
+/**
+ *  @brief STATIC Scope: Decode the 4 hex digits of a \u escape, false if any is not a hex digit.
+ */
+static bool decodeHex4(const char *hex, uint16_t *codePoint)
+{
+    *codePoint = 0;
+    for (uint8_t h = 0; h < 4; h++)
+    {
+        char c = hex[h];
+        if (c >= '0' && c <= '9')
+            c -= '0';
+        else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f')
+            c = (c | 0x20) - 'a' + 10;
+        else
+            return false;
+        *codePoint = (*codePoint << 4) | (uint8_t)c;
+    }
+    return true;
+}
+
+
+/**
+ *  @brief STATIC Scope: Bind one property if its key has a binding, updating the present/mismatch bits.
+ */
+static void bindProperty(const lqJsonBinding_t *bindings, uint8_t bindingCnt, void *target, lqJsonBindStatus_t *status, 
+                         const char *key, uint16_t keyLen, const char *value, uint16_t len, lqJsonPropType_t type)
+{
+    for (uint8_t i = 0; i < bindingCnt; i++)
+    {
+        const char *bindKey = bindings[i].key;
+        if ((keyLen == 0 || bindKey[0] == key[0]) && strncmp(bindKey, key, keyLen) == 0 && bindKey[keyLen] == '\0')
+        {
+            status->present |= (uint32_t)1 << i;
+            if (bindValue(&bindings[i], target, value, len, type))
+                status->mismatch &= ~((uint32_t)1 << i);                                // duplicate key, last wins
+            else
+                status->mismatch |= (uint32_t)1 << i;
+            return;
+        }
+    }
+}
+
+
+/**
+ *  @brief STATIC Scope: Add chars to the key (while reading a key) or the scalar value in the token buffer. Sets 
+ *  result noTokens and returns false if the buffer is full.
+ */
+static bool streamAppend(lqJsonStream_t *stream, const char *src, uint16_t srcLen)
+{
+    uint16_t used = stream->keyLen + stream->valueLen;
+
+    if (srcLen > stream->tokenSz - used)
+    {
+        stream->result = lqJsonResult_noTokens;
+        return false;
+    }
+    memcpy(stream->token + used, src, srcLen);
+    if (stream->state == parseState_key || stream->state == parseState_keyOrClose)
+        stream->keyLen += srcLen;
+    else
+        stream->valueLen += srcLen;
+    return true;
+}
+
+
+/**
+ *  @brief STATIC Scope: Continue a key or text value from *pos, copying runs up to the next quote or backslash. 
+ *  Completes the string at its closing quote, else consumes the rest of the chunk.
+ */
+static lqJsonResult_t streamString(lqJsonStream_t *stream, const char *chunk, uint16_t chunkLen, uint16_t *pos)
+{
+    uint16_t runStart = *pos;
+    uint16_t scan = *pos;
+
+    if (stream->scan == streamScan_escape)                                              // char after '\' is taken as is
+    {
+        stream->scan = streamScan_string;
+        scan++;
+    }
+    while (scan < chunkLen && chunk[scan] != '"' && chunk[scan] != '\\')
+        scan++;
+    if (scan < chunkLen && chunk[scan] == '\\')
+    {
+        stream->scan = streamScan_escape;
+        scan++;
+    }
+    if (!streamAppend(stream, chunk + runStart, scan - runStart))
+        return lqJsonResult_noTokens;
+    *pos = scan;
+
+    if (scan < chunkLen && chunk[scan] == '"' && stream->scan == streamScan_string)
+    {
+        (*pos)++;
+        stream->scan = streamScan_none;
+        if (stream->state == parseState_key || stream->state == parseState_keyOrClose)
+            stream->state = parseState_colon;
+        else
+            streamValue(stream, lqcJsonPropType_text);
+    }
+    return stream->result;
+}
+
+
+/**
+ *  @brief STATIC Scope: A scalar value is complete: report and bind it, then clear the token buffer.
+ */
+static void streamValue(lqJsonStream_t *stream, lqJsonPropType_t type)
+{
+    bool inObject = (stream->depth > 0) && (stream->isObject & ((uint32_t)1 << (stream->depth - 1)));
+
+    streamEvent(stream, lqJsonEventType_value, type, inObject);
+    if (inObject && stream->depth == 1 && stream->bindings != NULL)
+        bindProperty(stream->bindings, stream->bindingCnt, stream->target, &stream->status, 
+                     stream->token, stream->keyLen, stream->token + stream->keyLen, stream->valueLen, type);
+
+    stream->keyLen = 0;
+    stream->valueLen = 0;
+    stream->state = (stream->depth == 0) ? parseState_done : parseState_commaOrClose;
+    if (stream->depth == 0)
+        stream->result = lqJsonResult_ok;
+}
+
+
+/**
+ *  @brief STATIC Scope: Invoke the event callback, if any.
+ */
+static void streamEvent(lqJsonStream_t *stream, lqJsonEventType_t eventType, lqJsonPropType_t type, bool withKey)
+{
+    if (stream->eventCB == NULL)
+        return;
+
+    lqJsonEvent_t event;
+    event.eventType = eventType;
+    event.type = type;
+    event.key = withKey ? stream->token : NULL;
+    event.keyLen = withKey ? stream->keyLen : 0;
+    event.value = (eventType == lqJsonEventType_value) ? stream->token + stream->keyLen : NULL;
+    event.len = (eventType == lqJsonEventType_value) ? stream->valueLen : 0;
+    event.depth = stream->depth;
+    stream->eventCB(stream->context, &event);
+}
+
+#pragma endregion
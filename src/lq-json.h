@@ -0,0 +1,382 @@
+/******************************************************************************
+ *  \file lq-json.h
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2022 LooUQ Incorporated.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ ******************************************************************************
+ * JSON document index: one pass tokenizer and lookups over the token array
+ *
+ * lq_jsonIndex() scans a document once into a caller supplied token array
+ * (no allocation, document is not modified). Property lookups then walk the
+ * token links instead of rescanning the text. Results are lqJsonPropValue_t,
+ * the same as lq_getJsonPropValue():
+ *
+ *   lqJsonToken_t tokens[32];
+ *   lqJsonIndex_t index;
+ *   if (lq_jsonIndex(&index, json, strlen(json), tokens, 32) == lqJsonResult_ok)
+ *   {
+ *       lqJsonPropValue_t interval = lq_jsonGetPropValue(&index, LQJSON_ROOT, "interval");
+ *       lqJsonPropValue_t site = lq_jsonGetPathValue(&index, LQJSON_ROOT, "params.sites[2].name");
+ *       ...
+ *   }
+ *
+ * The index is for structure, not speed. Tokenizing validates the whole
+ * document and visits every char outside strings, so it costs more than
+ * the memchr/strstr scans behind lq_getJsonPropValue() for flat lookups
+ * (json-bench: still behind reading all 12 properties of a 430 byte
+ * command). Use it for nested paths, array elements, sibling iteration or
+ * a document that must be valid; scan the text for flat properties.
+ *
+ * Paths are property names separated by '.' with [n] array element indexes,
+ * ex: "params.notify.email", "tags[2].site", "[0].id" (root array). Names
+ * containing '.' or '[' cannot be addressed by path.
+ *
+ * Binding fills a struct from an object's properties in one pass, no index:
+ *
+ *   typedef struct { int32_t interval; bool ack; float level; char mode[8]; } config_t;
+ *   static const lqJsonBinding_t configBindings[] = {
+ *       LQJSON_BIND(config_t, interval, "interval", lqJsonBindType_int),
+ *       LQJSON_BIND(config_t, ack, "ack", lqJsonBindType_bool),
+ *       LQJSON_BIND(config_t, level, "level", lqJsonBindType_float),
+ *       LQJSON_BIND(config_t, mode, "mode", lqJsonBindType_text)
+ *   };
+ *   lqJsonBindStatus_t status;
+ *   lq_jsonBind(json, strlen(json), configBindings, 4, &config, &status);
+ *   if (status.present & (1 << 0)) ...                     // bit n is configBindings[n]
+ *
+ * Streaming parses a document as it arrives in chunks, only the current key
+ * and scalar value are held (in a caller supplied token buffer):
+ *
+ *   lq_jsonStreamInit(&stream, tokenBuffer, sizeof(tokenBuffer), onEvent, NULL);
+ *   lq_jsonStreamBind(&stream, configBindings, 4, &config);  // optional
+ *   while (result == lqJsonResult_partial && (blockSz = bbffr_popBlock(&rxBuffer, &block, 256)) > 0)
+ *   {
+ *       result = lq_jsonStreamFeed(&stream, block, blockSz);
+ *       bbffr_popBlockFinalize(&rxBuffer, true);
+ *   }
+ *****************************************************************************/
+
+#ifndef __LQ_JSON_H__
+#define __LQ_JSON_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "lq-collections.h"
+
+#define LQJSON_ROOT 0                                       ///< Token index of the document's root value
+#define LQJSON_NONE 0xFFFF                                  ///< Token link/result signalling no token (NOT FOUND)
+#define LQJSON_BIND_MAX 32                                  ///< Max bindings in one table (one status bit each)
+#define LQJSON_STREAM_MAXDEPTH 32                           ///< Max nesting of objects/arrays in a streamed document
+
+/**
+ * @brief Declare a binding of a JSON property to a struct field.
+ */
+#define LQJSON_BIND(STRUCT, FIELD, KEY, TYPE) { (KEY), (TYPE), offsetof(STRUCT, FIELD), sizeof(((STRUCT*)0)->FIELD) }
+
+
+/**
+ * @brief Outcome of indexing (tokenizing) a document.
+ */
+typedef enum lqJsonResult_tag
+{
+    lqJsonResult_ok = 0,                                    ///< Document indexed
+    lqJsonResult_noTokens = 1,                              ///< Token array too small for the document
+    lqJsonResult_invalid = 2,                               ///< Document is not valid JSON, index is incomplete
+    lqJsonResult_partial = 3                                ///< Document ends before its root value is complete
+} lqJsonResult_t;
+
+
+/**
+ * @brief One JSON value (or object property key), 12 bytes.
+ * @details Tokens are stored in document order, so a container's first child is the next token. Object children are 
+ * the property key tokens, each key's single child (following it) is the property value. Array children are the 
+ * element values. Siblings are linked through next.
+ */
+typedef struct lqJsonToken_tag
+{
+    uint16_t start;                                         ///< Offset in document; strings at first char inside the quotes
+    uint16_t len;                                           ///< Length; strings exclude quotes (escapes not decoded), containers include brackets
+    uint16_t parent;                                        ///< Token index of containing object/array (key for a property value), LQJSON_NONE for root
+    uint16_t next;                                          ///< Token index of next sibling, LQJSON_NONE if last
+    uint16_t size;                                          ///< Number of children: object properties, array elements, 1 for a key
+    uint8_t type;                                           ///< lqJsonPropType_t value
+    uint8_t isKey;                                          ///< Token is an object property key (type text)
+} lqJsonToken_t;
+
+
+/**
+ * @brief Index over a tokenized document. The document must stay in scope, tokens reference it by offset.
+ */
+typedef struct lqJsonIndex_tag
+{
+    const char *json;                                       ///< The indexed document
+    lqJsonToken_t *tokens;                                  ///< Caller supplied token array
+    uint16_t tokenCap;                                      ///< Size of tokens array
+    uint16_t tokenCnt;                                      ///< Tokens in use
+} lqJsonIndex_t;
+
+
+/**
+ * @brief C type of a bound field, the field's size selects the width.
+ */
+typedef enum lqJsonBindType_tag
+{
+    lqJsonBindType_int = 0,                                 ///< int8_t, int16_t, int32_t or int64_t from a JSON integer
+    lqJsonBindType_uint = 1,                                ///< uint8_t, uint16_t, uint32_t or uint64_t from a non-negative JSON integer
+    lqJsonBindType_float = 2,                               ///< float or double from a JSON number
+    lqJsonBindType_bool = 3,                                ///< bool from true/false
+    lqJsonBindType_text = 4                                 ///< char[] from a JSON string, escapes decoded and NULL terminated; bad \u or \u0000 is a mismatch
+} lqJsonBindType_t;
+
+
+/**
+ * @brief One entry of a caller's (static const) binding table.
+ */
+typedef struct lqJsonBinding_tag
+{
+    const char *key;                                        ///< JSON property name
+    lqJsonBindType_t type;                                  ///< Field's C type
+    uint16_t offset;                                        ///< offsetof() the field in the target struct
+    uint16_t size;                                          ///< sizeof() the field
+} lqJsonBinding_t;
+
+
+/**
+ * @brief Per binding outcome of lq_jsonBind(), bit n reports bindings[n].
+ */
+typedef struct lqJsonBindStatus_tag
+{
+    uint32_t present;                                       ///< Property found in the object
+    uint32_t mismatch;                                      ///< Property found but its value does not fit the field (wrong type, out of range, 
+                                                            ///< text truncated); field is not changed, except truncated text
+} lqJsonBindStatus_t;
+
+
+/**
+ * @brief Streaming parser event kinds.
+ */
+typedef enum lqJsonEventType_tag
+{
+    lqJsonEventType_value = 0,                              ///< Scalar value complete (text, number, bool, null)
+    lqJsonEventType_objectStart = 1,
+    lqJsonEventType_objectEnd = 2,
+    lqJsonEventType_arrayStart = 3,
+    lqJsonEventType_arrayEnd = 4
+} lqJsonEventType_t;
+
+
+/**
+ * @brief Streaming parser event, key and value point into the token buffer and are valid during the callback only.
+ */
+typedef struct lqJsonEvent_tag
+{
+    lqJsonEventType_t eventType;                            ///< What completed/started
+    lqJsonPropType_t type;                                  ///< Value's type (object/array for container events)
+    const char *key;                                        ///< Property key of the value/container, NULL for array elements and root
+    uint16_t keyLen;                                        ///< Length of key
+    const char *value;                                      ///< Scalar value text (strings without quotes, escapes not decoded), NULL for containers
+    uint16_t len;                                           ///< Length of value
+    uint8_t depth;                                          ///< Nesting of the value/container, root is 0
+} lqJsonEvent_t;
+
+typedef void (*lqJsonEvent_func)(void *context, const lqJsonEvent_t *event);
+
+
+/**
+ * @brief Streaming parser state, persists between chunks. Set up with lq_jsonStreamInit().
+ */
+typedef struct lqJsonStream_tag
+{
+    char *token;                                            ///< Caller supplied buffer: current key followed by current scalar value
+    uint16_t tokenSz;                                       ///< Size of token buffer, largest key + largest scalar value
+    uint16_t keyLen;                                        ///< Chars of key held at start of token
+    uint16_t valueLen;                                      ///< Chars of scalar value held after key
+    uint8_t state;                                          ///< What the next structural char may be
+    uint8_t scan;                                           ///< Inside a string, string escape or number/literal across chunks
+    uint8_t depth;                                          ///< Open objects/arrays
+    uint32_t isObject;                                      ///< Bit per depth, container is an object (else array)
+    lqJsonResult_t result;                                  ///< partial until the root value completes, then ok; or the error
+    lqJsonEvent_func eventCB;                               ///< Event callback, NULL if only binding
+    void *context;                                          ///< Passed to eventCB
+    const lqJsonBinding_t *bindings;                        ///< Root object properties to bind, NULL for none
+    uint8_t bindingCnt;                                     ///< Entries in bindings
+    void *target;                                           ///< Struct receiving bound values
+    lqJsonBindStatus_t status;                              ///< Bind present/mismatch bits
+} lqJsonStream_t;
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+
+/**
+ *  @brief Tokenize a JSON document in a single pass into a token index.
+ * 
+ *  @param [out] index - The index to populate.
+ *  @param [in] json - The JSON document, need not be NULL terminated.
+ *  @param [in] jsonLen - Length of the document (max 65535).
+ *  @param [in] tokens - Caller supplied token array, one token per value plus one per object property key.
+ *  @param [in] tokenCap - Number of tokens in array.
+ *  @return Result of indexing, lookups are valid only if lqJsonResult_ok.
+*/
+lqJsonResult_t lq_jsonIndex(lqJsonIndex_t *index, const char *json, uint16_t jsonLen, lqJsonToken_t *tokens, uint16_t tokenCap);
+
+
+/**
+ *  @brief Find an object's property by name.
+ * 
+ *  @param [in] index - The document index.
+ *  @param [in] objectTok - Token index of the object to search (LQJSON_ROOT for the document root).
+ *  @param [in] propName - Property name to find.
+ *  @return Token index of the property's value, LQJSON_NONE if not found (or objectTok is not an object).
+*/
+uint16_t lq_jsonFindProp(const lqJsonIndex_t *index, uint16_t objectTok, const char *propName);
+
+
+/**
+ *  @brief Get the value of a token as a lqJsonPropValue_t (same form as lq_getJsonPropValue() results).
+ * 
+ *  @param [in] index - The document index.
+ *  @param [in] tok - Token index, LQJSON_NONE gives a lqcJsonPropType_notFound result.
+ *  @return Struct with a pointer to the value in the document, its length and type.
+*/
+lqJsonPropValue_t lq_jsonGetValue(const lqJsonIndex_t *index, uint16_t tok);
+
+
+/**
+ *  @brief Get an object property's value, the index equivalent of lq_getJsonPropValue() (scoped to one object).
+ * 
+ *  @param [in] index - The document index.
+ *  @param [in] objectTok - Token index of the object to search (LQJSON_ROOT for the document root).
+ *  @param [in] propName - Property name to find.
+ *  @return Struct with a pointer to the property value, its length and type (lqcJsonPropType_notFound if not found).
+*/
+lqJsonPropValue_t lq_jsonGetPropValue(const lqJsonIndex_t *index, uint16_t objectTok, const char *propName);
+
+
+/**
+ *  @brief Get an array element.
+ * 
+ *  @param [in] index - The document index.
+ *  @param [in] arrayTok - Token index of the array.
+ *  @param [in] elementIndx - Zero based element index.
+ *  @return Token index of the element, LQJSON_NONE if out of range (or arrayTok is not an array).
+*/
+uint16_t lq_jsonGetElement(const lqJsonIndex_t *index, uint16_t arrayTok, uint16_t elementIndx);
+
+
+/**
+ *  @brief Resolve a path (ex: "params.thresholds[2]") to a token, each step follows sibling links past whole subtrees.
+ * 
+ *  @param [in] index - The document index.
+ *  @param [in] fromTok - Token index the path is relative to (LQJSON_ROOT for the document root).
+ *  @param [in] path - Dotted/indexed path, see file header.
+ *  @return Token index of the value at path, LQJSON_NONE if not found or the path is malformed.
+*/
+uint16_t lq_jsonFindPath(const lqJsonIndex_t *index, uint16_t fromTok, const char *path);
+
+
+/**
+ *  @brief Get the value at a path.
+ * 
+ *  @param [in] index - The document index.
+ *  @param [in] fromTok - Token index the path is relative to (LQJSON_ROOT for the document root).
+ *  @param [in] path - Dotted/indexed path, see file header.
+ *  @return Struct with a pointer to the value, its length and type (lqcJsonPropType_notFound if not found).
+*/
+lqJsonPropValue_t lq_jsonGetPathValue(const lqJsonIndex_t *index, uint16_t fromTok, const char *path);
+
+
+/**
+ *  @brief Get the value at a path directly from the document text, no index (for a single lookup).
+ *  @details Depth aware: only keys of the object being walked are compared, property values and array elements that 
+ *  are not on the path are skipped whole by bracket matching (strings skipped quote to quote).
+ * 
+ *  @param [in] json - The JSON document, need not be NULL terminated.
+ *  @param [in] jsonLen - Length of the document.
+ *  @param [in] path - Dotted/indexed path, see file header.
+ *  @return Struct with a pointer to the value, its length and type (lqcJsonPropType_notFound if not found).
+*/
+lqJsonPropValue_t lq_jsonScanPathValue(const char *json, uint16_t jsonLen, const char *path);
+
+
+/**
+ *  @brief Fill struct fields from an object's properties in one pass over the text, no index or intermediate strings.
+ *  @details Properties without a binding are skipped whole. Fields for absent properties are not changed. To bind a 
+ *  nested object, locate it with lq_jsonScanPathValue() and bind its value with a second table.
+ * 
+ *  @param [in] json - The JSON object text, need not be NULL terminated.
+ *  @param [in] jsonLen - Length of the text.
+ *  @param [in] bindings - Binding table, entries past LQJSON_BIND_MAX are ignored.
+ *  @param [in] bindingCnt - Number of entries in bindings.
+ *  @param [out] target - The struct to fill.
+ *  @param [out] status - Per binding present and mismatch bits.
+ *  @return lqJsonResult_ok if the whole object was read; invalid or partial text stops binding where found.
+*/
+lqJsonResult_t lq_jsonBind(const char *json, uint16_t jsonLen, const lqJsonBinding_t *bindings, uint8_t bindingCnt, void *target, lqJsonBindStatus_t *status);
+
+
+/**
+ *  @brief Start a streamed (chunk by chunk) document parse.
+ * 
+ *  @param [out] stream - Parser state to initialize.
+ *  @param [in] tokenBuffer - Holds the current key and scalar value while they span chunks.
+ *  @param [in] tokenBufferSz - Size of tokenBuffer, longest key plus longest scalar value (strings without quotes).
+ *  @param [in] eventCB - Called for each value and container start/end, NULL for none.
+ *  @param [in] context - Passed to eventCB.
+*/
+void lq_jsonStreamInit(lqJsonStream_t *stream, char *tokenBuffer, uint16_t tokenBufferSz, lqJsonEvent_func eventCB, void *context);
+
+
+/**
+ *  @brief Fill struct fields from the root object's scalar properties as they complete (see lq_jsonBind()).
+ *  @details Call after lq_jsonStreamInit(), results are in stream->status.
+ * 
+ *  @param [in] stream - The parser.
+ *  @param [in] bindings - Binding table, entries past LQJSON_BIND_MAX are ignored.
+ *  @param [in] bindingCnt - Number of entries in bindings.
+ *  @param [out] target - The struct to fill.
+*/
+void lq_jsonStreamBind(lqJsonStream_t *stream, const lqJsonBinding_t *bindings, uint8_t bindingCnt, void *target);
+
+
+/**
+ *  @brief Parse the next chunk of the document, chunks may split the text anywhere (ex: inside a string or number).
+ *  @details A number or literal is complete when the char following it arrives, a root value that is a bare number 
+ *  is therefore never complete; documents are expected to be objects or arrays.
+ * 
+ *  @param [in] stream - The parser.
+ *  @param [in] chunk - Next chars of the document.
+ *  @param [in] chunkLen - Number of chars in chunk.
+ *  @return partial: need more chunks; ok: root value complete (only whitespace may follow); invalid: not JSON; 
+ *  noTokens: a key + value exceeds the token buffer or nesting exceeds LQJSON_STREAM_MAXDEPTH. Errors are sticky.
+*/
+lqJsonResult_t lq_jsonStreamFeed(lqJsonStream_t *stream, const char *chunk, uint16_t chunkLen);
+
+
+#ifdef __cplusplus
+}
+#endif // !__cplusplus
+
+#endif  /* !__LQ_JSON_H__ */
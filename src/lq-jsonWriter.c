@@ -0,0 +1,499 @@
+/******************************************************************************
+ *  \file lq-jsonWriter.h
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2022 LooUQ Incorporated.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ ******************************************************************************
+ * JSON writer: incremental serialization into a char array or bbuffer
+ *****************************************************************************/
+
+#include <lq-embed.h>
+#define LOG_LEVEL LOGLEVEL_DBG
+//#define DISABLE_ASSERTS                                   // ASSERT/ASSERT_W enabled by default, can be disabled 
+#define SRCFILE "JSW"                                       // create SRCFILE (3 char) MACRO for lq-diagnostics ASSERT
+
+#include <string.h>
+
+#include "lq-jsonWriter.h"
+
+#ifndef MIN
+    #define MIN(x, y) (((x) < (y)) ? (x) : (y))
+#endif
+
+static const char digitPairs[] = 
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static const double scales[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+static const uint32_t scalesInt[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+
+
+#pragma region Local Static Function Declarations
+static void emit(lqJsonWriter_t *writer, const char *src, uint16_t srcLen);
+static void emitChar(lqJsonWriter_t *writer, char c);
+static bool nextBlock(lqJsonWriter_t *writer);
+static void beginValue(lqJsonWriter_t *writer, bool isKey);
+static void openContainer(lqJsonWriter_t *writer, char open);
+static void closeContainer(lqJsonWriter_t *writer, char close);
+static void writeString(lqJsonWriter_t *writer, const char *text, uint16_t textLen);
+static uint8_t formatDigits(char *end, uint32_t value, uint8_t minDigits);
+static uint8_t formatUint64(char *end, uint64_t value);
+#pragma endregion
+
+
+/**
+ *  @brief Start a document in a char array.
+*/
+void lq_jsonWriterInit(lqJsonWriter_t *writer, char *buffer, uint16_t bufferSz)
+{
+    memset(writer, 0, sizeof(lqJsonWriter_t));
+    if (bufferSz > 0)
+    {
+        writer->block = buffer;
+        writer->blockSz = bufferSz - 1;                                                 // keep room for NULL terminator
+    }
+}
+
+
+/**
+ *  @brief Start a document streamed into a bbuffer, first block is taken at the first write.
+*/
+void lq_jsonWriterInitBbffr(lqJsonWriter_t *writer, bbuffer_t *bbffr)
+{
+    memset(writer, 0, sizeof(lqJsonWriter_t));
+    writer->bbffr = bbffr;
+}
+
+
+/**
+ *  @brief Complete the document.
+*/
+uint32_t lq_jsonWriterFinish(lqJsonWriter_t *writer)
+{
+    bool complete = !writer->overflow && !writer->invalid && writer->depth == 0 && !writer->afterKey;
+
+    if (writer->bbffr != NULL)
+    {
+        if (complete)                                                                   // publish the whole document at once
+            bbffr_skipHead(writer->bbffr, writer->pending + writer->blockLen);
+        writer->block = NULL;
+    }
+    else if (writer->block != NULL)
+        writer->block[writer->blockLen] = '\0';
+
+    return complete ? writer->written : 0;
+}
+
+
+/**
+ *  @brief Open an object.
+*/
+void lq_jsonWriteObjectStart(lqJsonWriter_t *writer)
+{
+    openContainer(writer, '{');
+}
+
+
+/**
+ *  @brief Close the innermost open object.
+*/
+void lq_jsonWriteObjectEnd(lqJsonWriter_t *writer)
+{
+    closeContainer(writer, '}');
+}
+
+
+/**
+ *  @brief Open an array.
+*/
+void lq_jsonWriteArrayStart(lqJsonWriter_t *writer)
+{
+    openContainer(writer, '[');
+}
+
+
+/**
+ *  @brief Close the innermost open array.
+*/
+void lq_jsonWriteArrayEnd(lqJsonWriter_t *writer)
+{
+    closeContainer(writer, ']');
+}
+
+
+/**
+ *  @brief Write an object property key.
+*/
+void lq_jsonWriteKey(lqJsonWriter_t *writer, const char *key)
+{
+    beginValue(writer, true);
+    writeString(writer, key, strlen(key));
+    emitChar(writer, ':');
+    writer->afterKey = true;
+}
+
+
+/**
+ *  @brief Write a string value.
+*/
+void lq_jsonWriteText(lqJsonWriter_t *writer, const char *text)
+{
+    lq_jsonWriteTextN(writer, text, strlen(text));
+}
+
+
+/**
+ *  @brief Write a string value from a char span.
+*/
+void lq_jsonWriteTextN(lqJsonWriter_t *writer, const char *text, uint16_t textLen)
+{
+    beginValue(writer, false);
+    writeString(writer, text, textLen);
+}
+
+
+/**
+ *  @brief Write a signed integer value.
+*/
+void lq_jsonWriteInt(lqJsonWriter_t *writer, int32_t value)
+{
+    char digits[11];
+    uint32_t magnitude = (value < 0) ? 0 - (uint32_t)value : (uint32_t)value;
+    uint8_t len = formatDigits(digits + sizeof(digits), magnitude, 1);
+
+    if (value < 0)
+        digits[sizeof(digits) - ++len] = '-';
+    beginValue(writer, false);
+    emit(writer, digits + sizeof(digits) - len, len);
+}
+
+
+/**
+ *  @brief Write an unsigned integer value.
+*/
+void lq_jsonWriteUint(lqJsonWriter_t *writer, uint32_t value)
+{
+    char digits[10];
+    uint8_t len = formatDigits(digits + sizeof(digits), value, 1);
+
+    beginValue(writer, false);
+    emit(writer, digits + sizeof(digits) - len, len);
+}
+
+
+/**
+ *  @brief Write a number with a fixed count of decimals, integer arithmetic formatting.
+*/
+void lq_jsonWriteFloat(lqJsonWriter_t *writer, double value, uint8_t decimals)
+{
+    const double wholeLimit = 18446744073709549568.0;                                   // largest double below 2^64
+    bool negative = (value < 0);
+    double magnitude = negative ? -value : value;
+
+    if (!(magnitude <= wholeLimit))                                                     // NaN, infinity or too large
+    {
+        lq_jsonWriteNull(writer);
+        return;
+    }
+    if (decimals > 9)
+        decimals = 9;
+    while (decimals > 0 && magnitude * scales[decimals] + 0.5 > wholeLimit)
+        decimals--;
+
+    char digits[32];
+    char *end = digits + sizeof(digits);
+    uint64_t scaled = (uint64_t)(magnitude * scales[decimals] + 0.5);
+    uint8_t len = 0;
+
+    if (scaled == 0)
+        negative = false;                                                               // no "-0.00"
+    if (decimals > 0)
+    {
+        len = formatDigits(end, (uint32_t)(scaled % scalesInt[decimals]), decimals);
+        end[-++len] = '.';
+        scaled /= scalesInt[decimals];
+    }
+    len += formatUint64(end - len, scaled);
+    if (negative)
+        end[-++len] = '-';
+
+    beginValue(writer, false);
+    emit(writer, end - len, len);
+}
+
+
+/**
+ *  @brief Write true or false.
+*/
+void lq_jsonWriteBool(lqJsonWriter_t *writer, bool value)
+{
+    beginValue(writer, false);
+    if (value)
+        emit(writer, "true", 4);
+    else
+        emit(writer, "false", 5);
+}
+
+
+/**
+ *  @brief Write null.
+*/
+void lq_jsonWriteNull(lqJsonWriter_t *writer)
+{
+    beginValue(writer, false);
+    emit(writer, "null", 4);
+}
+
+
+/**
+ *  @brief Write an already serialized JSON value as is.
+*/
+void lq_jsonWriteRaw(lqJsonWriter_t *writer, const char *json, uint16_t jsonLen)
+{
+    beginValue(writer, false);
+    emit(writer, json, jsonLen);
+}
+
+
+#pragma region Static Local Functions
+
+/**
+ *  @brief STATIC Scope: Copy chars to the destination, moving to the next bbuffer block as each fills. Once the
+ *  destination is full all further output is dropped (counted, not written) so the document is never spliced.
+ */
+static void emit(lqJsonWriter_t *writer, const char *src, uint16_t srcLen)
+{
+    writer->written += srcLen;
+    while (srcLen > 0 && !writer->overflow)
+    {
+        if (writer->blockLen == writer->blockSz && !nextBlock(writer))
+        {
+            writer->overflow = true;
+            return;
+        }
+        uint16_t copyLen = MIN(srcLen, writer->blockSz - writer->blockLen);
+        memcpy(writer->block + writer->blockLen, src, copyLen);
+        writer->blockLen += copyLen;
+        src += copyLen;
+        srcLen -= copyLen;
+    }
+}
+
+
+/**
+ *  @brief STATIC Scope: Single char emit, fast path when the window has room.
+ */
+static void emitChar(lqJsonWriter_t *writer, char c)
+{
+    if (writer->blockLen < writer->blockSz && !writer->overflow)
+    {
+        writer->block[writer->blockLen++] = c;
+        writer->written++;
+    }
+    else
+        emit(writer, &c, 1);
+}
+
+
+/**
+ *  @brief STATIC Scope: Take the next bbuffer window (after the wrap, or space the consumer freed) past the chars 
+ *  written so far, nothing is published. False if there is no next window: writing to a char array, or the bbuffer is full.
+ */
+static bool nextBlock(lqJsonWriter_t *writer)
+{
+    if (writer->bbffr == NULL)
+        return false;
+
+    bbffrSpan_t spans[2];
+    writer->pending += writer->blockLen;                                                // unpublished, vacant may have grown
+    bbffr_pushSpans(writer->bbffr, spans, (bbffrSz_t)~0);
+
+    uint32_t at = writer->pending;
+    uint8_t span = (at < spans[0].len) ? 0 : 1;
+    if (span == 1)
+        at -= spans[0].len;
+    writer->blockSz = (spans[span].len > at) ? MIN(spans[span].len - at, UINT16_MAX) : 0;
+    writer->blockLen = 0;
+    if (writer->blockSz == 0)
+    {
+        writer->block = NULL;
+        return false;
+    }
+    writer->block = spans[span].ptr + at;
+    return true;
+}
+
+
+/**
+ *  @brief STATIC Scope: Separate a new value (or key) from the previous member of its container.
+ *  @details A key is only valid in an object, not after a key; an object's value needs a key first; the document has 
+ *  one root value. Out of order writes fail the document (invalid).
+ */
+static void beginValue(lqJsonWriter_t *writer, bool isKey)
+{
+    uint32_t depthBit = (writer->depth > 0) ? (uint32_t)1 << (writer->depth - 1) : 0;
+    bool inObject = (writer->isObject & depthBit) != 0;
+
+    if (writer->afterKey)
+    {
+        writer->afterKey = false;
+        if (isKey)
+            writer->invalid = true;
+    }
+    else if (isKey != inObject || (writer->depth == 0 && writer->written > 0))
+        writer->invalid = true;
+    else if (writer->depth > 0)
+    {
+        if (writer->hasMember & depthBit)
+            emitChar(writer, ',');
+        writer->hasMember |= depthBit;
+    }
+}
+
+
+/**
+ *  @brief STATIC Scope: Open an object or array, nesting past LQJSON_WRITER_MAXDEPTH fails the document (overflow).
+ */
+static void openContainer(lqJsonWriter_t *writer, char open)
+{
+    beginValue(writer, false);
+    emitChar(writer, open);
+    if (writer->depth == LQJSON_WRITER_MAXDEPTH)
+    {
+        writer->overflow = true;
+        return;
+    }
+    uint32_t depthBit = (uint32_t)1 << writer->depth;
+    writer->hasMember &= ~depthBit;
+    if (open == '{')
+        writer->isObject |= depthBit;
+    else
+        writer->isObject &= ~depthBit;
+    writer->depth++;
+}
+
+
+/**
+ *  @brief STATIC Scope: Close the innermost object or array, a close with nothing open, of the other container type, or
+ *  after a key fails the document (invalid).
+ */
+static void closeContainer(lqJsonWriter_t *writer, char close)
+{
+    uint32_t depthBit = (writer->depth > 0) ? (uint32_t)1 << (writer->depth - 1) : 0;
+
+    if (writer->depth == 0 || writer->afterKey || ((writer->isObject & depthBit) != 0) != (close == '}'))
+    {
+        writer->invalid = true;
+        return;
+    }
+    emitChar(writer, close);
+    writer->depth--;
+}
+
+
+/**
+ *  @brief STATIC Scope: Write a quoted string, runs of chars needing no escape are copied in one emit().
+ */
+static void writeString(lqJsonWriter_t *writer, const char *text, uint16_t textLen)
+{
+    static const char hexDigits[] = "0123456789abcdef";
+    uint16_t runStart = 0;
+
+    emitChar(writer, '"');
+    for (uint16_t i = 0; i < textLen; i++)
+    {
+        uint8_t c = (uint8_t)text[i];
+        if (c >= 0x20 && c != '"' && c != '\\')
+            continue;
+
+        emit(writer, text + runStart, i - runStart);
+        runStart = i + 1;
+
+        char escape[6] = { '\\', (char)c, 0, 0, 0, 0 };
+        uint8_t escapeLen = 2;
+        switch (c)
+        {
+            case '"':
+            case '\\': break;
+            case '\b': escape[1] = 'b'; break;
+            case '\f': escape[1] = 'f'; break;
+            case '\n': escape[1] = 'n'; break;
+            case '\r': escape[1] = 'r'; break;
+            case '\t': escape[1] = 't'; break;
+            default:
+                memcpy(escape + 1, "u00", 3);
+                escape[4] = hexDigits[c >> 4];
+                escape[5] = hexDigits[c & 0x0F];
+                escapeLen = 6;
+                break;
+        }
+        emit(writer, escape, escapeLen);
+    }
+    emit(writer, text + runStart, textLen - runStart);
+    emitChar(writer, '"');
+}
+
+
+/**
+ *  @brief STATIC Scope: Format value as decimal digits ending at end (written backwards two digits at a time),
+ *  zero padded to minDigits. Returns the digit count.
+ */
+static uint8_t formatDigits(char *end, uint32_t value, uint8_t minDigits)
+{
+    char *start = end;
+
+    while (value >= 100)
+    {
+        uint32_t pair = value % 100;
+        value /= 100;
+        *--start = digitPairs[pair * 2 + 1];
+        *--start = digitPairs[pair * 2];
+    }
+    if (value >= 10)
+    {
+        *--start = digitPairs[value * 2 + 1];
+        *--start = digitPairs[value * 2];
+    }
+    else
+        *--start = '0' + value;
+
+    while (end - start < minDigits)
+        *--start = '0';
+    return end - start;
+}
+
+
+/**
+ *  @brief STATIC Scope: Format a 64-bit value ending at end, one 64-bit division per 8 digits. Returns the digit count.
+ */
+static uint8_t formatUint64(char *end, uint64_t value)
+{
+    uint8_t len = 0;
+
+    while (value > UINT32_MAX)
+    {
+        len += formatDigits(end - len, (uint32_t)(value % 100000000), 8);
+        value /= 100000000;
+    }
+    return len + formatDigits(end - len, (uint32_t)value, 1);
+}
+
+#pragma endregion
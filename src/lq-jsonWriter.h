@@ -0,0 +1,226 @@
+/******************************************************************************
+ *  \file lq-jsonWriter.h
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2022 LooUQ Incorporated.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ ******************************************************************************
+ * JSON writer: incremental serialization without scratch buffers or printf
+ *
+ * Values are written straight into the destination, either a bounded char
+ * array or a bbuffer (in place, through bbffr_pushSpans). Commas between members and
+ * string escaping are handled by the writer:
+ *
+ *   lqJsonWriter_t writer;
+ *   lq_jsonWriterInitBbffr(&writer, &txBuffer);
+ *   lq_jsonWriteObjectStart(&writer);
+ *   lq_jsonWriteKey(&writer, "temp");
+ *   lq_jsonWriteFloat(&writer, temperature, 2);
+ *   lq_jsonWriteKey(&writer, "alarms");
+ *   lq_jsonWriteArrayStart(&writer);
+ *   lq_jsonWriteInt(&writer, alarmCode);
+ *   lq_jsonWriteArrayEnd(&writer);
+ *   lq_jsonWriteObjectEnd(&writer);
+ *   if (lq_jsonWriterFinish(&writer) == 0) ...              // overflow
+ *
+ * Output that does not fit sets the overflow flag and is dropped, the writer
+ * keeps counting so lq_jsonWriterFinish() callers can size the destination.
+ *****************************************************************************/
+
+#ifndef __LQ_JSONWRITER_H__
+#define __LQ_JSONWRITER_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "lq-bBuffer.h"
+
+#define LQJSON_WRITER_MAXDEPTH 32                           ///< Max nesting of objects/arrays (one bit each)
+
+
+/**
+ * @brief Writer state, destination is set by lq_jsonWriterInit() or lq_jsonWriterInitBbffr().
+ */
+typedef struct lqJsonWriter_tag
+{
+    char *block;                                            ///< Current destination window
+    uint16_t blockSz;                                       ///< Size of window
+    uint16_t blockLen;                                      ///< Chars written to window
+    uint32_t pending;                                       ///< Chars written to earlier bbuffer windows, published at finish
+    bbuffer_t *bbffr;                                       ///< Destination bbuffer, NULL when writing to a char array
+    uint32_t written;                                       ///< Document length so far, includes dropped (overflow) chars
+    uint32_t hasMember;                                     ///< Bit per depth, container has a member (next needs a comma)
+    uint32_t isObject;                                      ///< Bit per depth, container is an object (members need keys)
+    uint8_t depth;                                          ///< Open objects/arrays
+    bool afterKey;                                          ///< Key written, its value follows without a comma
+    bool overflow;                                          ///< Destination filled, output truncated
+    bool invalid;                                           ///< Write out of JSON order (ex: value without key, mismatched close)
+} lqJsonWriter_t;
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+
+/**
+ *  @brief Start a document in a char array, lq_jsonWriterFinish() NULL terminates it.
+ * 
+ *  @param [out] writer - The writer to initialize.
+ *  @param [in] buffer - Destination char array.
+ *  @param [in] bufferSz - Size of buffer, document can be up to bufferSz - 1 chars.
+*/
+void lq_jsonWriterInit(lqJsonWriter_t *writer, char *buffer, uint16_t bufferSz);
+
+
+/**
+ *  @brief Start a document streamed into a bbuffer.
+ *  @details The writer fills the vacant region at buffer head in place (both sides of the wrap) and publishes the 
+ *  document with one bbffr_skipHead() at lq_jsonWriterFinish(), only if it is complete: an overflowed, unbalanced or
+ *  out of order document leaves nothing in the buffer. Space the consumer frees while the document is written is 
+ *  used. Do not push to the buffer by other means until the writer is finished.
+ * 
+ *  @param [out] writer - The writer to initialize.
+ *  @param [in] bbffr - Destination buffer.
+*/
+void lq_jsonWriterInitBbffr(lqJsonWriter_t *writer, bbuffer_t *bbffr);
+
+
+/**
+ *  @brief Complete the document: publish it to the bbuffer or NULL terminate the char array.
+ *  @details An incomplete document is not published to the bbuffer.
+ * 
+ *  @param [in] writer - The writer.
+ *  @return Document length, 0 if output overflowed the destination, objects/arrays are left open, or a write was out of
+ *  JSON order (key outside an object or after a key, object value without a key, close of the wrong or no container).
+*/
+uint32_t lq_jsonWriterFinish(lqJsonWriter_t *writer);
+
+
+/**
+ *  @brief Open an object (as a value: at document start, after a key or as an array element).
+ *  @param [in] writer - The writer.
+*/
+void lq_jsonWriteObjectStart(lqJsonWriter_t *writer);
+
+
+/**
+ *  @brief Close the innermost open object.
+ *  @param [in] writer - The writer.
+*/
+void lq_jsonWriteObjectEnd(lqJsonWriter_t *writer);
+
+
+/**
+ *  @brief Open an array (as a value: at document start, after a key or as an array element).
+ *  @param [in] writer - The writer.
+*/
+void lq_jsonWriteArrayStart(lqJsonWriter_t *writer);
+
+
+/**
+ *  @brief Close the innermost open array.
+ *  @param [in] writer - The writer.
+*/
+void lq_jsonWriteArrayEnd(lqJsonWriter_t *writer);
+
+
+/**
+ *  @brief Write an object property key, the next write is its value.
+ *  @param [in] writer - The writer.
+ *  @param [in] key - Property name (escaped as needed).
+*/
+void lq_jsonWriteKey(lqJsonWriter_t *writer, const char *key);
+
+
+/**
+ *  @brief Write a string value, quoted and escaped.
+ *  @param [in] writer - The writer.
+ *  @param [in] text - NULL terminated string.
+*/
+void lq_jsonWriteText(lqJsonWriter_t *writer, const char *text);
+
+
+/**
+ *  @brief Write a string value from a char span (need not be NULL terminated), quoted and escaped.
+ *  @param [in] writer - The writer.
+ *  @param [in] text - Chars of the string.
+ *  @param [in] textLen - Number of chars.
+*/
+void lq_jsonWriteTextN(lqJsonWriter_t *writer, const char *text, uint16_t textLen);
+
+
+/**
+ *  @brief Write a signed integer value.
+ *  @param [in] writer - The writer.
+ *  @param [in] value - The value.
+*/
+void lq_jsonWriteInt(lqJsonWriter_t *writer, int32_t value);
+
+
+/**
+ *  @brief Write an unsigned integer value.
+ *  @param [in] writer - The writer.
+ *  @param [in] value - The value.
+*/
+void lq_jsonWriteUint(lqJsonWriter_t *writer, uint32_t value);
+
+
+/**
+ *  @brief Write a number with a fixed count of decimals, rounded (ex: 21.5 with 2 decimals is 21.50).
+ *  @details Formatted with integer arithmetic, no printf. NaN/infinity (not representable in JSON) are written as 
+ *  null; magnitudes too large for the requested decimals are written with fewer (whole numbers past 1.8e19 as null).
+ * 
+ *  @param [in] writer - The writer.
+ *  @param [in] value - The value.
+ *  @param [in] decimals - Digits after the decimal point, 0 to 9.
+*/
+void lq_jsonWriteFloat(lqJsonWriter_t *writer, double value, uint8_t decimals);
+
+
+/**
+ *  @brief Write true or false.
+ *  @param [in] writer - The writer.
+ *  @param [in] value - The value.
+*/
+void lq_jsonWriteBool(lqJsonWriter_t *writer, bool value);
+
+
+/**
+ *  @brief Write null.
+ *  @param [in] writer - The writer.
+*/
+void lq_jsonWriteNull(lqJsonWriter_t *writer);
+
+
+/**
+ *  @brief Write an already serialized JSON value as is (ex: a cached sub-document).
+ *  @param [in] writer - The writer.
+ *  @param [in] json - The value's JSON text.
+ *  @param [in] jsonLen - Length of json.
+*/
+void lq_jsonWriteRaw(lqJsonWriter_t *writer, const char *json, uint16_t jsonLen);
+
+
+#ifdef __cplusplus
+}
+#endif // !__cplusplus
+
+#endif  /* !__LQ_JSONWRITER_H__ */
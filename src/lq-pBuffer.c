@@ -0,0 +1,279 @@
+/******************************************************************************
+ *  \file lq-pBuffer.c
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2022 LooUQ Incorporated.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ * LooUQ power-of-two block buffer, monotonic counter variant of lq-bBuffer
+ *****************************************************************************/
+
+#include <lq-embed.h>
+#define LOG_LEVEL LOGLEVEL_DBG
+//#define DISABLE_ASSERTS                                   // ASSERT/ASSERT_W enabled by default, can be disabled 
+#define SRCFILE "PBF"                                       // create SRCFILE (3 char) MACRO for lq-diagnostics ASSERT
+
+#define ENABLE_DIAGPRINT                                    // expand DPRINT into debug output
+//#define ENABLE_DIAGPRINT_VERBOSE                          // expand DPRINT and DPRINT_V into debug output
+#define ENABLE_ASSERT
+
+#include <string.h>
+#include <stdio.h>
+#include "lq-pBuffer.h"
+#include "lq-diagnostics.h"
+
+
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+
+/* Counter publication for single-producer/single-consumer operation, see lq-bBuffer.c
+ */
+#define PBFFR_LOAD_OWN(p) __atomic_load_n(&(p), __ATOMIC_RELAXED)
+#define PBFFR_LOAD_ACQ(p) __atomic_load_n(&(p), __ATOMIC_ACQUIRE)
+#define PBFFR_STORE_REL(p, v) __atomic_store_n(&(p), (v), __ATOMIC_RELEASE)
+
+#define PBFFR_SIZE (pbffr->mask + 1)
+#define PBFFR_PTR(cntr) (pbffr->buffer + ((cntr) & pbffr->mask))          // buffer position of a counter value
+#define PBFFR_TOEDGE(cntr) (PBFFR_SIZE - ((cntr) & pbffr->mask))           // contiguous chars from counter position to buffer end
+
+
+#pragma region Local Static Function Declarations
+static bool matchesAt(pbuffer_t *pbffr, uint32_t position, const char *pNeedle, uint16_t needleLen);
+#pragma endregion
+
+
+bool pbffr_init(pbuffer_t *pbffr, char * rawBuffer, uint16_t bufferSz)
+{
+    if (bufferSz == 0 || (bufferSz & (bufferSz - 1)) != 0)                 // must be power of two
+        return false;
+
+    pbffr->buffer = rawBuffer;
+    pbffr->mask = bufferSz - 1;
+    pbffr->head = 0;
+    pbffr->tail = 0;
+    pbffr->pHeadCnt = 0;
+    pbffr->pTailCnt = 0;
+    return true;
+}
+
+
+void pbffr_reset(pbuffer_t *pbffr)
+{
+    pbffr->head = 0;
+    pbffr->tail = 0;
+    pbffr->pHeadCnt = 0;
+    pbffr->pTailCnt = 0;
+}
+
+
+/**
+ * @brief Diagnostic to get internal buffer status.
+ */
+void pbffr_GETMACROS(pbuffer_t *pbffr, char *macrosRpt, uint8_t macrosRptSz)
+{
+    uint32_t tail = PBFFR_LOAD_ACQ(pbffr->tail);
+    uint32_t head = PBFFR_LOAD_ACQ(pbffr->head);
+
+    snprintf(macrosRpt, macrosRptSz, "PBFFR MACROS: size=%d, head=%lu, tail=%lu, occpd=%d, vacnt=%d\r\r", 
+             (int)PBFFR_SIZE, (unsigned long)head, (unsigned long)tail, (int)(head - tail), (int)(PBFFR_SIZE - (head - tail)));
+}
+
+
+uint16_t pbffr_getCapacity(pbuffer_t *pbffr)
+{
+    return PBFFR_SIZE;
+}
+
+
+uint16_t pbffr_getOccupied(pbuffer_t *pbffr)
+{
+    uint32_t tail = PBFFR_LOAD_ACQ(pbffr->tail);
+    return PBFFR_LOAD_ACQ(pbffr->head) - tail;
+}
+
+
+uint16_t pbffr_getVacant(pbuffer_t *pbffr)
+{
+    uint32_t head = PBFFR_LOAD_ACQ(pbffr->head);
+    return PBFFR_SIZE - (head - PBFFR_LOAD_ACQ(pbffr->tail));
+}
+
+
+/* Basic push/pop/find
+ ----------------------------------------------------------------------------------------------- */
+
+uint16_t pbffr_push(pbuffer_t *pbffr, const char *src, uint16_t srcSz)
+{
+    ASSERT(pbffr->pHeadCnt == 0);                                           // pending pushBlock() owns head
+
+    uint32_t head = PBFFR_LOAD_OWN(pbffr->head);
+    uint32_t tail = PBFFR_LOAD_ACQ(pbffr->tail);                            // consumer counter: read once
+
+    uint16_t pushCnt = MIN(srcSz, PBFFR_SIZE - (head - tail));
+    uint16_t rightCnt = MIN(pushCnt, PBFFR_TOEDGE(head));
+
+    memcpy(PBFFR_PTR(head), src, rightCnt);
+    memcpy(pbffr->buffer, src + rightCnt, pushCnt - rightCnt);
+
+    PBFFR_STORE_REL(pbffr->head, head + pushCnt);
+    return pushCnt;
+}
+
+
+uint16_t pbffr_pushBlock(pbuffer_t *pbffr, char **copyTo, uint16_t requestSz)
+{
+    ASSERT(pbffr->pHeadCnt == 0);                                           // pending pushBlock already, no nesting pushBlock()
+
+    uint32_t head = PBFFR_LOAD_OWN(pbffr->head);
+    uint32_t tail = PBFFR_LOAD_ACQ(pbffr->tail);
+
+    *copyTo = PBFFR_PTR(head);
+    pbffr->pHeadCnt = MIN(requestSz, MIN(PBFFR_SIZE - (head - tail), PBFFR_TOEDGE(head)));
+    return pbffr->pHeadCnt;
+}
+
+
+void pbffr_pushBlockFinalize(pbuffer_t *pbffr, bool commit)
+{
+    if (commit)
+        PBFFR_STORE_REL(pbffr->head, PBFFR_LOAD_OWN(pbffr->head) + pbffr->pHeadCnt);
+    pbffr->pHeadCnt = 0;
+}
+
+
+uint16_t pbffr_pop(pbuffer_t *pbffr, char *dest, uint16_t requestSz)
+{
+    ASSERT(pbffr->pTailCnt == 0);                                           // pending popBlock() owns tail
+
+    uint32_t tail = PBFFR_LOAD_OWN(pbffr->tail);
+    uint32_t head = PBFFR_LOAD_ACQ(pbffr->head);                            // producer counter: read once
+
+    uint16_t popCnt = MIN(requestSz, head - tail);
+    uint16_t rightCnt = MIN(popCnt, PBFFR_TOEDGE(tail));
+
+    memcpy(dest, PBFFR_PTR(tail), rightCnt);
+    memcpy(dest + rightCnt, pbffr->buffer, popCnt - rightCnt);
+
+    PBFFR_STORE_REL(pbffr->tail, tail + popCnt);
+    return popCnt;
+}
+
+
+uint16_t pbffr_popBlock(pbuffer_t *pbffr, char **copyFrom, uint16_t requestSz)
+{
+    ASSERT(pbffr->pTailCnt == 0);                                           // pending popBlock already, no nesting popBlock()
+
+    uint32_t tail = PBFFR_LOAD_OWN(pbffr->tail);
+    uint32_t head = PBFFR_LOAD_ACQ(pbffr->head);
+
+    *copyFrom = PBFFR_PTR(tail);
+    pbffr->pTailCnt = MIN(requestSz, MIN(head - tail, PBFFR_TOEDGE(tail)));
+    return pbffr->pTailCnt;
+}
+
+
+void pbffr_popBlockFinalize(pbuffer_t *pbffr, bool commit)
+{
+    if (commit)
+        PBFFR_STORE_REL(pbffr->tail, PBFFR_LOAD_OWN(pbffr->tail) + pbffr->pTailCnt);
+    pbffr->pTailCnt = 0;
+}
+
+
+uint16_t pbffr_peek(pbuffer_t *pbffr, char *dest, uint16_t requestSz)
+{
+    uint32_t tail = PBFFR_LOAD_OWN(pbffr->tail);
+    uint32_t head = PBFFR_LOAD_ACQ(pbffr->head);
+
+    uint16_t peeked = MIN(requestSz, head - tail);
+    uint16_t rightCnt = MIN(peeked, PBFFR_TOEDGE(tail));
+
+    memcpy(dest, PBFFR_PTR(tail), rightCnt);
+    memcpy(dest + rightCnt, pbffr->buffer, peeked - rightCnt);
+    return peeked;
+}
+
+
+uint16_t pbffr_find(pbuffer_t *pbffr, const char *pNeedle, int16_t searchOffset, uint16_t searchWindowSz, bool setTail)
+{
+    uint32_t tail = PBFFR_LOAD_OWN(pbffr->tail);
+    uint32_t head = PBFFR_LOAD_ACQ(pbffr->head);
+    uint16_t occupied = head - tail;
+    uint16_t needleLen = strlen(pNeedle);
+
+    uint16_t searchStart = 0;
+    if (searchOffset > 0)                                                   // (+) skip ahead from tail
+        searchStart = MIN(searchOffset, occupied);
+    else if (searchOffset < 0)                                              // (-) skip back from head
+        searchStart = (-searchOffset < occupied) ? occupied + searchOffset : 0;
+
+    uint16_t searchEnd = (searchWindowSz == 0) ? occupied : MIN(occupied, searchStart + searchWindowSz);
+
+    if (needleLen == 0 || searchEnd - searchStart < needleLen)
+        return PBFFR_NOTFOUND;
+
+    for (uint16_t offset = searchStart; offset + needleLen <= searchEnd; offset++)
+    {
+        if (matchesAt(pbffr, tail + offset, pNeedle, needleLen))
+        {
+            if (setTail)
+            {
+                ASSERT(pbffr->pTailCnt == 0);
+                PBFFR_STORE_REL(pbffr->tail, tail + offset);
+            }
+            return offset;
+        }
+    }
+    return PBFFR_NOTFOUND;
+}
+
+
+void pbffr_skipHead(pbuffer_t *pbffr, uint16_t skipCnt)
+{
+    uint32_t head = PBFFR_LOAD_OWN(pbffr->head);
+    uint32_t tail = PBFFR_LOAD_ACQ(pbffr->tail);
+
+    PBFFR_STORE_REL(pbffr->head, head + MIN(skipCnt, PBFFR_SIZE - (head - tail)));
+}
+
+
+void pbffr_skipTail(pbuffer_t *pbffr, uint16_t skipCnt)
+{
+    uint32_t tail = PBFFR_LOAD_OWN(pbffr->tail);
+    uint32_t head = PBFFR_LOAD_ACQ(pbffr->head);
+
+    PBFFR_STORE_REL(pbffr->tail, tail + MIN(skipCnt, head - tail));
+}
+
+
+#pragma region Static Local Functions
+
+/**
+ *  @brief STATIC Scope: Compare needle at a buffer counter position, comparison continues across the buffer wrap.
+ */
+static bool matchesAt(pbuffer_t *pbffr, uint32_t position, const char *pNeedle, uint16_t needleLen)
+{
+    uint16_t rightSideLen = MIN(needleLen, PBFFR_TOEDGE(position));
+
+    if (memcmp(PBFFR_PTR(position), pNeedle, rightSideLen) != 0)
+        return false;
+    return memcmp(pbffr->buffer, pNeedle + rightSideLen, needleLen - rightSideLen) == 0;
+}
+
+#pragma endregion
@@ -0,0 +1,229 @@
+/******************************************************************************
+ *  \file lq-pBuffer.h
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2022 LooUQ Incorporated.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ * LooUQ power-of-two block buffer, monotonic counter variant of lq-bBuffer
+ *****************************************************************************/
+
+#ifndef __LQ_PBFFR_H__
+#define __LQ_PBFFR_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Internal control structure for a power-of-two block buffer.
+ * @details Functionally equivalent to bbuffer_t (same operations, same producer/consumer concurrency rules) with the
+ * buffer size restricted to a power of two. Head and tail are free-running counters, masked to a buffer position on 
+ * access: occupied is (head - tail) regardless of wrap and the full buffer size is usable.
+ */
+typedef struct pbuffer_tag
+{
+    char *buffer;                                           ///< Raw character buffer
+    uint32_t mask;                                          ///< Buffer size - 1, converts a counter to a buffer position
+
+    volatile uint32_t head;                                 ///< Count of chars ever ADDED to the buffer (pushed to), position is (head & mask)
+    volatile uint32_t tail;                                 ///< Count of chars ever REMOVED from the buffer (popped from), position is (tail & mask)
+    uint16_t pHeadCnt;                                      ///< Size of pending pushBlock operation, head is advanced by this on commit
+    uint16_t pTailCnt;                                      ///< Size of pending popBlock operation, tail is advanced by this on commit
+} pbuffer_t;
+
+
+#define PBFFR_NOTFOUND 0xFFFF                               ///< Value returned from a buffer find operation signalling NOT FOUND (same as BBFFR_NOTFOUND)
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+/**
+ * @brief Initialize a power-of-two block buffer.
+ * 
+ * @param pbffr The buffer control structure to initialize.
+ * @param rawBuffer Character array providing the buffer storage.
+ * @param bufferSz Size of rawBuffer, must be a power of two (max 32768).
+ * @return true if initialized, false if bufferSz is not a power of two.
+ */
+bool pbffr_init(pbuffer_t *pbffr, char * rawBuffer, uint16_t bufferSz);
+
+
+/**
+ * @brief Reset the buffer to an empty and initial state. Does not "resize" buffer.
+ * 
+ * @param pbffr The buffer to operate on.
+ */
+void pbffr_reset(pbuffer_t *pbffr);
+
+
+/**
+ * @brief Get total capacity of the buffer, all bufferSz characters are usable.
+ * 
+ * @param pbffr The buffer to report on.
+ * @return The capacity of the buffer.
+ */
+uint16_t pbffr_getCapacity(pbuffer_t *pbffr);
+
+
+/**
+ * @brief Get number of characters occupying the buffer.
+ * 
+ * @param pbffr The buffer to report on.
+ * @return The number of characters in the buffer.
+ */
+uint16_t pbffr_getOccupied(pbuffer_t *pbffr);
+
+
+/**
+ * @brief Get number of bytes of free space available in the buffer.
+ * 
+ * @param pbffr The buffer to report on.
+ * @return The number of free bytes in the buffer.
+ */
+uint16_t pbffr_getVacant(pbuffer_t *pbffr);
+
+
+/**
+ * @brief Diagnostic method to get information on the buffer's internal values.
+ * @note macros char buffer should be at least 128 chars in length
+ * 
+ * @param pbffr The buffer to report on.
+ * @param macrosRpt Pointer to character buffer to fill with internal values info.
+ * @param macrosRptSz Size of the result reporting buffer.
+ */
+void pbffr_GETMACROS(pbuffer_t *pbffr, char *macrosRpt, uint8_t macrosRptSz);
+
+
+/* Operate on Buffer 
+ =============================================================================================== */
+
+/**
+ * @brief Push a series of characters into buffer at buffer-head.
+ * 
+ * @param pbffr The buffer receiving the characters.
+ * @param src Pointer to the characters to be pushed.
+ * @param requestSz Number of characters to push.
+ * @return Number of characters "pushed"; the lesser of available and requestSz.
+ */
+uint16_t pbffr_push(pbuffer_t *pbffr, const char *src, uint16_t requestSz);
+
+
+/**
+ * @brief Get contiguous block of vacant space at head (incoming). Distance to tail or buffer-wrap.
+ * 
+ * @param pbffr [in] The buffer to be operated on.
+ * @param copyTo [out] Pointer to delegated copy destination, where your function needs to copy to.
+ * @param requestSz [in] Requested (contiguous) space in buffer.
+ * @return Number of characters available to be pushed; the lesser of contiguous vacant and requestSz.
+ */
+uint16_t pbffr_pushBlock(pbuffer_t *pbffr, char **copyTo, uint16_t requestSz);
+
+
+/**
+ * @brief Commit or rollback a pending push block. The pushed block is not visible to the consumer until committed.
+ * 
+ * @param pbffr [in] The buffer to be operated on.
+ * @param commit [in] Commit pending push block (true) or roll-back pending push (false).
+ */
+void pbffr_pushBlockFinalize(pbuffer_t *pbffr, bool commit);
+
+
+/**
+ * @brief Pop a number of chars from buffer at buffer-tail. Number of characters "popped" will be the lesser of available and requestSz.
+ * 
+ * @param pbffr The buffer sourcing the characters.
+ * @param dest Pointer to memory location where popped chars are copied.
+ * @param requestSz Number of chars requested from the buffer.
+ * @return Number of characters "popped"; the lesser of available and requestSz.
+ */
+uint16_t pbffr_pop(pbuffer_t *pbffr, char *dest, uint16_t requestSz);
+
+
+/**
+ * @brief Allocate a POP of contiguous chars from buffer at buffer-tail. Space is gaurded against overwrite until pbffr_popBlockFinalize().
+ * 
+ * @param pbffr [in] The buffer sourcing the characters.
+ * @param copyFrom [out] Dbl-pointer to memory location where popped chars are TO BE copied from.
+ * @param requestSz [in] Number of chars requested from the buffer.
+ * @return Number of characters available to be popped; the lesser of contiguous occupied and requestSz.
+ */
+uint16_t pbffr_popBlock(pbuffer_t *pbffr, char **copyFrom, uint16_t requestSz);
+
+
+/**
+ * @brief Commit or rollback a pending pop block. 
+ * 
+ * @param pbffr [in] The buffer to be operated on.
+ * @param commit [in] Commit pending pop block (true) or roll-back pending pop (false).
+ */
+void pbffr_popBlockFinalize(pbuffer_t *pbffr, bool commit);
+
+
+/**
+ * @brief Peeks a number of chars ahead in the buffer starting at buffer-tail.
+ * 
+ * @param pbffr The buffer sourcing the characters.
+ * @param dest Pointer to memory location where peeked chars are copied.
+ * @param requestSz Number of chars requested from the buffer.
+ * @return Number of characters "peeked" (the lesser of available and requestSz).
+ */
+uint16_t pbffr_peek(pbuffer_t *pbffr, char *dest, uint16_t requestSz);
+
+
+/**
+ * @brief Find needle in the buffer. Search begins at the buffer TAIL unless overridden; same semantics as bbffr_find().
+ * 
+ * @param pbffr The buffer to be searched.
+ * @param pNeedle The character sequence you are looking for.
+ * @param searchOffset Chars to skip forward from tail (+) -OR- skip back from head (-) to start search. If 0: search starts at buffer-tail.
+ * @param searchWindowSz The number of chars from search start to examine for find. If 0, searching continues until buffer-head.
+ * @param setTail If true, the buffer tail is advanced to the first character of found needle.
+ * @return Offset from buffer TAIL (prior to any setTail) to the position of the needle. If no find returns PBFFR_NOTFOUND (0xFFFF)
+ */
+uint16_t pbffr_find(pbuffer_t *pbffr, const char *pNeedle, int16_t searchOffset, uint16_t searchWindowSz, bool setTail);
+
+
+/**
+ * @brief Advances the buffer's tail (outgoing) by the requested number of chars, limited to occupied.
+ * 
+ * @param pbffr The buffer to be operated on.
+ * @param skipCnt The number of chars to advance the tail.
+ */
+void pbffr_skipTail(pbuffer_t *pbffr, uint16_t skipCnt);
+
+
+/**
+ * @brief Advances the buffer's head (incoming) by the requested number of chars, limited to vacant.
+ * 
+ * @param pbffr The buffer to be operated on.
+ * @param skipCnt The number of chars to advance the head.
+ */
+void pbffr_skipHead(pbuffer_t *pbffr, uint16_t skipCnt);
+
+
+#ifdef __cplusplus
+}
+#endif // !__cplusplus
+
+#endif  /* !__LQ_PBFFR_H__ */
@@ -0,0 +1,352 @@
+/******************************************************************************
+ *  \file bbffr-bench.c
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2022 LooUQ Incorporated.
+ *  www.loouq.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ * Linux host throughput benchmark, bbuffer (pointer engine) vs pbuffer 
+ * (power-of-two counter engine), plus cbuffer (single char and bulk). Each
+ * case moves a fixed volume of data through the buffer with the named
+ * operation, results are CSV lines:
+ *   engine,op,bufferSz,opSz,MBps
+ * 
+ * Save a run as a baseline and compare later runs against it with
+ * bench-compare.sh to flag operations that have slowed down.
+ * 
+ * The find-modem cases scan a buffer filled with BGx modem traffic for 
+ * common response terminators, comparing bbffr_find and bbffr_findCompiled
+ * (opSz is the needle length). The lines cases extract '\n' terminated lines
+ * from the same traffic, find+pop+skipTail vs bbffr_popLine (opSz is 0). The
+ * fd-relay cases move the traffic pipe -> buffer -> /dev/null, through a
+ * scratch array with read+push/pop+write vs bbffr_readFromFd/bbffr_writeToFd.
+ * 
+ * Build/run (from this folder):
+ *   gcc -O2 -DDISABLE_ASSERT -I../../src bbffr-bench.c ../../src/lq-bBuffer.c ../../src/lq-pBuffer.c ../../src/lq-cBuffer.c -o bbffr-bench
+ *   ./bbffr-bench [megabytesPerCase]
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "lq-bBuffer.h"
+#include "lq-pBuffer.h"
+#include "lq-cBuffer.h"
+
+static uint64_t volume = 64ULL << 20;
+static volatile uint32_t sink;                                          // defeat dead-store elimination of copied data
+static char src[4096];
+static char modemSrc[4096];
+
+/* Representative BGx modem UART traffic (command echoes, URCs, socket and MQTT responses), replayed to fill buffers */
+static const char *modemTraffic = 
+    "AT+QIRD=0,1500\r\r\n+QIRD: 128\r\nHTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: 64\r\n\r\n"
+    "{\"status\":\"ok\",\"seq\":1042,\"cmd\":\"setInterval\",\"params\":{\"sec\":30}}\r\n\r\nOK\r\n"
+    "\r\n+QIURC: \"recv\",0\r\n"
+    "AT+CSQ\r\r\n+CSQ: 19,99\r\n\r\nOK\r\n"
+    "AT+QMTPUBEX=0,1,1,0,\"dvc/telemetry\",48\r\r\n> "
+    "{\"temp\":21.5,\"hum\":44,\"batt\":3.71,\"rssi\":-79}\r\n\r\nOK\r\n\r\n+QMTPUBEX: 0,1,0\r\n"
+    "AT+CEREG?\r\r\n+CEREG: 2,5,\"2B0C\",\"0A1D3B07\",9\r\n\r\nOK\r\n"
+    "\r\n+QMTRECV: 0,7,\"dvc/cmd\",\"{\\\"act\\\":\\\"reboot\\\"}\"\r\n";
+static char dest[4096];
+
+
+static double nowSeconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char *engine, const char *op, uint16_t bufferSz, uint16_t opSz, uint64_t bytes, double elapsed)
+{
+    printf("%s,%s,%d,%d,%.1f\n", engine, op, bufferSz, opSz, (bytes / 1048576.0) / elapsed);
+}
+
+
+/* Buffer engines are benchmarked through the same macro body, only the prefix differs
+ */
+#define BENCH_PUSHPOP(PFX, bffr)                                                \
+    do {                                                                        \
+        uint64_t moved = 0;                                                     \
+        double start = nowSeconds();                                            \
+        while (moved < volume)                                                  \
+        {                                                                       \
+            PFX##_push(bffr, src, opSz);                                        \
+            moved += PFX##_pop(bffr, dest, opSz);                               \
+            sink += dest[0];                                                    \
+        }                                                                       \
+        report(#PFX, "push+pop", bufferSz, opSz, moved, nowSeconds() - start);  \
+    } while (0)
+
+#define BENCH_BLOCKS(PFX, bffr)                                                 \
+    do {                                                                        \
+        uint64_t moved = 0;                                                     \
+        char *block;                                                            \
+        double start = nowSeconds();                                            \
+        while (moved < volume)                                                  \
+        {                                                                       \
+            uint16_t sz = PFX##_pushBlock(bffr, &block, opSz);                  \
+            memcpy(block, src, sz);                                             \
+            PFX##_pushBlockFinalize(bffr, true);                                \
+            sz = PFX##_popBlock(bffr, &block, opSz);                            \
+            memcpy(dest, block, sz);                                            \
+            PFX##_popBlockFinalize(bffr, true);                                 \
+            moved += sz;                                                        \
+            sink += dest[0];                                                    \
+        }                                                                       \
+        report(#PFX, "pushBlock+popBlock", bufferSz, opSz, moved, nowSeconds() - start); \
+    } while (0)
+
+#define BENCH_PEEK(PFX, bffr)                                                   \
+    do {                                                                        \
+        uint64_t moved = 0;                                                     \
+        PFX##_push(bffr, src, bufferSz / 2 + 3);                                \
+        PFX##_skipTail(bffr, bufferSz / 2 + 3);                                 \
+        PFX##_push(bffr, src, bufferSz - 1);                                    \
+        double start = nowSeconds();                                            \
+        while (moved < volume)                                                  \
+        {                                                                       \
+            moved += PFX##_peek(bffr, dest, opSz);                              \
+            sink += dest[0];                                                    \
+        }                                                                       \
+        report(#PFX, "peek", bufferSz, opSz, moved, nowSeconds() - start);      \
+    } while (0)
+
+#define BENCH_SKIP(PFX, bffr)                                                   \
+    do {                                                                        \
+        uint64_t moved = 0;                                                     \
+        double start = nowSeconds();                                            \
+        while (moved < volume)                                                  \
+        {                                                                       \
+            moved += PFX##_push(bffr, src, opSz);                               \
+            PFX##_skipTail(bffr, opSz);                                         \
+        }                                                                       \
+        report(#PFX, "push+skipTail", bufferSz, opSz, moved, nowSeconds() - start); \
+    } while (0)
+
+#define BENCH_FINDMODEM(NAME, bffr, findExpr, needleLen)                      \
+    do {                                                                        \
+        uint64_t scanned = 0;                                                   \
+        bbffr_push(bffr, modemSrc, bufferSz / 2 + 3);                           \
+        bbffr_skipTail(bffr, bufferSz / 2 + 3);                                 \
+        bbffr_push(bffr, modemSrc, bufferSz - 1);                               \
+        uint16_t occupied = bbffr_getOccupied(bffr);                            \
+        double start = nowSeconds();                                            \
+        while (scanned < volume)                                                \
+        {                                                                       \
+            sink += (findExpr);                                                 \
+            scanned += occupied;                                                \
+        }                                                                       \
+        report(NAME, "find-modem", bufferSz, needleLen, scanned, nowSeconds() - start); \
+        bbffr_reset(bffr);                                                      \
+    } while (0)
+
+#define BENCH_FIND(PFX, bffr)                                                   \
+    do {                                                                        \
+        uint64_t scanned = 0;                                                   \
+        PFX##_push(bffr, src, bufferSz / 2 + 3);                                \
+        PFX##_skipTail(bffr, bufferSz / 2 + 3);                                 \
+        PFX##_push(bffr, src, bufferSz - 8);                                    \
+        PFX##_push(bffr, "OK\r\n", 4);                                          \
+        uint16_t occupied = PFX##_getOccupied(bffr);                            \
+        double start = nowSeconds();                                            \
+        while (scanned < volume)                                                \
+        {                                                                       \
+            sink += PFX##_find(bffr, "OK\r\n", 0, 0, false);                    \
+            scanned += occupied;                                                \
+        }                                                                       \
+        report(#PFX, "find", bufferSz, 4, scanned, nowSeconds() - start);       \
+    } while (0)
+
+#define BENCH_LINES(NAME, bffr, lineExpr)                                       \
+    do {                                                                        \
+        uint64_t moved = 0;                                                     \
+        size_t srcPos = 0;                                                      \
+        uint16_t lineLen;                                                       \
+        double start = nowSeconds();                                            \
+        while (moved < volume)                                                  \
+        {                                                                       \
+            srcPos += bbffr_push(bffr, modemSrc + srcPos, sizeof(modemSrc) - srcPos);   \
+            if (srcPos == sizeof(modemSrc))                                     \
+                srcPos = 0;                                                     \
+            while ((lineLen = (lineExpr)) != BBFFR_NOTFOUND)                    \
+                moved += lineLen + 1;                                           \
+        }                                                                       \
+        report(NAME, "lines", bufferSz, 0, moved, nowSeconds() - start);        \
+        bbffr_reset(bffr);                                                      \
+    } while (0)
+
+
+/* cbuffer, char at a time and bulk; storage is uint8_t, data is the same as the other engines */
+static void benchCbuffer(uint16_t bufferSz, uint16_t opSz)
+{
+    static uint8_t cRaw[4096];
+    cbuffer_t cBuffer = { .buffer = cRaw, .head = 0, .tail = 0, .maxlen = bufferSz };
+    uint64_t moved = 0;
+
+    double start = nowSeconds();
+    while (moved < volume)
+    {
+        for (uint16_t i = 0; i < opSz; i++)
+            cbffr_push(&cBuffer, (uint8_t)src[i]);
+        for (uint16_t i = 0; i < opSz; i++)
+            moved += cbffr_pop(&cBuffer, (uint8_t *)&dest[i]);
+        sink += dest[0];
+    }
+    report("cbffr", "push+pop", bufferSz, opSz, moved, nowSeconds() - start);
+
+    moved = 0;
+    start = nowSeconds();
+    while (moved < volume)
+    {
+        cbffr_pushN(&cBuffer, (const uint8_t *)src, opSz);
+        moved += cbffr_popN(&cBuffer, (uint8_t *)dest, opSz);
+        sink += dest[0];
+    }
+    report("cbffr", "pushN+popN", bufferSz, opSz, moved, nowSeconds() - start);
+}
+
+
+/* Line extraction the pre-popLine way: scan, copy, then step over the delimiter */
+static uint16_t lineByFind(bbuffer_t *bffr, char *line, uint16_t lineSz)
+{
+    uint16_t lineLen = bbffr_find(bffr, "\n", 0, 0, false);
+    if (lineLen == BBFFR_NOTFOUND || lineLen >= lineSz)
+        return BBFFR_NOTFOUND;
+    bbffr_pop(bffr, line, lineLen);
+    bbffr_skipTail(bffr, 1);
+    return lineLen;
+}
+
+
+/* Descriptor relay, pipe -> buffer -> /dev/null; each pass wraps the buffer so readv/writev use two spans */
+static void benchFdRelay(bbuffer_t *bffr, uint16_t bufferSz, bool direct)
+{
+    static char scratch[4096];
+    int pipeFds[2];
+    int devNull = open("/dev/null", O_WRONLY);
+    uint16_t opSz = bufferSz / 2;
+    uint64_t moved = 0;
+
+    if (devNull < 0 || pipe(pipeFds) != 0)
+        return;
+    double start = nowSeconds();
+    while (moved < volume)
+    {
+        if (write(pipeFds[1], modemSrc, opSz) != opSz)
+            break;
+        if (direct)
+        {
+            bbffr_readFromFd(bffr, pipeFds[0], opSz, NULL);
+            moved += bbffr_writeToFd(bffr, devNull, opSz, NULL);
+        }
+        else
+        {
+            ssize_t readCnt = read(pipeFds[0], scratch, opSz);
+            bbffr_push(bffr, scratch, (readCnt > 0) ? readCnt : 0);
+            uint16_t popCnt = bbffr_pop(bffr, scratch, opSz);
+            moved += (write(devNull, scratch, popCnt) == popCnt) ? popCnt : 0;
+        }
+    }
+    report(direct ? "bbffr-readFromFd/writeToFd" : "bbffr-read+push/pop+write", "fd-relay", bufferSz, opSz, moved, nowSeconds() - start);
+    close(pipeFds[0]);
+    close(pipeFds[1]);
+    close(devNull);
+    bbffr_reset(bffr);
+}
+
+
+int main(int argc, char *argv[])
+{
+    static char bRaw[4096];
+    static char pRaw[4096];
+    bbuffer_t bBuffer;
+    pbuffer_t pBuffer;
+    uint16_t bufferSizes[] = { 256, 1024, 4096 };
+    uint16_t opSizes[] = { 1, 16, 64, 200 };
+
+    if (argc > 1)
+        volume = strtoull(argv[1], NULL, 10) << 20;
+
+    for (size_t i = 0; i < sizeof(src); i++)                            // modem-like text without the find needle
+        src[i] = 'A' + (i % 26);
+    for (size_t i = 0; i < sizeof(modemSrc); i++)
+        modemSrc[i] = modemTraffic[i % strlen(modemTraffic)];
+
+    const char *needles[] = { "+CME ERROR: ", "\r\n+QIURC: \"closed\"", "\r\nERROR\r\n" };     // absent: full scans
+    bbffrNeedle_t compiled[3];
+    for (size_t n = 0; n < 3; n++)
+        bbffr_compileNeedle(&compiled[n], needles[n]);
+
+    printf("engine,op,bufferSz,opSz,MBps\n");
+    for (size_t b = 0; b < sizeof(bufferSizes) / sizeof(bufferSizes[0]); b++)
+    {
+        uint16_t bufferSz = bufferSizes[b];
+        for (size_t o = 0; o < sizeof(opSizes) / sizeof(opSizes[0]); o++)
+        {
+            uint16_t opSz = opSizes[o];
+
+            bbffr_init(&bBuffer, bRaw, bufferSz);
+            pbffr_init(&pBuffer, pRaw, bufferSz);
+            BENCH_PUSHPOP(bbffr, &bBuffer);
+            BENCH_PUSHPOP(pbffr, &pBuffer);
+
+            bbffr_reset(&bBuffer);
+            pbffr_reset(&pBuffer);
+            BENCH_BLOCKS(bbffr, &bBuffer);
+            BENCH_BLOCKS(pbffr, &pBuffer);
+
+            bbffr_reset(&bBuffer);
+            pbffr_reset(&pBuffer);
+            BENCH_PEEK(bbffr, &bBuffer);
+            BENCH_PEEK(pbffr, &pBuffer);
+
+            bbffr_reset(&bBuffer);
+            pbffr_reset(&pBuffer);
+            BENCH_SKIP(bbffr, &bBuffer);
+            BENCH_SKIP(pbffr, &pBuffer);
+
+            benchCbuffer(bufferSz, opSz);
+        }
+        bbffr_reset(&bBuffer);
+        pbffr_reset(&pBuffer);
+        BENCH_FIND(bbffr, &bBuffer);
+        BENCH_FIND(pbffr, &pBuffer);
+
+        bbffr_reset(&bBuffer);
+        for (size_t n = 0; n < 3; n++)
+        {
+            BENCH_FINDMODEM("bbffr", &bBuffer, bbffr_find(&bBuffer, needles[n], 0, 0, false), strlen(needles[n]));
+            BENCH_FINDMODEM("bbffr-compiled", &bBuffer, bbffr_findCompiled(&bBuffer, &compiled[n], 0, 0, false), strlen(needles[n]));
+        }
+        BENCH_LINES("bbffr-find+pop", &bBuffer, lineByFind(&bBuffer, dest, sizeof(dest)));
+        BENCH_LINES("bbffr-popLine", &bBuffer, bbffr_popLine(&bBuffer, dest, sizeof(dest)));
+        benchFdRelay(&bBuffer, bufferSz, false);
+        benchFdRelay(&bBuffer, bufferSz, true);
+    }
+    return 0;
+}
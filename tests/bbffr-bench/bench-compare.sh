@@ -0,0 +1,33 @@
+#!/bin/sh
+# Compare two bbffr-bench CSV runs, list cases whose MBps dropped more than the threshold (default 10%).
+# Exit code 1 if any case regressed. Shared/virtual hosts are noisy, use a larger megabytesPerCase and threshold there.
+#
+#   ./bbffr-bench > baseline.csv
+#   ...change code, rebuild...
+#   ./bbffr-bench > current.csv
+#   ./bench-compare.sh baseline.csv current.csv [thresholdPct]
+
+if [ $# -lt 2 ]; then
+    echo "usage: $0 baseline.csv current.csv [thresholdPct]"
+    exit 2
+fi
+
+awk -F, -v threshold="${3:-10}" '
+    FNR == 1 { next }                                               # CSV header
+    NR == FNR { baseline[$1 "," $2 "," $3 "," $4] = $5; next }
+    {
+        key = $1 "," $2 "," $3 "," $4
+        if (!(key in baseline) || baseline[key] <= 0)
+            next
+        change = ($5 - baseline[key]) * 100 / baseline[key]
+        if (change < -threshold)
+        {
+            printf "REGRESSED %s: %.1f -> %.1f MBps (%.1f%%)\n", key, baseline[key], $5, change
+            regressed++
+        }
+        compared++
+    }
+    END {
+        printf "%d cases compared, %d regressed (threshold %s%%)\n", compared, regressed, threshold
+        exit (regressed > 0)
+    }' "$1" "$2"
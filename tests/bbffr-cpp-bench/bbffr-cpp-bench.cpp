@@ -0,0 +1,190 @@
+/******************************************************************************
+ *  \file bbffr-cpp-bench.cpp
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2022 LooUQ Incorporated.
+ *  www.loouq.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ * Linux host throughput benchmark, lq::BlockBuffer<N> (C++ header-only) vs
+ * bbuffer_t (C) at the same buffer sizes. Results are CSV lines in the same
+ * format as bbffr-bench:
+ *   engine,op,bufferSz,opSz,MBps
+ * 
+ * The find case scans a full buffer for an absent needle (opSz is the needle
+ * length): std::search over BlockBuffer iterators vs bbffr_find().
+ * 
+ * Build/run (from this folder):
+ *   gcc -O2 -c -DDISABLE_ASSERT -I../../src ../../src/lq-bBuffer.c -o lq-bBuffer.o
+ *   g++ -O2 -std=c++11 -I../../src bbffr-cpp-bench.cpp lq-bBuffer.o -o bbffr-cpp-bench
+ *   ./bbffr-cpp-bench [megabytesPerCase]
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "lq-bBuffer.h"
+#include "lq-bBuffer.hpp"
+
+static uint64_t volume = 64ULL << 20;
+static volatile uint32_t sink;                                          // defeat dead-store elimination of copied data
+static char src[4096];
+static char dest[4096];
+static const char *needle = "+CME ERROR: ";
+
+
+static double nowSeconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char *engine, const char *op, size_t bufferSz, size_t opSz, uint64_t bytes, double elapsed)
+{
+    printf("%s,%s,%d,%d,%.1f\n", engine, op, (int)bufferSz, (int)opSz, (bytes / 1048576.0) / elapsed);
+}
+
+
+template <size_t N>
+static void benchCpp(size_t opSz)
+{
+    static lq::BlockBuffer<N> bffr;
+    uint64_t moved = 0;
+
+    bffr.reset();
+    double start = nowSeconds();
+    while (moved < volume)
+    {
+        bffr.push(src, opSz);
+        moved += bffr.pop(dest, opSz);
+        sink += dest[0];
+    }
+    report("BlockBuffer", "push+pop", N, opSz, moved, nowSeconds() - start);
+
+    moved = 0;
+    bffr.push(src, N / 2 + 3);                                          // leave contents wrapped
+    bffr.skip(N / 2 + 3);
+    bffr.push(src, N - 1);
+    start = nowSeconds();
+    while (moved < volume)
+    {
+        moved += bffr.peek(dest, opSz);
+        sink += dest[0];
+    }
+    report("BlockBuffer", "peek", N, opSz, moved, nowSeconds() - start);
+}
+
+
+static void benchC(char *raw, size_t bufferSz, size_t opSz)
+{
+    bbuffer_t bffr;
+    uint64_t moved = 0;
+
+    bbffr_init(&bffr, raw, bufferSz);
+    double start = nowSeconds();
+    while (moved < volume)
+    {
+        bbffr_push(&bffr, src, opSz);
+        moved += bbffr_pop(&bffr, dest, opSz);
+        sink += dest[0];
+    }
+    report("bbffr", "push+pop", bufferSz, opSz, moved, nowSeconds() - start);
+
+    moved = 0;
+    bbffr_push(&bffr, src, bufferSz / 2 + 3);
+    bbffr_skipTail(&bffr, bufferSz / 2 + 3);
+    bbffr_push(&bffr, src, bufferSz - 1);
+    start = nowSeconds();
+    while (moved < volume)
+    {
+        moved += bbffr_peek(&bffr, dest, opSz);
+        sink += dest[0];
+    }
+    report("bbffr", "peek", bufferSz, opSz, moved, nowSeconds() - start);
+}
+
+
+template <size_t N>
+static void benchFind(char *raw)
+{
+    static lq::BlockBuffer<N> bffr;
+    bbuffer_t cBffr;
+    uint64_t scanned = 0;
+
+    bffr.reset();
+    bffr.push(src, N / 2 + 3);
+    bffr.skip(N / 2 + 3);
+    bffr.push(src, N - 1);
+    double start = nowSeconds();
+    while (scanned < volume)
+    {
+        sink += bffr.find(needle);
+        scanned += bffr.size();
+    }
+    report("BlockBuffer", "find", N, strlen(needle), scanned, nowSeconds() - start);
+
+    scanned = 0;
+    bbffr_init(&cBffr, raw, N);
+    bbffr_push(&cBffr, src, N / 2 + 3);
+    bbffr_skipTail(&cBffr, N / 2 + 3);
+    bbffr_push(&cBffr, src, N - 1);
+    start = nowSeconds();
+    while (scanned < volume)
+    {
+        sink += bbffr_find(&cBffr, needle, 0, 0, false);
+        scanned += bbffr_getOccupied(&cBffr);
+    }
+    report("bbffr", "find", N, strlen(needle), scanned, nowSeconds() - start);
+}
+
+
+template <size_t N>
+static void benchSize(char *raw)
+{
+    const size_t opSizes[] = { 1, 16, 64, 200 };
+    for (size_t o = 0; o < sizeof(opSizes) / sizeof(opSizes[0]); o++)
+    {
+        benchCpp<N>(opSizes[o]);
+        benchC(raw, N, opSizes[o]);
+    }
+    benchFind<N>(raw);
+}
+
+
+int main(int argc, char *argv[])
+{
+    static char raw[4096];
+
+    if (argc > 1)
+        volume = strtoull(argv[1], NULL, 10) << 20;
+
+    for (size_t i = 0; i < sizeof(src); i++)                            // modem-like text without the find needle
+        src[i] = 'A' + (i % 26);
+
+    printf("engine,op,bufferSz,opSz,MBps\n");
+    benchSize<256>(raw);
+    benchSize<1000>(raw);                                               // not a power of two, compare/subtract wrap
+    benchSize<4096>(raw);
+    return 0;
+}
@@ -0,0 +1,326 @@
+/******************************************************************************
+ *  \file bbffr-fd-io.c
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2022 LooUQ Incorporated.
+ *  www.loouq.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ * Linux host check for bbffr_readFromFd() / bbffr_writeToFd() over pipes.
+ *
+ * Directed cases, each with the count, bbffrIo_t result, occupied and the
+ * chars (popped from the buffer or read back from the pipe) checked:
+ *   read:  wrap (readv, two spans), short read (pipe holds less than asked,
+ *          across the wrap too), maxSz cap (rest stays in the pipe), full
+ *          buffer (no read), EAGAIN on an empty non-blocking pipe, EOF
+ *          after the writer closes, bad descriptor
+ *   write: wrap (writev, two spans), maxSz cap, short write (non-blocking
+ *          pipe with less room than occupied, only what it took is popped),
+ *          EAGAIN on a full pipe, empty buffer (no write), EPIPE (reader
+ *          closed, SIGPIPE ignored)
+ * Then a stream relay: random chunks go into pipe A, through a 97 char
+ * bbuffer (readFromFd A, writeToFd B with random maxSz), out of pipe B and
+ * are compared with the generated sequence. Results are CSV lines:
+ *   case,transfers,result
+ *
+ * Build/run (from this folder):
+ *   gcc -O2 -DDISABLE_ASSERT -Wno-unknown-pragmas -I../../src bbffr-fd-io.c ../../src/lq-bBuffer.c -o bbffr-fd-io
+ *   ./bbffr-fd-io [relayChars]
+ *
+ * Defaults to 10,000,000 relayed chars. Exit code 0 on success.
+ *****************************************************************************/
+
+#define _GNU_SOURCE                                         // F_SETPIPE_SZ
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "lq-bBuffer.h"
+
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+
+static int failures = 0;
+static uint32_t rnd = 1;
+
+
+static inline uint32_t xorshift()
+{
+    uint32_t x = rnd;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return rnd = x;
+}
+
+static void check(int condition, const char *what)
+{
+    if (!condition)
+    {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+static void fillPattern(char *dest, uint32_t cnt, uint32_t seq)
+{
+    for (uint32_t i = 0; i < cnt; i++)
+        dest[i] = (char)('a' + (seq + i) % 26);
+}
+
+static void openPipe(int fds[2], bool nonBlocking)
+{
+    if (pipe(fds) != 0)
+    {
+        perror("pipe");
+        exit(1);
+    }
+    if (nonBlocking)
+    {
+        fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+        fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+    }
+}
+
+static void closePipe(int fds[2])
+{
+    if (fds[0] >= 0)
+        close(fds[0]);
+    if (fds[1] >= 0)
+        close(fds[1]);
+}
+
+/* Place an empty buffer's head and tail at offset, so the next transfer starts there */
+static void positionAt(bbuffer_t *bBuffer, bbffrSz_t offset)
+{
+    bbffr_reset(bBuffer);
+    bbffr_skipHead(bBuffer, offset);
+    bbffr_skipTail(bBuffer, offset);
+}
+
+
+static int checkRead()
+{
+    char raw[64];
+    char data[200];
+    char got[200];
+    bbuffer_t bBuffer;
+    bbffrIo_t io;
+    int fds[2];
+    int transfers = 0;
+
+    bbffr_init(&bBuffer, raw, sizeof(raw));
+    fillPattern(data, sizeof(data), 0);
+
+    /* wrap: 40 chars from offset 50 of 64, 14 then 26 */
+    openPipe(fds, true);
+    positionAt(&bBuffer, 50);
+    check(write(fds[1], data, 40) == 40, "read wrap: pipe fill");
+    io = bbffrIo_error;
+    check(bbffr_readFromFd(&bBuffer, fds[0], 100, &io) == 40 && io == bbffrIo_ok, "read wrap: count/result");
+    check(bbffr_pop(&bBuffer, got, sizeof(got)) == 40 && memcmp(got, data, 40) == 0, "read wrap: data");
+    transfers++;
+
+    /* short read: pipe holds 10, vacant 63 split at the wrap */
+    positionAt(&bBuffer, 60);
+    check(write(fds[1], data, 10) == 10, "short read: pipe fill");
+    check(bbffr_readFromFd(&bBuffer, fds[0], 100, &io) == 10 && io == bbffrIo_ok, "short read: count/result");
+    check(bbffr_getOccupied(&bBuffer) == 10, "short read: occupied");
+    check(bbffr_pop(&bBuffer, got, sizeof(got)) == 10 && memcmp(got, data, 10) == 0, "short read: data");
+    transfers++;
+
+    /* maxSz cap: 7 of 40, the rest is left in the pipe */
+    positionAt(&bBuffer, 0);
+    check(write(fds[1], data, 40) == 40, "read cap: pipe fill");
+    check(bbffr_readFromFd(&bBuffer, fds[0], 7, &io) == 7 && io == bbffrIo_ok, "read cap: count/result");
+    check(read(fds[0], got, sizeof(got)) == 33 && memcmp(got, data + 7, 33) == 0, "read cap: rest in pipe");
+    check(bbffr_pop(&bBuffer, got, sizeof(got)) == 7 && memcmp(got, data, 7) == 0, "read cap: data");
+    transfers++;
+
+    /* full buffer: vacant 0, pipe is not read */
+    positionAt(&bBuffer, 30);
+    bbffr_push(&bBuffer, data, 63);
+    check(write(fds[1], data, 5) == 5, "read full: pipe fill");
+    check(bbffr_readFromFd(&bBuffer, fds[0], 100, &io) == 0 && io == bbffrIo_ok, "read full: count/result");
+    check(read(fds[0], got, sizeof(got)) == 5, "read full: pipe untouched");
+    transfers++;
+
+    /* EAGAIN: empty non-blocking pipe */
+    positionAt(&bBuffer, 62);
+    check(bbffr_readFromFd(&bBuffer, fds[0], 100, &io) == 0 && io == bbffrIo_wouldBlock, "read EAGAIN: count/result");
+    check(bbffr_getOccupied(&bBuffer) == 0, "read EAGAIN: occupied");
+    transfers++;
+
+    /* EOF: writer closed, chars still in the pipe are read first */
+    check(write(fds[1], data, 3) == 3, "read EOF: pipe fill");
+    close(fds[1]);
+    fds[1] = -1;
+    check(bbffr_readFromFd(&bBuffer, fds[0], 100, NULL) == 3, "read EOF: chars before EOF");
+    check(bbffr_readFromFd(&bBuffer, fds[0], 100, &io) == 0 && io == bbffrIo_eof, "read EOF: count/result");
+    check(bbffr_getOccupied(&bBuffer) == 3, "read EOF: occupied");
+    closePipe(fds);
+    transfers += 2;
+
+    /* bad descriptor */
+    check(bbffr_readFromFd(&bBuffer, -1, 100, &io) == 0 && io == bbffrIo_error && errno == EBADF, "read EBADF: count/result");
+    transfers++;
+    return transfers;
+}
+
+
+static int checkWrite()
+{
+    static char raw[16384];
+    static char data[16384];
+    static char got[16384];
+    char smallRaw[64];
+    bbuffer_t bBuffer;
+    bbuffer_t smallBuffer;
+    bbffrIo_t io;
+    int fds[2];
+    int transfers = 0;
+
+    bbffr_init(&smallBuffer, smallRaw, sizeof(smallRaw));
+    fillPattern(data, sizeof(data), 3);
+
+    /* wrap: 40 chars from offset 50 of 64 */
+    openPipe(fds, true);
+    positionAt(&smallBuffer, 50);
+    bbffr_push(&smallBuffer, data, 40);
+    io = bbffrIo_error;
+    check(bbffr_writeToFd(&smallBuffer, fds[1], 100, &io) == 40 && io == bbffrIo_ok, "write wrap: count/result");
+    check(bbffr_getOccupied(&smallBuffer) == 0, "write wrap: popped");
+    check(read(fds[0], got, sizeof(got)) == 40 && memcmp(got, data, 40) == 0, "write wrap: data");
+    transfers++;
+
+    /* maxSz cap: 5 of 40 */
+    positionAt(&smallBuffer, 60);
+    bbffr_push(&smallBuffer, data, 40);
+    check(bbffr_writeToFd(&smallBuffer, fds[1], 5, &io) == 5 && io == bbffrIo_ok, "write cap: count/result");
+    check(bbffr_getOccupied(&smallBuffer) == 35, "write cap: only 5 popped");
+    check(read(fds[0], got, sizeof(got)) == 5 && memcmp(got, data, 5) == 0, "write cap: data");
+    check(bbffr_pop(&smallBuffer, got, sizeof(got)) == 35 && memcmp(got, data + 5, 35) == 0, "write cap: rest in buffer");
+    transfers++;
+
+    /* empty buffer: nothing to write, not an error */
+    check(bbffr_writeToFd(&smallBuffer, fds[1], 100, &io) == 0 && io == bbffrIo_ok, "write empty: count/result");
+    transfers++;
+    closePipe(fds);
+
+    /* short write: pipe takes 4096 of 10000 (past PIPE_BUF a non-blocking write may be partial), then EAGAIN */
+    openPipe(fds, true);
+    int pipeSz = fcntl(fds[1], F_SETPIPE_SZ, 4096);
+    bbffr_init(&bBuffer, raw, sizeof(raw));
+    positionAt(&bBuffer, sizeof(raw) - 3000);                                   // 3000 then 7000 at the wrap
+    bbffr_push(&bBuffer, data, 10000);
+    bbffrSz_t wrote = bbffr_writeToFd(&bBuffer, fds[1], 10000, &io);
+    check(pipeSz > 0 && wrote == pipeSz && io == bbffrIo_ok, "short write: count/result");
+    check(bbffr_getOccupied(&bBuffer) == 10000 - wrote, "short write: only written chars popped");
+    transfers++;
+    check(bbffr_writeToFd(&bBuffer, fds[1], 10000, &io) == 0 && io == bbffrIo_wouldBlock, "write EAGAIN: count/result");
+    check(bbffr_getOccupied(&bBuffer) == 10000 - wrote, "write EAGAIN: nothing popped");
+    transfers++;
+    check(read(fds[0], got, sizeof(got)) == wrote && memcmp(got, data, wrote) == 0, "short write: data");
+    check(bbffr_writeToFd(&bBuffer, fds[1], 10000, &io) > 0 && io == bbffrIo_ok, "short write: resumes");
+    check(read(fds[0], got, sizeof(got)) > 0 && memcmp(got, data + wrote, 1) == 0, "short write: resumes in order");
+    transfers++;
+
+    /* EPIPE: reader closed */
+    close(fds[0]);
+    fds[0] = -1;
+    check(bbffr_writeToFd(&bBuffer, fds[1], 100, &io) == 0 && io == bbffrIo_error && errno == EPIPE, "write EPIPE: count/result");
+    closePipe(fds);
+    transfers++;
+    return transfers;
+}
+
+
+/* Stream through the buffer between two pipes, random transfer sizes so every wrap position is crossed */
+static uint64_t relay(uint64_t relayChars)
+{
+    char raw[97];
+    char chunk[300];
+    char got[300];
+    bbuffer_t bBuffer;
+    bbffrIo_t io;
+    int inFds[2], outFds[2];
+    uint64_t sent = 0, received = 0, transfers = 0;
+    int startFailures = failures;
+
+    bbffr_init(&bBuffer, raw, sizeof(raw));
+    openPipe(inFds, true);
+    openPipe(outFds, true);
+
+    while (received < relayChars && failures == startFailures)
+    {
+        uint32_t chunkSz = MIN(relayChars - sent, xorshift() % sizeof(chunk));
+        fillPattern(chunk, chunkSz, sent);
+        ssize_t wrote = write(inFds[1], chunk, chunkSz);
+        if (wrote > 0)
+            sent += wrote;
+
+        bbffrSz_t readCnt = bbffr_readFromFd(&bBuffer, inFds[0], 1 + xorshift() % 120, &io);
+        check(io == bbffrIo_ok || (io == bbffrIo_wouldBlock && readCnt == 0), "relay: read result");
+        bbffrSz_t writeCnt = bbffr_writeToFd(&bBuffer, outFds[1], 1 + xorshift() % 120, &io);
+        check(io == bbffrIo_ok, "relay: write result");
+        transfers += (readCnt > 0) + (writeCnt > 0);
+
+        ssize_t gotCnt = read(outFds[0], got, sizeof(got));
+        if (gotCnt > 0)
+        {
+            char want[300];
+            fillPattern(want, gotCnt, received);
+            check(memcmp(got, want, gotCnt) == 0, "relay: data");
+            received += gotCnt;
+        }
+    }
+    closePipe(inFds);
+    closePipe(outFds);
+    return transfers;
+}
+
+
+int main(int argc, char *argv[])
+{
+    uint64_t relayChars = 10000000;
+
+    if (argc > 1)
+        relayChars = strtoull(argv[1], NULL, 10);
+
+    signal(SIGPIPE, SIG_IGN);                                                   // EPIPE case, not a signal
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    printf("case,transfers,result\n");
+
+    int transfers = checkRead();
+    printf("read,%d,%s\n", transfers, failures ? "FAIL" : "PASS");
+    int readFailures = failures;
+
+    transfers = checkWrite();
+    printf("write,%d,%s\n", transfers, (failures > readFailures) ? "FAIL" : "PASS");
+    int writeFailures = failures;
+
+    uint64_t relayed = relay(relayChars);
+    printf("relay,%llu,%s\n", (unsigned long long)relayed, (failures > writeFailures) ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
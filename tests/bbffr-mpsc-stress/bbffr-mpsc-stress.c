@@ -0,0 +1,293 @@
+/******************************************************************************
+ *  \file bbffr-mpsc-stress.c
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2022 LooUQ Incorporated.
+ *  www.loouq.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ * Linux host stress test for bbuffer multi-producer/single-consumer operation.
+ * 
+ * Producer threads reserve variable length messages, fill them with a header
+ * (producer id, length, per-producer sequence) and a sequence-derived payload,
+ * hold several reservations and finalize them in random order with random rollbacks.
+ * Short grants are rolled back. The consumer reassembles the stream (mixing mpscPop
+ * and mpscReadable bounded popBlock) and verifies every committed message is received
+ * exactly once, intact, and in per-producer sequence order; no rolled back (void) 
+ * region may reach the consumer.
+ * 
+ * Build/run (from this folder):
+ *   gcc -O2 -pthread -DDISABLE_ASSERT -I../../src bbffr-mpsc-stress.c ../../src/lq-bBuffer.c -o bbffr-mpsc-stress
+ *   ./bbffr-mpsc-stress [messagesPerProducer] [producers] [bufferSz]
+ * 
+ * Defaults to 1,000,000 messages from each of 4 producers through a 256 byte buffer. Exit code 0 on success.
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "lq-bBuffer.h"
+
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+
+#define MAX_PRODUCERS 16
+#define MAX_HELD 3                                          // reservations a producer holds before finalizing
+#define HEADER_SZ 8                                         // magic, id, len(2), seq(4)
+#define MESSAGE_MAX 64
+#define MAGIC 0xA5
+
+typedef struct producerCtrl_tag
+{
+    pthread_t thread;
+    uint8_t id;
+    uint64_t committed;                                     // messages committed
+    uint64_t committedSum;                                  // sum of committed sequence numbers
+    uint64_t rollbacks;
+    uint64_t shortGrants;
+} producerCtrl_t;
+
+static bbuffer_t bBuffer;
+static bbffrMpsc_t mpsc;
+static char *rawBuffer;
+static uint64_t messagesPerProducer = 1000000;
+static int producerCnt = 4;
+static producerCtrl_t producers[MAX_PRODUCERS];
+static uint64_t receivedCnt[MAX_PRODUCERS];                // consumer side, per producer
+static uint64_t receivedSum[MAX_PRODUCERS];
+static volatile int failed = 0;
+
+
+/* Payload char i of a message; depends on producer and sequence so misplaced or stale chars are detected */
+static inline char payloadByte(uint8_t id, uint32_t seq, uint16_t i)
+{
+    uint32_t x = (seq * 0x9E3779B1u) ^ ((uint32_t)id << 24) ^ (i * 0x85EBCA6Bu);
+    return (char)(x >> 24);
+}
+
+
+static inline uint32_t xorshift(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+
+static void fillMessage(char *msg, uint8_t id, uint16_t len, uint32_t seq)
+{
+    msg[0] = (char)MAGIC;
+    msg[1] = (char)id;
+    memcpy(msg + 2, &len, 2);
+    memcpy(msg + 4, &seq, 4);
+    for (uint16_t i = HEADER_SZ; i < len; i++)
+        msg[i] = payloadByte(id, seq, i);
+}
+
+
+static void *producer(void *arg)
+{
+    producerCtrl_t *ctrl = (producerCtrl_t *)arg;
+    uint32_t rnd = 0x1234567 + ctrl->id * 0x10001;
+    uint32_t nextSeq = 1;
+    bbffrReservation_t held[MAX_HELD];
+    uint32_t heldSeq[MAX_HELD];
+    int heldCnt = 0;
+
+    while ((ctrl->committed < messagesPerProducer || heldCnt > 0) && !failed)
+    {
+        bool reserved = false;
+        if (heldCnt < MAX_HELD && ctrl->committed + heldCnt < messagesPerProducer)
+        {
+            uint16_t len = HEADER_SZ + xorshift(&rnd) % (MESSAGE_MAX - HEADER_SZ + 1);
+            bbffrReservation_t resv;
+            bbffrSz_t grant = bbffr_mpscReserve(&mpsc, &resv, len);
+            if (grant == len)
+            {
+                fillMessage(resv.ptr, ctrl->id, len, nextSeq);
+                held[heldCnt] = resv;
+                heldSeq[heldCnt++] = nextSeq++;
+                reserved = true;
+            }
+            else if (grant > 0)
+            {
+                memset(resv.ptr, '?', grant);                       // short grant, must never reach the consumer
+                bbffr_mpscFinalize(&mpsc, &resv, false);
+                ctrl->shortGrants++;
+            }
+        }
+
+        if (heldCnt > 0 && (!reserved || heldCnt == MAX_HELD || xorshift(&rnd) % 2))
+        {
+            int i = xorshift(&rnd) % heldCnt;                       // finalize out of reservation order
+            bool commit = (xorshift(&rnd) % 8) != 0;
+            if (!commit)
+                memset(held[i].ptr, '?', held[i].len);
+            if (bbffr_mpscFinalize(&mpsc, &held[i], commit) != commit)
+            {
+                printf("FAIL: producer %d finalize result\n", ctrl->id);
+                failed = 1;
+            }
+            if (commit)
+            {
+                ctrl->committed++;
+                ctrl->committedSum += heldSeq[i];
+            }
+            else
+                ctrl->rollbacks++;
+            held[i] = held[heldCnt - 1];
+            heldSeq[i] = heldSeq[--heldCnt];
+        }
+        else if (!reserved)
+            sched_yield();                                          // full, let consumer run (single core hosts)
+    }
+    return NULL;
+}
+
+
+static void *consumer(void *arg)
+{
+    (void)arg;
+    uint32_t rnd = 0x7654321;
+    uint64_t expected = messagesPerProducer * producerCnt;
+    uint64_t received = 0;
+    uint32_t lastSeq[MAX_PRODUCERS] = {0};
+    char pending[2 * MESSAGE_MAX];
+    uint16_t pendingLen = 0;
+
+    while (received < expected && !failed)
+    {
+        uint16_t requestSz = 1 + xorshift(&rnd) % (sizeof(pending) - pendingLen);
+        uint16_t gotSz;
+
+        if (xorshift(&rnd) % 2)
+            gotSz = bbffr_mpscPop(&mpsc, pending + pendingLen, requestSz);
+        else                                                        // zero-copy read bounded by mpscReadable
+        {
+            char *copyFrom;
+            gotSz = bbffr_popBlock(&bBuffer, &copyFrom, MIN(requestSz, bbffr_mpscReadable(&mpsc)));
+            memcpy(pending + pendingLen, copyFrom, gotSz);
+            bbffr_popBlockFinalize(&bBuffer, true);
+        }
+        if (gotSz == 0)
+        {
+            sched_yield();                                          // empty, let producers run (single core hosts)
+            continue;
+        }
+        pendingLen += gotSz;
+
+        while (pendingLen >= HEADER_SZ)
+        {
+            uint8_t id = (uint8_t)pending[1];
+            uint16_t len;
+            uint32_t seq;
+            memcpy(&len, pending + 2, 2);
+            memcpy(&seq, pending + 4, 4);
+            if ((uint8_t)pending[0] != MAGIC || id >= producerCnt || len < HEADER_SZ || len > MESSAGE_MAX)
+            {
+                printf("FAIL: bad header after %" PRIu64 " messages\n", received);
+                failed = 1;
+                break;
+            }
+            if (pendingLen < len)
+                break;
+            if (seq <= lastSeq[id])
+            {
+                printf("FAIL: producer %d sequence %" PRIu32 " after %" PRIu32 "\n", id, seq, lastSeq[id]);
+                failed = 1;
+                break;
+            }
+            for (uint16_t i = HEADER_SZ; i < len; i++)
+            {
+                if (pending[i] != payloadByte(id, seq, i))
+                {
+                    printf("FAIL: producer %d sequence %" PRIu32 " payload mismatch\n", id, seq);
+                    failed = 1;
+                    break;
+                }
+            }
+            lastSeq[id] = seq;
+            receivedCnt[id]++;
+            receivedSum[id] += seq;
+            received++;
+            pendingLen -= len;
+            memmove(pending, pending + len, pendingLen);
+        }
+    }
+    return NULL;
+}
+
+
+int main(int argc, char *argv[])
+{
+    bbffrSz_t bufferSz = 256;
+
+    if (argc > 1)
+        messagesPerProducer = strtoull(argv[1], NULL, 10);
+    if (argc > 2)
+        producerCnt = MIN(atoi(argv[2]), MAX_PRODUCERS);
+    if (argc > 3)
+        bufferSz = (bbffrSz_t)strtoul(argv[3], NULL, 10);
+
+    rawBuffer = malloc(bufferSz);
+    bbffr_init(&bBuffer, rawBuffer, bufferSz);
+    bbffr_mpscInit(&mpsc, &bBuffer);
+    printf("bbffr MPSC stress: %" PRIu64 " messages x %d producers, buffer=%d\n", messagesPerProducer, producerCnt, bufferSz);
+
+    pthread_t consumerThread;
+    pthread_create(&consumerThread, NULL, consumer, NULL);
+    for (int i = 0; i < producerCnt; i++)
+    {
+        producers[i].id = (uint8_t)i;
+        pthread_create(&producers[i].thread, NULL, producer, &producers[i]);
+    }
+    for (int i = 0; i < producerCnt; i++)
+        pthread_join(producers[i].thread, NULL);
+    pthread_join(consumerThread, NULL);
+
+    uint64_t rollbacks = 0, shortGrants = 0;
+    for (int i = 0; i < producerCnt; i++)
+    {
+        rollbacks += producers[i].rollbacks;
+        shortGrants += producers[i].shortGrants;
+        if (!failed && (receivedCnt[i] != producers[i].committed || receivedSum[i] != producers[i].committedSum))
+        {
+            printf("FAIL: producer %d committed %" PRIu64 ", received %" PRIu64 "\n", i, producers[i].committed, receivedCnt[i]);
+            failed = 1;
+        }
+    }
+    for (int i = 0; i < BBFFR_MPSC_SLOTS && bbffr_getOccupied(&bBuffer) != 0; i++)
+        bbffr_mpscReadable(&mpsc);                                  // skip trailing rolled back regions
+    printf("  rollbacks=%" PRIu64 " shortGrants=%" PRIu64 "\n", rollbacks, shortGrants);
+
+    if (failed || bbffr_getOccupied(&bBuffer) != 0)
+    {
+        printf("FAILED (occupied=%d)\n", bbffr_getOccupied(&bBuffer));
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
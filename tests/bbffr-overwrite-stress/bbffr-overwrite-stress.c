@@ -0,0 +1,318 @@
+/******************************************************************************
+ *  \file bbffr-overwrite-stress.c
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2022 LooUQ Incorporated.
+ *  www.loouq.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ * Linux host stress test for bbuffer overwrite (lossy) mode.
+ * 
+ * A producer thread pushes without regard to occupancy (push/pushv/pushBlock, or pushRecord in record mode) while a consumer
+ * thread pops (pop, popv, peek, skipTail, popRecord/skipRecord) and verifies every read is intact: the producer is allowed to
+ * discard, but a read must never return torn or overwritten chars, and every discontinuity in the stream must be
+ * reported by bbffr_checkOverrun().
+ * 
+ * Raw mode stream char n is (char)n, a buffer size that is not a multiple of 256 makes stale chars detectable. Record
+ * mode records carry a sequence number and a payload derived from it.
+ * 
+ * Build/run (from this folder):
+ *   gcc -O2 -pthread -DDISABLE_ASSERT -I../../src bbffr-overwrite-stress.c ../../src/lq-bBuffer.c -o bbffr-overwrite-stress
+ *   ./bbffr-overwrite-stress [totalBytes] [bufferSz] [records]
+ * 
+ * Defaults to 1,000,000,000 bytes through a 257 byte buffer. Any 3rd argument selects record mode. Exit code 0 on success.
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "lq-bBuffer.h"
+
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+
+static bbuffer_t bBuffer;
+static uint64_t totalBytes = 1000000000ULL;
+static bool recordMode = false;
+static volatile int failed = 0;
+static volatile int producerDone = 0;
+static uint64_t gaps = 0;
+
+
+static inline uint32_t xorshift(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+
+static void fail(const char *reason, uint64_t at)
+{
+    printf("FAIL: %s at %" PRIu64 "\n", reason, at);
+    failed = 1;
+}
+
+
+static void *producer(void *arg)
+{
+    (void)arg;
+    uint32_t rnd = 0x1234567;
+    uint64_t sent = 0;
+    uint32_t seq = 0;
+    char chunk[300];
+
+    while (sent < totalBytes && !failed)
+    {
+        uint16_t requestSz = 1 + xorshift(&rnd) % sizeof(chunk);
+        if (recordMode)
+        {
+            requestSz = MIN(requestSz, bbffr_getCapacity(&bBuffer) - 3) / 2 + 4;       // fits with header, room for others
+            memcpy(chunk, &seq, 4);
+            for (uint16_t i = 4; i < requestSz; i++)
+                chunk[i] = (char)(seq + i);
+            if (!bbffr_pushRecord(&bBuffer, chunk, requestSz))
+            {
+                fail("pushRecord refused in overwrite mode", seq);
+                break;
+            }
+            seq++;
+        }
+        else
+        {
+            for (uint16_t i = 0; i < requestSz; i++)
+                chunk[i] = (char)(sent + i);
+            uint16_t pushed;
+            uint32_t op = xorshift(&rnd) % 3;
+            if (op == 0)
+                pushed = bbffr_push(&bBuffer, chunk, requestSz);
+            else if (op == 1)
+            {
+                bbffrSpan_t srcv[2] = { { chunk, requestSz / 2 }, { chunk + requestSz / 2, requestSz - requestSz / 2 } };
+                pushed = bbffr_pushv(&bBuffer, srcv, 2);
+            }
+            else                                                        // pushBlock, grant ends at the wrap
+            {
+                char *copyTo;
+                uint16_t toEdge = bBuffer.bufferEnd - bBuffer.head;
+                uint32_t overwritten = bBuffer.stats.overwrittenBytes;
+                pushed = bbffr_pushBlock(&bBuffer, &copyTo, requestSz);
+                memcpy(copyTo, chunk, pushed);
+                bbffr_pushBlockFinalize(&bBuffer, true);
+                if (bBuffer.stats.overwrittenBytes - overwritten > pushed)
+                {
+                    fail("pushBlock discarded more than its grant", sent);
+                    break;
+                }
+                requestSz = MIN(requestSz, toEdge);
+            }
+            if (pushed != MIN(requestSz, bbffr_getCapacity(&bBuffer)))
+            {
+                fail("push truncated in overwrite mode", sent);
+                break;
+            }
+            requestSz = pushed;
+        }
+        sent += requestSz;
+        if (xorshift(&rnd) % 4 == 0)
+            sched_yield();                                              // let consumer run sometimes (single core hosts)
+    }
+    producerDone = 1;
+    return NULL;
+}
+
+
+static void *consumer(void *arg)
+{
+    (void)arg;
+    uint32_t rnd = 0x7654321;
+    uint64_t received = 0;
+    uint32_t nextSeq = 0;
+    char expect = 0;
+    bool synced = true;                                                 // expected next char/record is known
+    char chunk[512];
+    char peeked[512];
+
+    while (!failed)
+    {
+        bool done = producerDone;                                       // sampled before the read, then drain
+        uint16_t gotSz = 0;
+        bool contiguous = true;
+        uint32_t op = xorshift(&rnd) % 4;
+
+        if (op == 0)                                                    // skip, position unknown until next read
+        {
+            if (recordMode)
+                bbffr_skipRecord(&bBuffer);
+            else
+                bbffr_skipTail(&bBuffer, 1 + xorshift(&rnd) % sizeof(chunk));
+            synced = false;
+        }
+        else if (recordMode)
+        {
+            gotSz = bbffr_popRecord(&bBuffer, chunk, sizeof(chunk));
+            if (gotSz > 0)
+            {
+                uint32_t seq;
+                memcpy(&seq, chunk, 4);
+                for (uint16_t i = 4; i < gotSz; i++)
+                {
+                    if (chunk[i] != (char)(seq + i))
+                    {
+                        fail("torn record", seq);
+                        break;
+                    }
+                }
+                if (synced && seq < nextSeq)
+                    fail("record repeated", seq);
+                contiguous = (!synced || seq == nextSeq);
+                nextSeq = seq + 1;
+            }
+        }
+        else
+        {
+            uint16_t requestSz = 1 + xorshift(&rnd) % sizeof(chunk);
+            if (op == 1)                                                // peek must be intact too
+            {
+                uint16_t peekSz = bbffr_peek(&bBuffer, peeked, requestSz);
+                for (uint16_t i = 1; i < peekSz; i++)
+                {
+                    if (peeked[i] != (char)(peeked[0] + i))
+                    {
+                        fail("torn peek", received + i);
+                        break;
+                    }
+                }
+            }
+            uint16_t splitAt = requestSz;
+            if (op == 2)                                                // popv spans are each intact, a gap between them is an overrun
+            {
+                splitAt = xorshift(&rnd) % (requestSz + 1);
+                bbffrSpan_t destv[2] = { { chunk, splitAt }, { chunk + splitAt, (bbffrSz_t)(requestSz - splitAt) } };
+                gotSz = bbffr_popv(&bBuffer, destv, 2);
+            }
+            else
+                gotSz = bbffr_pop(&bBuffer, chunk, requestSz);
+            for (uint16_t i = 1; i < gotSz; i++)
+            {
+                if (i == splitAt)
+                    contiguous = (chunk[i] == (char)(chunk[i - 1] + 1));
+                else if (chunk[i] != (char)(chunk[i - 1] + 1))
+                {
+                    fail("torn read", received + i);
+                    break;
+                }
+            }
+            if (gotSz > 0)
+            {
+                contiguous = contiguous && (!synced || chunk[0] == expect);
+                expect = chunk[gotSz - 1] + 1;
+            }
+        }
+
+        if (gotSz > 0)
+        {
+            bool overrun = bbffr_checkOverrun(&bBuffer);
+            if (!contiguous)
+            {
+                gaps++;
+                if (!overrun)
+                    fail("discontinuity not reported as overrun", received);
+            }
+            synced = true;
+        }
+        else if (!synced)
+            bbffr_checkOverrun(&bBuffer);                               // discards before the resync read are not judged
+        received += gotSz;
+
+        if (gotSz == 0 && op != 0)                                      // skips don't yield, keep reads back to back
+        {
+            if (done && bbffr_getOccupied(&bBuffer) == 0)
+                break;
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+
+/* pushBlock near the wrap: the grant is limited by the edge, only that much may be discarded */
+static bool checkPushBlockWrap()
+{
+    char raw[64];
+    char fill[60] = {0};
+    char *copyTo;
+    bbuffer_t wrapBuffer;
+
+    bbffr_initOverwrite(&wrapBuffer, raw, sizeof(raw), false);
+    bbffr_push(&wrapBuffer, fill, 60);
+    bbffr_skipTail(&wrapBuffer, 10);                                    // head 60, tail 10
+    bbffrSz_t granted = bbffr_pushBlock(&wrapBuffer, &copyTo, 40);
+    bbffr_pushBlockFinalize(&wrapBuffer, true);
+    if (granted != 4 || bbffr_getOccupied(&wrapBuffer) != 54 || wrapBuffer.stats.overwrittenBytes != 0)
+    {
+        printf("FAIL: pushBlock at wrap granted %d, occupied %d (expected 4, 54)\n", granted, bbffr_getOccupied(&wrapBuffer));
+        return false;
+    }
+    return true;
+}
+
+
+int main(int argc, char *argv[])
+{
+    bbffrSz_t bufferSz = 257;
+
+    if (argc > 1)
+        totalBytes = strtoull(argv[1], NULL, 10);
+    if (argc > 2)
+        bufferSz = (bbffrSz_t)strtoul(argv[2], NULL, 10);
+    recordMode = (argc > 3);
+
+    if (!checkPushBlockWrap())
+        return 1;
+
+    char *rawBuffer = malloc(bufferSz);
+    bbffr_initOverwrite(&bBuffer, rawBuffer, bufferSz, recordMode);
+    printf("bbffr overwrite stress: %" PRIu64 " bytes, buffer=%d%s\n", totalBytes, bufferSz, recordMode ? " (records)" : "");
+
+    pthread_t producerThread, consumerThread;
+    pthread_create(&consumerThread, NULL, consumer, NULL);
+    pthread_create(&producerThread, NULL, producer, NULL);
+    pthread_join(producerThread, NULL);
+    pthread_join(consumerThread, NULL);
+
+    bbffrStats_t stats;
+    bbffr_getStats(&bBuffer, &stats);
+    printf("  in=%lu out=%lu overwritten=%lu overruns=%lu gaps=%" PRIu64 "\n", (unsigned long)stats.bytesIn, (unsigned long)stats.bytesOut,
+           (unsigned long)stats.overwrittenBytes, (unsigned long)stats.overruns, gaps);
+    if (failed || (uint32_t)(stats.bytesIn - stats.bytesOut - stats.overwrittenBytes) != 0)
+    {
+        printf("FAILED\n");
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
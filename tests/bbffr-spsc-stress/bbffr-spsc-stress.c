@@ -0,0 +1,297 @@
+/******************************************************************************
+ *  \file bbffr-spsc-stress.c
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2022 LooUQ Incorporated.
+ *  www.loouq.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ * Linux host stress test for bbuffer single-producer/single-consumer operation.
+ * 
+ * A producer thread pushes a position-derived byte sequence (mixing push, pushv
+ * and pushBlock) while a consumer thread pops (mixing pop, popv, popBlock, peek
+ * and peekSpans, nested transactions with rollback) and verifies every byte is received 
+ * exactly once and in order. No locks or critical sections are used, only the buffer's 
+ * own index publication. Watermarks at 3/4 and 1/4 full must fire alternately, high on
+ * the producer thread and low on the consumer thread.
+ * 
+ * Build/run (from this folder):
+ *   gcc -O2 -pthread -DDISABLE_ASSERT -I../../src bbffr-spsc-stress.c ../../src/lq-bBuffer.c -o bbffr-spsc-stress
+ *   ./bbffr-spsc-stress [totalBytes] [bufferSz] [mirrored]
+ * 
+ * Defaults to 4,000,000,000 bytes through a 257 byte buffer. Exit code 0 on success.
+ * Any 3rd argument selects the mirrored backend (bufferSz must be a multiple of page size).
+ * Add -DBBFFR_LARGE to the build to run the 32-bit size build (bufferSz may then exceed 64KB).
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "lq-bBuffer.h"
+
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+
+static bbuffer_t bBuffer;
+static char *rawBuffer;
+static uint64_t totalBytes = 4000000000ULL;
+static volatile int failed = 0;
+static pthread_t producerThread, consumerThread;
+static uint64_t highFired, lowFired;                        // watermark callbacks, must alternate high/low
+
+
+/* Byte at stream position n; not periodic in any buffer size so a skipped/repeated block is always detected */
+static inline char streamByte(uint64_t n)
+{
+    uint64_t x = n * 0x9E3779B97F4A7C15ULL;
+    return (char)(x >> 56);
+}
+
+
+static inline uint32_t xorshift(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+
+/* High must fire on the producer thread, low on the consumer thread, alternating (one callback per crossing) */
+static void watermarkCB(bbuffer_t *bbffr, bbffrWatermark_t watermark, bbffrSz_t occupied)
+{
+    (void)bbffr;
+    if (watermark == bbffrWatermark_high)
+    {
+        if (!pthread_equal(pthread_self(), producerThread) || highFired != lowFired || occupied < bBuffer.highMark)
+        {
+            printf("FAIL: high watermark #%" PRIu64 " (occupied=%d)\n", highFired, occupied);
+            failed = 1;
+        }
+        highFired++;
+    }
+    else
+    {
+        if (!pthread_equal(pthread_self(), consumerThread) || lowFired + 1 != highFired || occupied > bBuffer.lowMark)
+        {
+            printf("FAIL: low watermark #%" PRIu64 " (occupied=%d)\n", lowFired, occupied);
+            failed = 1;
+        }
+        lowFired++;
+    }
+}
+
+
+static void *producer(void *arg)
+{
+    (void)arg;
+    uint32_t rnd = 0x1234567;
+    uint64_t sent = 0;
+    char chunk[512];
+
+    while (sent < totalBytes && !failed)
+    {
+        uint16_t requestSz = 1 + xorshift(&rnd) % sizeof(chunk);
+        requestSz = (uint16_t)MIN(requestSz, totalBytes - sent);
+
+        uint32_t op = xorshift(&rnd) % 3;
+        if (op < 2)                                                     // push or pushv (copy in)
+        {
+            for (uint16_t i = 0; i < requestSz; i++)
+                chunk[i] = streamByte(sent + i);
+            uint16_t pushed;
+            if (op == 0)
+                pushed = bbffr_push(&bBuffer, chunk, requestSz);
+            else
+            {
+                bbffrSpan_t srcv[2] = { { chunk, requestSz / 2 }, { chunk + requestSz / 2, requestSz - requestSz / 2 } };
+                pushed = bbffr_pushv(&bBuffer, srcv, 2);
+            }
+            if (pushed == 0)
+                sched_yield();                                          // full, let consumer run (single core hosts)
+            sent += pushed;
+        }
+        else                                                            // pushBlock (fill in place), occasional rollback
+        {
+            char *copyTo;
+            uint16_t blockSz = bbffr_pushBlock(&bBuffer, &copyTo, requestSz);
+            bool commit = (xorshift(&rnd) % 8) != 0;
+            for (uint16_t i = 0; i < blockSz; i++)
+                copyTo[i] = commit ? streamByte(sent + i) : '?';
+            bbffr_pushBlockFinalize(&bBuffer, commit);
+            if (commit)
+                sent += blockSz;
+            if (blockSz == 0)
+                sched_yield();
+        }
+    }
+    return NULL;
+}
+
+
+static void *consumer(void *arg)
+{
+    (void)arg;
+    uint32_t rnd = 0x7654321;
+    uint64_t received = 0;
+    uint64_t nextReport = 1ULL << 30;
+    char chunk[512];
+
+    while (received < totalBytes && !failed)
+    {
+        uint16_t requestSz = 1 + xorshift(&rnd) % sizeof(chunk);
+        uint16_t gotSz;
+        char *copyFrom = chunk;
+        uint32_t op = xorshift(&rnd) % 7;
+
+        if (op == 0)                                                    // peek must agree with a following pop
+        {
+            char peeked[sizeof(chunk)];
+            uint16_t peekSz = bbffr_peek(&bBuffer, peeked, requestSz);
+            gotSz = bbffr_pop(&bBuffer, chunk, peekSz);
+            if (gotSz != peekSz || memcmp(peeked, chunk, gotSz) != 0)
+            {
+                printf("FAIL: peek/pop mismatch at %" PRIu64 "\n", received);
+                failed = 1;
+                break;
+            }
+        }
+        else if (op == 1)
+        {
+            gotSz = bbffr_pop(&bBuffer, chunk, requestSz);
+        }
+        else if (op == 2)                                               // popv, scatter to 3 destinations
+        {
+            bbffrSpan_t destv[3] = { { chunk, requestSz / 3 }, { chunk + requestSz / 3, requestSz / 3 }, { chunk + 2 * (requestSz / 3), requestSz - 2 * (requestSz / 3) } };
+            gotSz = bbffr_popv(&bBuffer, destv, 3);
+        }
+        else if (op == 3)                                               // peekSpans (zero-copy) then skipTail
+        {
+            bbffrSpan_t spans[2];
+            bbffr_peekSpans(&bBuffer, spans, requestSz);
+            memcpy(chunk, spans[0].ptr, spans[0].len);
+            memcpy(chunk + spans[0].len, spans[1].ptr, spans[1].len);
+            gotSz = spans[0].len + spans[1].len;
+            bbffr_skipTail(&bBuffer, gotSz);
+        }
+        else if (op == 4)                                               // transaction: pop, then a nested speculative pop that is rolled back
+        {
+            char speculative[sizeof(chunk)];
+            bbffr_startTransaction(&bBuffer);
+            gotSz = bbffr_pop(&bBuffer, chunk, requestSz / 2);
+            bbffr_startTransaction(&bBuffer);
+            uint16_t speculativeSz = bbffr_pop(&bBuffer, speculative, requestSz - requestSz / 2);
+            for (uint16_t i = 0; i < speculativeSz; i++)
+            {
+                if (speculative[i] != streamByte(received + gotSz + i))     // producer must not overwrite checkpointed chars
+                {
+                    printf("FAIL: speculative byte mismatch at %" PRIu64 "\n", received + gotSz + i);
+                    failed = 1;
+                    break;
+                }
+            }
+            bbffr_rollbackTransaction(&bBuffer);
+            if (xorshift(&rnd) % 4 == 0)
+            {
+                bbffr_rollbackTransaction(&bBuffer);                    // whole transaction re-read next pass
+                gotSz = 0;
+            }
+            else
+                bbffr_commitTransaction(&bBuffer);
+        }
+        else                                                            // popBlock (copy out in place)
+        {
+            gotSz = bbffr_popBlock(&bBuffer, &copyFrom, requestSz);
+        }
+
+        for (uint16_t i = 0; i < gotSz; i++)
+        {
+            if (copyFrom[i] != streamByte(received + i))
+            {
+                printf("FAIL: byte mismatch at %" PRIu64 "\n", received + i);
+                failed = 1;
+                break;
+            }
+        }
+        if (op >= 5)
+        {
+            bool commit = (xorshift(&rnd) % 8) != 0;                    // rolled back blocks are re-read next pass
+            bbffr_popBlockFinalize(&bBuffer, commit);
+            if (!commit)
+                gotSz = 0;
+        }
+        received += gotSz;
+        if (gotSz == 0)
+            sched_yield();                                              // empty, let producer run (single core hosts)
+
+        if (received >= nextReport)
+        {
+            printf("  %" PRIu64 " MB verified\n", received >> 20);
+            nextReport += 1ULL << 30;
+        }
+    }
+    return NULL;
+}
+
+
+int main(int argc, char *argv[])
+{
+    bbffrSz_t bufferSz = 257;
+
+    if (argc > 1)
+        totalBytes = strtoull(argv[1], NULL, 10);
+    if (argc > 2)
+        bufferSz = (bbffrSz_t)strtoul(argv[2], NULL, 10);
+
+    if (argc > 3)
+    {
+        if (!bbffr_initMirrored(&bBuffer, bufferSz))
+        {
+            printf("FAILED: mirrored buffer init\n");
+            return 1;
+        }
+    }
+    else
+    {
+        rawBuffer = malloc(bufferSz);
+        bbffr_init(&bBuffer, rawBuffer, bufferSz);
+    }
+    bbffr_setWatermarks(&bBuffer, bufferSz * 3 / 4, bufferSz / 4, watermarkCB);
+    printf("bbffr SPSC stress: %" PRIu64 " bytes, buffer=%d%s\n", totalBytes, bufferSz, (argc > 3) ? " (mirrored)" : "");
+
+    pthread_create(&consumerThread, NULL, consumer, NULL);
+    pthread_create(&producerThread, NULL, producer, NULL);
+    pthread_join(producerThread, NULL);
+    pthread_join(consumerThread, NULL);
+    printf("  watermarks: high=%" PRIu64 " low=%" PRIu64 "\n", highFired, lowFired);
+
+    if (failed || bbffr_getOccupied(&bBuffer) != 0 || highFired == 0 || lowFired + 1 < highFired)
+    {
+        printf("FAILED (occupied=%d)\n", bbffr_getOccupied(&bBuffer));
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
@@ -0,0 +1,1237 @@
+/******************************************************************************
+ *  \file buffer-fuzz.c
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2022 LooUQ Incorporated.
+ *  www.loouq.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ * Linux host differential fuzz test for bbuffer, pbuffer and cbuffer.
+ * 
+ * Random operation sequences are applied to the buffer and to a reference
+ * model (a plain array deque: append at back, memmove from front). After each
+ * operation the returned counts/data and the buffer's occupied/vacant are
+ * compared with the model. Operations exercised:
+ *   bbuffer: push, pushv, pushBlock (commit/rollback), pushSpans (then a
+ *            full, partial or no skipHead), pop, popv, popBlock
+ *            (commit/rollback), peek, peekSpans, skipTail, find (offset, 
+ *            window, setTail; random needles and slices of the data also
+ *            through findCompiled, same offset and resulting tail), findAny (overlapping patterns, earliest then
+ *            longest match), searchNext (small pushes between calls, offset
+ *            from the current tail), popUntil (every flag combination,
+ *            multi-char delimiter sets, delimiter past the wrap, dest
+ *            full), popLine, linearize, reset; plain and 
+ *            aligned; plus a directed searchNext case with the needle split
+ *            across pushes and the wrap, and watermark hysteresis (each
+ *            crossing fires once, high from producer calls, low from consumer)
+ *   records: pushRecord, pushRecordStart + pushRecordAppend pieces then
+ *            commit (early commit is a rollback) or rollback, popRecord
+ *            (dest too small leaves the record), peekRecord, skipRecord,
+ *            getRecordCount and getRecordSize after every operation; plus a
+ *            directed case for the varint header at 127/128 and
+ *            16383/16384 with the header, then the payload, across the wrap
+ *   pbuffer: push, pushBlock (commit/rollback), pop, popBlock
+ *            (commit/rollback), peek, find (offset, window, setTail),
+ *            skipHead, skipTail, reset; head/tail counters start just
+ *            below UINT32_MAX so they wrap early in each case
+ *   cbuffer: push, pop, pushN, popN
+ * Data is drawn from a small alphabet (with CR/LF) so finds and lines hit.
+ * 
+ * Results are CSV lines, one per engine and buffer size:
+ *   engine,bufferSz,seed,ops,result
+ * A failure prints the seed and operation number to reproduce, exit code 1.
+ * 
+ * Build/run (from this folder):
+ *   gcc -O2 -DDISABLE_ASSERT -I../../src buffer-fuzz.c ../../src/lq-bBuffer.c ../../src/lq-pBuffer.c ../../src/lq-cBuffer.c -o buffer-fuzz
+ *   ./buffer-fuzz [opsPerCase] [seed]
+ * 
+ * Defaults to 2,000,000 operations per case, seed 1.
+ * 
+ * 32-bit sizes (BBFFR_LARGE) build, adds a 1 MB bbffr case with requests up
+ * to 100,000 chars (1/100 of the ops) and a directed check of counts and
+ * find offsets past 65535 and of the 32-bit BBFFR_NOTFOUND:
+ *   gcc -O2 -DDISABLE_ASSERT -DBBFFR_LARGE -I../../src buffer-fuzz.c ../../src/lq-bBuffer.c ../../src/lq-pBuffer.c ../../src/lq-cBuffer.c -o buffer-fuzz-large
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "lq-bBuffer.h"
+#include "lq-pBuffer.h"
+#include "lq-cBuffer.h"
+
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+#if defined(BBFFR_LARGE)
+    #define OPSZ_MAX 100000                                 // requests past 65535 need the 32-bit sizes
+    #define BUFFER_MAX (1024 * 1024 + 7)
+#else
+    #define OPSZ_MAX 300
+    #define BUFFER_MAX 4096
+#endif
+#define NEEDLE_MAX 300                                      // needles longer than the 255 char compiled shift range
+
+static const char alphabet[] = "abcab\r\nab";
+static const char *patterns[] = { "ab", "abc", "b\r", "\r\nab", "cab\r\n", "c" };     // shared prefixes and suffixes
+#define PATTERN_CNT (sizeof(patterns) / sizeof(patterns[0]))
+
+/* Reference model, the occupied chars in order (front is buffer-tail) */
+static char model[BUFFER_MAX];
+static uint32_t modelLen;
+
+/* Incremental search model: needle start candidates before searchResume are ruled out, consuming past it needs a restart */
+static int64_t searchResume;
+static bool searchRestart;
+
+/* Watermark callbacks seen; wmContext is the side (producer/consumer) making the current call */
+static uint32_t wmFired[3];
+static bbffrSz_t wmOccupied;
+static bbffrWatermark_t wmContext;
+static bool wmWrongContext;
+
+static uint32_t rnd;
+static uint64_t opNum;
+static const char *opName;
+static bool failed;
+
+
+static inline uint32_t xorshift()
+{
+    uint32_t x = rnd;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return rnd = x;
+}
+
+static void modelPush(const char *src, uint32_t cnt)
+{
+    memcpy(model + modelLen, src, cnt);
+    modelLen += cnt;
+}
+
+static void modelPop(uint32_t cnt)
+{
+    memmove(model, model + cnt, modelLen - cnt);
+    modelLen -= cnt;
+    searchResume -= cnt;
+    if (searchResume < 0)
+        searchRestart = true;
+}
+
+static void fillRandom(char *dest, uint32_t cnt)
+{
+    for (uint32_t i = 0; i < cnt; i++)
+        dest[i] = alphabet[xorshift() % (sizeof(alphabet) - 1)];
+}
+
+/* Record the first mismatch only, the sequence stops at the end of the operation */
+static void expect(bool condition, const char *detail, uint32_t got, uint32_t want)
+{
+    if (!condition && !failed)
+    {
+        printf("FAIL: op #%" PRIu64 " %s: %s (got %u, expected %u, modelLen=%u)\n", opNum, opName, detail, got, want, modelLen);
+        failed = true;
+    }
+}
+
+/* Got count must be the model's; data, when given, must match the model front */
+static void expectFront(const char *data, uint32_t gotCnt, uint32_t wantCnt)
+{
+    expect(gotCnt == wantCnt, "count", gotCnt, wantCnt);
+    if (data != NULL && gotCnt == wantCnt)
+        expect(memcmp(data, model, gotCnt) == 0, "data", 0, 0);
+}
+
+
+/* Model of bbffr_find() search bounds, offset from tail or BBFFR_NOTFOUND */
+static bbffrSz_t modelFind(const char *needle, int32_t searchOffset, uint32_t searchWindowSz)
+{
+    uint32_t needleLen = strlen(needle);
+    uint32_t start = 0;
+    if (searchOffset > 0)
+        start = MIN((uint32_t)searchOffset, modelLen);
+    else if (searchOffset < 0)
+        start = ((uint32_t)-searchOffset < modelLen) ? modelLen + searchOffset : 0;
+    uint32_t end = (searchWindowSz == 0) ? modelLen : start + MIN(modelLen - start, searchWindowSz);
+
+    for (uint32_t offset = start; offset + needleLen <= end; offset++)
+    {
+        if (memcmp(model + offset, needle, needleLen) == 0)
+            return offset;
+    }
+    return BBFFR_NOTFOUND;
+}
+
+
+/* Model of bbffr_findAny(), earliest match then longest pattern at that offset */
+static bbffrSz_t modelFindAny(int32_t searchOffset, uint32_t searchWindowSz, uint8_t *patternIndx)
+{
+    bbffrSz_t first = BBFFR_NOTFOUND;
+    uint32_t firstLen = 0;
+
+    for (uint8_t p = 0; p < PATTERN_CNT; p++)
+    {
+        bbffrSz_t offset = modelFind(patterns[p], searchOffset, searchWindowSz);
+        if (offset != BBFFR_NOTFOUND && (offset < first || (offset == first && strlen(patterns[p]) > firstLen)))
+        {
+            first = offset;
+            firstLen = strlen(patterns[p]);
+            *patternIndx = p;
+        }
+    }
+    return first;
+}
+
+
+/* Model of bbffr_popUntil(), returns chars copied; *popCnt chars leave the buffer */
+static uint32_t modelPopUntil(const char *delimSet, uint32_t destSz, uint8_t flags, bbffrUntil_t *outcome, uint32_t *popCnt, uint32_t *delimAt)
+{
+    bool copyDelim = flags & bbffrUntilFlag_includeDelim;
+    uint32_t scanLimit = (destSz < modelLen) ? destSz + !copyDelim : modelLen;     // a delimiter just past a full dest still counts
+    uint32_t i = 0;
+
+    while (i < scanLimit && strchr(delimSet, model[i]) == NULL)
+        i++;
+    *delimAt = i;
+    if (i < scanLimit)
+    {
+        uint32_t copied = MIN(i + copyDelim, destSz);
+        *outcome = bbffrUntil_found;
+        *popCnt = (flags & (bbffrUntilFlag_consumeDelim | bbffrUntilFlag_includeDelim)) ? i + 1 : copied;
+        return copied;
+    }
+    *outcome = (destSz < modelLen) ? bbffrUntil_destFull : bbffrUntil_notFound;
+    *popCnt = (flags & bbffrUntilFlag_requireDelim) ? 0 : MIN(modelLen, destSz);
+    return *popCnt;
+}
+
+
+/* Aligned mode block: within the unaligned limit, ending on a boundary; none reachable grants the producer 0, the consumer the limit */
+static void expectAligned(bbuffer_t *bBuffer, char *blockStart, bbffrSz_t gotSz, bbffrSz_t limitSz, bbffrSz_t alignSz, bool producer)
+{
+    uint32_t startOffset = blockStart - bBuffer->buffer;
+    bool boundaryInReach = ((startOffset + limitSz) / alignSz) > (startOffset / alignSz);
+    expect(gotSz <= limitSz, "block exceeds limit", gotSz, limitSz);
+    if (boundaryInReach)
+        expect((startOffset + gotSz) % alignSz == 0, "block end not aligned", startOffset + gotSz, alignSz);
+    else if (producer)
+        expect(gotSz == 0, "unaligned block granted", gotSz, 0);
+    else
+        expect(gotSz == limitSz, "unaligned block trimmed", gotSz, limitSz);
+}
+
+
+static void fuzzBbuffer(bbffrSz_t bufferSz, bbffrSz_t alignSz, uint64_t opCnt)
+{
+    static char raw[BUFFER_MAX] __attribute__((aligned(64)));
+    static char src[OPSZ_MAX];
+    static char dest[OPSZ_MAX + 1];
+    static const char *needles[] = { "\r\n", "ab", "abc", "b\r\na", "c" };
+    bbuffer_t bBuffer;
+    bbffrMatcher_t matcher;
+    bbffrNeedle_t compiled[sizeof(needles) / sizeof(needles[0])];
+    bbffrSearch_t search;
+    uint8_t searchNeedle = 0;
+    bbffrSz_t capacity = bufferSz - 1;
+    uint64_t wrapMatches = 0;
+    uint64_t wideCounts = 0;                                            // counts/offsets past 65535 (BBFFR_LARGE)
+    uint64_t untilWrapFinds = 0, untilDestFull = 0;
+    uint64_t compiledMatches = 0;
+
+    for (size_t n = 0; n < sizeof(needles) / sizeof(needles[0]); n++)
+        bbffr_compileNeedle(&compiled[n], needles[n]);
+    searchRestart = true;
+
+    if (!bbffr_buildMatcher(&matcher, patterns, PATTERN_CNT))
+    {
+        printf("FAIL: matcher not built\n");
+        failed = true;
+        return;
+    }
+
+    if (alignSz > 0)
+        bbffr_initAligned(&bBuffer, raw, bufferSz, alignSz);
+    else
+        bbffr_init(&bBuffer, raw, bufferSz);
+    modelLen = 0;
+
+    for (opNum = 0; opNum < opCnt && !failed; opNum++)
+    {
+        bbffrSz_t requestSz = xorshift() % (MIN(OPSZ_MAX, bufferSz + 2) + 1);
+        uint32_t vacant = capacity - modelLen;
+        bbffrSz_t gotSz = 0;
+
+        switch (xorshift() % 17)
+        {
+            case 0:
+            case 1:
+                opName = "push";
+                fillRandom(src, requestSz);
+                gotSz = bbffr_push(&bBuffer, src, requestSz);
+                expect(gotSz == MIN(requestSz, vacant), "count", gotSz, MIN(requestSz, vacant));
+                modelPush(src, gotSz);
+                break;
+            case 2:
+            {
+                opName = "pushv";
+                fillRandom(src, requestSz);
+                bbffrSpan_t srcv[3] = { { src, requestSz / 4 }, { src + requestSz / 4, 0 }, { src + requestSz / 4, requestSz - requestSz / 4 } };
+                gotSz = bbffr_pushv(&bBuffer, srcv, 3);
+                expect(gotSz == MIN(requestSz, vacant), "count", gotSz, MIN(requestSz, vacant));
+                modelPush(src, gotSz);
+                break;
+            }
+            case 3:
+            if (xorshift() % 2)
+            {
+                opName = "pushSpans";
+                bbffrSpan_t spans[2];
+                uint8_t spanCnt = bbffr_pushSpans(&bBuffer, spans, requestSz);
+                gotSz = spans[0].len + spans[1].len;
+                expect(gotSz == MIN(requestSz, vacant), "count", gotSz, MIN(requestSz, vacant));
+                expect(spanCnt == (spans[0].len > 0) + (spans[1].len > 0), "span count", spanCnt, (spans[0].len > 0) + (spans[1].len > 0));
+                expect(spans[0].ptr == NULL || spans[0].ptr == bBuffer.head, "span not at head", 0, 0);
+                fillRandom(src, gotSz);
+                memcpy(spans[0].ptr, src, spans[0].len);
+                memcpy(spans[1].ptr, src + spans[0].len, spans[1].len);
+                bbffrSz_t publishSz = (xorshift() % 4 == 0) ? xorshift() % (gotSz + 1) : gotSz;   // publish part, or none
+                bbffr_skipHead(&bBuffer, publishSz);
+                modelPush(src, publishSz);
+                break;
+            }
+            else
+            {
+                opName = "pushBlock";
+                char *copyTo;
+                bool commit = xorshift() % 4 != 0;
+                bbffrSz_t limitSz = MIN(requestSz, MIN(vacant, (uint32_t)(bBuffer.bufferEnd - bBuffer.head)));
+                gotSz = bbffr_pushBlock(&bBuffer, &copyTo, requestSz);
+                expect(gotSz <= MIN(requestSz, vacant), "count exceeds vacant", gotSz, MIN(requestSz, vacant));
+                if (alignSz > 0)
+                    expectAligned(&bBuffer, copyTo, gotSz, limitSz, alignSz, true);
+                fillRandom(copyTo, gotSz);
+                if (commit)
+                    modelPush(copyTo, gotSz);
+                bbffr_pushBlockFinalize(&bBuffer, commit);
+                break;
+            }
+            case 4:
+            case 5:
+                opName = "pop";
+                gotSz = bbffr_pop(&bBuffer, dest, requestSz);
+                expectFront(dest, gotSz, MIN(requestSz, modelLen));
+                modelPop(gotSz);
+                break;
+            case 6:
+            {
+                opName = "popv";
+                bbffrSpan_t destv[2] = { { dest, requestSz / 3 }, { dest + requestSz / 3, requestSz - requestSz / 3 } };
+                gotSz = bbffr_popv(&bBuffer, destv, 2);
+                expectFront(dest, gotSz, MIN(requestSz, modelLen));
+                modelPop(gotSz);
+                break;
+            }
+            case 7:
+            {
+                opName = "popBlock";
+                char *copyFrom;
+                bool commit = xorshift() % 4 != 0;
+                bbffrSz_t limitSz = MIN(requestSz, MIN(modelLen, (uint32_t)(bBuffer.bufferEnd - bBuffer.tail)));
+                gotSz = bbffr_popBlock(&bBuffer, &copyFrom, requestSz);
+                expect(gotSz <= MIN(requestSz, modelLen), "count exceeds occupied", gotSz, MIN(requestSz, modelLen));
+                if (alignSz > 0)
+                    expectAligned(&bBuffer, copyFrom, gotSz, limitSz, alignSz, false);
+                expect(gotSz > 0 || modelLen == 0 || requestSz == 0, "nothing from occupied buffer", gotSz, 1);
+                expectFront(copyFrom, gotSz, gotSz);
+                bbffr_popBlockFinalize(&bBuffer, commit);
+                if (commit)
+                    modelPop(gotSz);
+                break;
+            }
+            case 8:
+                opName = "peek";
+                gotSz = bbffr_peek(&bBuffer, dest, requestSz);
+                expectFront(dest, gotSz, MIN(requestSz, modelLen));
+                break;
+            case 9:
+            {
+                opName = "peekSpans";
+                bbffrSpan_t spans[2];
+                uint8_t spanCnt = bbffr_peekSpans(&bBuffer, spans, requestSz);
+                memcpy(dest, spans[0].ptr, spans[0].len);
+                memcpy(dest + spans[0].len, spans[1].ptr, spans[1].len);
+                expect(spanCnt == (spans[0].len > 0) + (spans[1].len > 0), "span count", spanCnt, (spans[0].len > 0) + (spans[1].len > 0));
+                expectFront(dest, spans[0].len + spans[1].len, MIN(requestSz, modelLen));
+                break;
+            }
+            case 10:
+                opName = "skipTail";
+                bbffr_skipTail(&bBuffer, requestSz);
+                modelPop(MIN(requestSz, modelLen));
+                break;
+            case 11:
+            {
+                opName = "find";
+                static char randomNeedle[NEEDLE_MAX + 1];
+                const char *needle = needles[xorshift() % (sizeof(needles) / sizeof(needles[0]))];
+                bool vsCompiled = xorshift() % 2;                               // random needle, findCompiled must agree with find
+                if (vsCompiled)
+                {
+                    uint32_t needleLen = 1 + xorshift() % 6;
+                    if (modelLen > 0 && xorshift() % 2)                         // slice of the data, a match up to NEEDLE_MAX chars
+                    {
+                        uint32_t sliceAt = xorshift() % modelLen;
+                        needleLen = 1 + xorshift() % MIN(modelLen - sliceAt, NEEDLE_MAX);
+                        memcpy(randomNeedle, model + sliceAt, needleLen);
+                    }
+                    else
+                        fillRandom(randomNeedle, needleLen);
+                    randomNeedle[needleLen] = '\0';
+                    needle = randomNeedle;
+                }
+                int32_t searchOffset = (xorshift() % 2) ? 0 : (int32_t)(xorshift() % (bufferSz + 1)) - (int32_t)(bufferSz / 2);
+                uint32_t searchWindowSz = (xorshift() % 2) ? 0 : xorshift() % (bufferSz + 1);
+                bool setTail = xorshift() % 2;
+                bbffrSz_t want = modelFind(needle, searchOffset, searchWindowSz);
+                if (vsCompiled)                                                 // find inside a transaction, then compiled on the same tail
+                {
+                    bbffrNeedle_t compiledNeedle;
+                    expect(bbffr_compileNeedle(&compiledNeedle, needle), "needle not compiled", 0, 1);
+                    bbffr_startTransaction(&bBuffer);
+                    gotSz = bbffr_find(&bBuffer, needle, searchOffset, searchWindowSz, setTail);
+                    char *findTail = bBuffer.tail;
+                    bbffr_rollbackTransaction(&bBuffer);
+                    bbffrSz_t compiledSz = bbffr_findCompiled(&bBuffer, &compiledNeedle, searchOffset, searchWindowSz, setTail);
+                    expect(compiledSz == gotSz, "compiled offset", compiledSz, gotSz);
+                    expect(bBuffer.tail == findTail, "compiled tail", bBuffer.tail - bBuffer.buffer, findTail - bBuffer.buffer);
+                    if (compiledSz != BBFFR_NOTFOUND)
+                        compiledMatches++;
+                }
+                else
+                    gotSz = bbffr_find(&bBuffer, needle, searchOffset, searchWindowSz, setTail);
+                expect(gotSz == want, "offset", gotSz, want);
+                if (setTail && want != BBFFR_NOTFOUND)
+                    modelPop(want);
+                break;
+            }
+            case 12:
+            {
+                opName = "findAny";
+                int32_t searchOffset = (xorshift() % 2) ? 0 : (int32_t)(xorshift() % (bufferSz + 1)) - (int32_t)(bufferSz / 2);
+                uint32_t searchWindowSz = (xorshift() % 2) ? 0 : xorshift() % (bufferSz + 1);
+                bool setTail = xorshift() % 2;
+                uint8_t wantIndx = UINT8_MAX, gotIndx = UINT8_MAX;
+                bbffrSz_t want = modelFindAny(searchOffset, searchWindowSz, &wantIndx);
+                uint32_t matchStart = (bBuffer.tail - bBuffer.buffer) + want;
+                if (want != BBFFR_NOTFOUND && matchStart < bufferSz && matchStart + strlen(patterns[wantIndx]) > bufferSz)
+                    wrapMatches++;
+                gotSz = bbffr_findAny(&bBuffer, &matcher, searchOffset, searchWindowSz, setTail, &gotIndx);
+                expect(gotSz == want, "offset", gotSz, want);
+                expect(gotIndx == wantIndx, "pattern", gotIndx, wantIndx);
+                if (setTail && want != BBFFR_NOTFOUND)
+                    modelPop(want);
+                break;
+            }
+            case 13:
+            {
+                opName = "searchNext";
+                if (searchRestart || xorshift() % 64 == 0)
+                {
+                    searchNeedle = xorshift() % (sizeof(needles) / sizeof(needles[0]));
+                    bbffr_searchInit(&bBuffer, &search, &compiled[searchNeedle]);
+                    searchResume = 0;
+                    searchRestart = false;
+                }
+                uint32_t needleLen = strlen(needles[searchNeedle]);
+                bbffrSz_t trickleSz = xorshift() % 4;                           // response trickles in
+                fillRandom(src, trickleSz);
+                bbffrSz_t pushSz = bbffr_push(&bBuffer, src, trickleSz);
+                expect(pushSz == MIN(trickleSz, vacant), "push count", pushSz, MIN(trickleSz, vacant));
+                modelPush(src, pushSz);
+
+                bool setTail = xorshift() % 4 == 0;
+                bbffrSz_t want = modelFind(needles[searchNeedle], 0, 0);
+                gotSz = bbffr_searchNext(&bBuffer, &search, setTail);
+                expect(gotSz == want, "offset", gotSz, want);
+                if (want != BBFFR_NOTFOUND)
+                {
+                    searchResume = want;
+                    if (setTail)
+                        modelPop(want);
+                }
+                else if (modelLen >= needleLen && searchResume < modelLen - needleLen + 1)
+                    searchResume = modelLen - needleLen + 1;
+                break;
+            }
+            case 14:
+            {
+                opName = "linearize";
+                searchRestart = true;
+                char *linear = bbffr_linearize(&bBuffer);
+                expect(linear == bBuffer.buffer && bBuffer.tail == bBuffer.buffer, "not at buffer start", 0, 0);
+                expect(strlen(linear) == modelLen, "c-string length", strlen(linear), modelLen);
+                expectFront(linear, modelLen, modelLen);
+                break;
+            }
+            case 15:
+            {
+                opName = "popUntil";
+                static const char *delimSets[] = { "\n", "\r\n", "c", "cb", "\nc\r" };
+                const char *delimSet = delimSets[xorshift() % (sizeof(delimSets) / sizeof(delimSets[0]))];
+                bbffrSz_t destSz = xorshift() % (MIN(OPSZ_MAX, bufferSz + 2) + 1);
+                uint8_t flags = xorshift() % 8;                                 // every combination of the three flags
+                bbffrUntil_t wantOutcome, gotOutcome = (bbffrUntil_t)-1;
+                uint32_t popCnt, delimAt;
+                uint32_t tailOffset = bBuffer.tail - bBuffer.buffer;
+                uint32_t want = modelPopUntil(delimSet, destSz, flags, &wantOutcome, &popCnt, &delimAt);
+
+                gotSz = bbffr_popUntil(&bBuffer, delimSet, dest, destSz, flags, &gotOutcome);
+                expectFront(dest, gotSz, want);
+                expect(gotOutcome == wantOutcome, "outcome", gotOutcome, wantOutcome);
+                if (wantOutcome == bbffrUntil_found && tailOffset + delimAt >= bufferSz)
+                    untilWrapFinds++;                                           // delimiter past the wrap, after a full right side
+                if (wantOutcome == bbffrUntil_destFull)
+                    untilDestFull++;
+                modelPop(popCnt);
+                break;
+            }
+            default:
+            {
+                opName = "popLine";
+                bbffrSz_t destSz = 1 + xorshift() % sizeof(dest);
+                char *lf = memchr(model, '\n', modelLen);
+                uint32_t rawLen = (lf != NULL) ? lf - model : 0;
+                bool fits = (lf != NULL && rawLen <= destSz - 1u);
+                uint32_t lineLen = (fits && rawLen > 0 && model[rawLen - 1] == '\r') ? rawLen - 1 : rawLen;
+
+                gotSz = bbffr_popLine(&bBuffer, dest, destSz);
+                if (!fits)
+                    expect(gotSz == BBFFR_NOTFOUND, "expected NOTFOUND", gotSz, BBFFR_NOTFOUND);
+                else
+                {
+                    expectFront(dest, gotSz, lineLen);
+                    expect(dest[lineLen] == '\0', "not NUL terminated", 0, 0);
+                    modelPop(rawLen + 1);
+                }
+                break;
+            }
+        }
+        if (gotSz != BBFFR_NOTFOUND && gotSz > 0xFFFF)
+            wideCounts++;
+        if (xorshift() % 5000 == 0)
+        {
+            opName = "reset";
+            bbffr_reset(&bBuffer);
+            modelLen = 0;
+            searchRestart = true;
+        }
+
+        expect(bbffr_getOccupied(&bBuffer) == modelLen, "occupied", bbffr_getOccupied(&bBuffer), modelLen);
+        expect(bbffr_getVacant(&bBuffer) == capacity - modelLen, "vacant", bbffr_getVacant(&bBuffer), capacity - modelLen);
+    }
+    opName = "coverage";
+    expect(opCnt < 100000 || bufferSz < 17 || bufferSz > 257 || wrapMatches > 0, "no findAny match spanned the wrap", 0, 1);
+    expect(opCnt < 1000 || bufferSz <= 0xFFFF || wideCounts > 0, "no count or offset past 65535", 0, 1);
+    expect(opCnt < 100000 || bufferSz < 17 || bufferSz > 257 || untilWrapFinds > 0, "no popUntil delimiter past the wrap", 0, 1);
+    expect(opCnt < 100000 || bufferSz > 257 || untilDestFull > 0, "no popUntil filled dest", 0, 1);
+    expect(opCnt < 100000 || bufferSz < 17 || compiledMatches > 0, "no findCompiled match", 0, 1);
+}
+
+
+/* Record model, lengths of the records in the buffer (a ring, oldest at recordFirst); payloads are in model */
+static bbffrSz_t recordLens[4096];
+static uint32_t recordFirst, recordCnt;
+
+static uint32_t modelHeaderSz(uint32_t recordSz)
+{
+    uint32_t headerSz = 1;
+    while (recordSz >= 0x80)
+    {
+        recordSz >>= 7;
+        headerSz++;
+    }
+    return headerSz;
+}
+
+/* The next record, payload at the model front, must be what the buffer reports */
+static void expectRecord(bbuffer_t *bBuffer)
+{
+    bbffrSz_t wantSz = (recordCnt > 0) ? recordLens[recordFirst] : 0;
+    expect(bbffr_getRecordCount(bBuffer) == recordCnt, "record count", bbffr_getRecordCount(bBuffer), recordCnt);
+    expect(bbffr_getRecordSize(bBuffer) == wantSz, "record size", bbffr_getRecordSize(bBuffer), wantSz);
+}
+
+static void modelPopRecord()
+{
+    uint32_t recordSz = recordLens[recordFirst];
+    modelPop(recordSz);
+    recordFirst = (recordFirst + 1) % 4096;
+    recordCnt--;
+}
+
+
+static void fuzzRecords(bbffrSz_t bufferSz, uint64_t opCnt)
+{
+    static char raw[4096];
+    static char src[OPSZ_MAX];
+    static char dest[OPSZ_MAX];
+    bbuffer_t bBuffer;
+    uint32_t capacity = bufferSz - 1;
+    uint32_t occupied = 0;                                                      // headers + payloads
+    uint64_t payloadWraps = 0, headerWraps = 0;
+
+    bbffr_init(&bBuffer, raw, bufferSz);
+    modelLen = 0;
+    recordFirst = recordCnt = 0;
+
+    for (opNum = 0; opNum < opCnt && !failed; opNum++)
+    {
+        bbffrSz_t recordSz = xorshift() % (MIN(OPSZ_MAX, bufferSz + 2) + 1);
+        uint32_t recordBytes = modelHeaderSz(recordSz) + recordSz;
+        bool fits = recordSz > 0 && recordBytes <= capacity - occupied;
+        uint32_t tailOffset = bBuffer.tail - bBuffer.buffer;
+
+        switch (xorshift() % 6)
+        {
+            case 0:
+            case 1:
+            {
+                opName = "pushRecord";
+                fillRandom(src, recordSz);
+                bool pushed = bbffr_pushRecord(&bBuffer, src, recordSz);
+                expect(pushed == fits, "pushed", pushed, fits);
+                if (pushed)
+                {
+                    modelPush(src, recordSz);
+                    recordLens[(recordFirst + recordCnt++) % 4096] = recordSz;
+                    occupied += recordBytes;
+                }
+                break;
+            }
+            case 2:
+            {
+                opName = "pushRecordStart";
+                bool started = bbffr_pushRecordStart(&bBuffer, recordSz);
+                expect(started == fits, "started", started, fits);
+                if (!started)
+                    break;
+
+                opName = "pushRecordAppend";
+                bool commit = xorshift() % 4 != 0;
+                bbffrSz_t appendSz = (xorshift() % 8 == 0) ? xorshift() % recordSz : recordSz;     // short record is rolled back
+                fillRandom(src, appendSz);
+                for (bbffrSz_t at = 0; at < appendSz && !failed; )
+                {
+                    bbffrSz_t pieceSz = 1 + xorshift() % (appendSz - at);
+                    bbffrSz_t gotSz = bbffr_pushRecordAppend(&bBuffer, src + at, pieceSz);
+                    expect(gotSz == pieceSz, "append count", gotSz, pieceSz);
+                    at += gotSz;
+                    expectRecord(&bBuffer);                                     // not visible while pending
+                }
+                if (appendSz == recordSz)
+                {
+                    bbffrSz_t overSz = bbffr_pushRecordAppend(&bBuffer, src, 1);
+                    expect(overSz == 0, "append past record", overSz, 0);
+                }
+                opName = "pushRecordFinalize";
+                bbffr_pushBlockFinalize(&bBuffer, commit);
+                if (commit && appendSz == recordSz)
+                {
+                    modelPush(src, recordSz);
+                    recordLens[(recordFirst + recordCnt++) % 4096] = recordSz;
+                    occupied += recordBytes;
+                }
+                break;
+            }
+            case 3:
+            {
+                opName = "popRecord";
+                bbffrSz_t destSz = xorshift() % (sizeof(dest) + 1);
+                bbffrSz_t wantSz = (recordCnt > 0 && recordLens[recordFirst] <= destSz) ? recordLens[recordFirst] : 0;
+                bbffrSz_t gotSz = bbffr_popRecord(&bBuffer, dest, destSz);
+                expectFront(dest, gotSz, wantSz);
+                if (wantSz > 0)
+                {
+                    occupied -= modelHeaderSz(wantSz) + wantSz;
+                    modelPopRecord();
+                }
+                break;
+            }
+            case 4:
+            {
+                opName = "peekRecord";
+                bbffrSpan_t spans[2];
+                bbffrSz_t wantSz = (recordCnt > 0) ? recordLens[recordFirst] : 0;
+                bbffrSz_t gotSz = bbffr_peekRecord(&bBuffer, spans);
+                expect(spans[0].len + spans[1].len == gotSz, "span lengths", spans[0].len + spans[1].len, gotSz);
+                if (gotSz == wantSz && gotSz <= sizeof(dest))
+                {
+                    memcpy(dest, spans[0].ptr, spans[0].len);
+                    memcpy(dest + spans[0].len, spans[1].ptr, spans[1].len);
+                }
+                expectFront(dest, gotSz, wantSz);
+                if (spans[1].len > 0)
+                    payloadWraps++;
+                if (wantSz > 0 && tailOffset + modelHeaderSz(wantSz) > bufferSz)
+                    headerWraps++;
+                break;
+            }
+            default:
+            {
+                opName = "skipRecord";
+                bbffrSz_t wantSz = (recordCnt > 0) ? recordLens[recordFirst] : 0;
+                bbffrSz_t gotSz = bbffr_skipRecord(&bBuffer);
+                expect(gotSz == wantSz, "count", gotSz, wantSz);
+                if (wantSz > 0)
+                {
+                    occupied -= modelHeaderSz(wantSz) + wantSz;
+                    modelPopRecord();
+                }
+                break;
+            }
+        }
+        if (xorshift() % 5000 == 0)
+        {
+            opName = "reset";
+            bbffr_reset(&bBuffer);
+            modelLen = occupied = 0;
+            recordFirst = recordCnt = 0;
+        }
+
+        expectRecord(&bBuffer);
+        expect(bbffr_getOccupied(&bBuffer) == occupied, "occupied", bbffr_getOccupied(&bBuffer), occupied);
+        expect(bbffr_getVacant(&bBuffer) == capacity - occupied, "vacant", bbffr_getVacant(&bBuffer), capacity - occupied);
+    }
+    opName = "coverage";
+    expect(opCnt < 100000 || bufferSz < 64 || payloadWraps > 0, "no record payload spanned the wrap", 0, 1);
+    expect(opCnt < 100000 || bufferSz < 257 || headerWraps > 0, "no 2 char header spanned the wrap", 0, 1);
+}
+
+
+/* Header length steps at 128 and 16384; each size is pushed with its header, then its payload, split by the wrap */
+static uint32_t checkRecordHeaders()
+{
+    static char raw[20000];
+    static char payload[16384];
+    static char dest[16384];
+    static const bbffrSz_t recordSizes[] = { 127, 128, 16383, 16384 };
+    bbuffer_t bBuffer;
+    uint32_t checks = 0;
+
+    bbffr_init(&bBuffer, raw, sizeof(raw));
+    fillRandom(payload, sizeof(payload));
+    modelLen = 0;
+    opName = "recordHeader";
+    for (size_t r = 0; r < sizeof(recordSizes) / sizeof(recordSizes[0]); r++)
+    {
+        bbffrSz_t recordSz = recordSizes[r];
+        uint32_t headerSz = modelHeaderSz(recordSz);
+        uint32_t startOffsets[] = { sizeof(raw) - 1, sizeof(raw) - headerSz - 5 };
+
+        for (size_t o = 0; o < sizeof(startOffsets) / sizeof(startOffsets[0]); o++, checks++)
+        {
+            bbffrSpan_t spans[2];
+            opNum = checks;
+            bbffr_reset(&bBuffer);
+            bbffr_skipHead(&bBuffer, startOffsets[o]);
+            bbffr_skipTail(&bBuffer, startOffsets[o]);
+
+            expect(bbffr_pushRecord(&bBuffer, payload, recordSz), "pushed", 0, 1);
+            expect(bbffr_getOccupied(&bBuffer) == headerSz + recordSz, "header + payload", bbffr_getOccupied(&bBuffer), headerSz + recordSz);
+            expect(bbffr_getRecordSize(&bBuffer) == recordSz, "record size", bbffr_getRecordSize(&bBuffer), recordSz);
+            expect(bbffr_peekRecord(&bBuffer, spans) == recordSz, "peek size", spans[0].len + spans[1].len, recordSz);
+            uint32_t payloadOffset = (startOffsets[o] + headerSz) % sizeof(raw);
+            expect(spans[0].len == MIN(recordSz, sizeof(raw) - payloadOffset), "payload split", spans[0].len, MIN(recordSz, sizeof(raw) - payloadOffset));
+            expect(bbffr_popRecord(&bBuffer, dest, sizeof(dest)) == recordSz, "popped", 0, recordSz);
+            expect(memcmp(dest, payload, recordSz) == 0, "data", 0, 0);
+            expect(bbffr_getOccupied(&bBuffer) == 0 && bbffr_getRecordCount(&bBuffer) == 0, "empty after pop", bbffr_getOccupied(&bBuffer), 0);
+        }
+    }
+    return checks;
+}
+
+
+/* Counters restart here (and on reset) so head and tail cross 2^32 within the first few buffers of data */
+#define PBFFR_START_CNTR (UINT32_MAX - 1000)
+
+static void fuzzPbuffer(uint16_t bufferSz, uint64_t opCnt)
+{
+    static char raw[4096];
+    static char src[OPSZ_MAX];
+    static char dest[OPSZ_MAX];
+    static const char *needles[] = { "\r\n", "ab", "abc", "b\r\na", "c" };
+    pbuffer_t pBuffer;
+    uint64_t counterWraps = 0;
+
+    if (!pbffr_init(&pBuffer, raw, bufferSz))
+    {
+        printf("FAIL: pbffr_init rejected %d\n", bufferSz);
+        failed = true;
+        return;
+    }
+    pBuffer.head = pBuffer.tail = PBFFR_START_CNTR;
+    modelLen = 0;
+
+    for (opNum = 0; opNum < opCnt && !failed; opNum++)
+    {
+        uint16_t requestSz = xorshift() % (MIN(OPSZ_MAX, bufferSz + 2) + 1);
+        uint32_t vacant = bufferSz - modelLen;
+        uint32_t headToEdge = bufferSz - (pBuffer.head & pBuffer.mask);
+        uint32_t tailToEdge = bufferSz - (pBuffer.tail & pBuffer.mask);
+        uint32_t headBefore = pBuffer.head;
+        uint16_t gotSz;
+
+        switch (xorshift() % 10)
+        {
+            case 0:
+            case 1:
+                opName = "push";
+                fillRandom(src, requestSz);
+                gotSz = pbffr_push(&pBuffer, src, requestSz);
+                expect(gotSz == MIN(requestSz, vacant), "count", gotSz, MIN(requestSz, vacant));
+                modelPush(src, gotSz);
+                break;
+            case 2:
+            {
+                opName = "pushBlock";
+                char *copyTo;
+                bool commit = xorshift() % 4 != 0;
+                uint32_t want = MIN(requestSz, MIN(vacant, headToEdge));
+                gotSz = pbffr_pushBlock(&pBuffer, &copyTo, requestSz);
+                expect(gotSz == want, "count", gotSz, want);
+                expect(copyTo == raw + (pBuffer.head & pBuffer.mask), "block not at head", 0, 0);
+                fillRandom(copyTo, gotSz);
+                if (commit)
+                    modelPush(copyTo, gotSz);
+                pbffr_pushBlockFinalize(&pBuffer, commit);
+                break;
+            }
+            case 3:
+            case 4:
+                opName = "pop";
+                gotSz = pbffr_pop(&pBuffer, dest, requestSz);
+                expectFront(dest, gotSz, MIN(requestSz, modelLen));
+                modelPop(gotSz);
+                break;
+            case 5:
+            {
+                opName = "popBlock";
+                char *copyFrom;
+                bool commit = xorshift() % 4 != 0;
+                gotSz = pbffr_popBlock(&pBuffer, &copyFrom, requestSz);
+                expectFront(copyFrom, gotSz, MIN(requestSz, MIN(modelLen, tailToEdge)));
+                pbffr_popBlockFinalize(&pBuffer, commit);
+                if (commit)
+                    modelPop(gotSz);
+                break;
+            }
+            case 6:
+                opName = "peek";
+                gotSz = pbffr_peek(&pBuffer, dest, requestSz);
+                expectFront(dest, gotSz, MIN(requestSz, modelLen));
+                break;
+            case 7:
+            {
+                opName = "find";
+                const char *needle = needles[xorshift() % (sizeof(needles) / sizeof(needles[0]))];
+                int32_t searchOffset = (xorshift() % 2) ? 0 : (int32_t)(xorshift() % (bufferSz + 1)) - (int32_t)(bufferSz / 2);
+                uint32_t searchWindowSz = (xorshift() % 2) ? 0 : xorshift() % (bufferSz + 1);
+                bool setTail = xorshift() % 2;
+                uint16_t want = modelFind(needle, searchOffset, searchWindowSz);
+                gotSz = pbffr_find(&pBuffer, needle, searchOffset, searchWindowSz, setTail);
+                expect(gotSz == want, "offset", gotSz, want);
+                if (setTail && want != PBFFR_NOTFOUND)
+                    modelPop(want);
+                break;
+            }
+            case 8:
+            {
+                opName = "skipHead";
+                uint32_t skipCnt = MIN(requestSz, vacant);
+                for (uint32_t i = 0; i < skipCnt; i++)                                 // publishes whatever the buffer holds
+                    src[i] = raw[(pBuffer.head + i) & pBuffer.mask];
+                pbffr_skipHead(&pBuffer, requestSz);
+                modelPush(src, skipCnt);
+                break;
+            }
+            default:
+                opName = "skipTail";
+                pbffr_skipTail(&pBuffer, requestSz);
+                modelPop(MIN(requestSz, modelLen));
+                break;
+        }
+        if (pBuffer.head < headBefore)
+            counterWraps++;
+        if (xorshift() % 5000 == 0)
+        {
+            opName = "reset";
+            pbffr_reset(&pBuffer);
+            pBuffer.head = pBuffer.tail = PBFFR_START_CNTR;
+            modelLen = 0;
+        }
+
+        expect(pbffr_getOccupied(&pBuffer) == modelLen, "occupied", pbffr_getOccupied(&pBuffer), modelLen);
+        expect(pbffr_getVacant(&pBuffer) == bufferSz - modelLen, "vacant", pbffr_getVacant(&pBuffer), bufferSz - modelLen);
+    }
+    opName = "coverage";
+    expect(opCnt < 100000 || counterWraps > 0, "head counter never wrapped", 0, 1);
+}
+
+
+static void fuzzCbuffer(int bufferSz, uint64_t opCnt)
+{
+    static uint8_t raw[4096];
+    static char src[OPSZ_MAX];
+    static char dest[OPSZ_MAX];
+    cbuffer_t cBuffer = { .buffer = raw, .head = 0, .tail = 0, .maxlen = bufferSz };
+    uint32_t capacity = bufferSz - 1;
+
+    modelLen = 0;
+    for (opNum = 0; opNum < opCnt && !failed; opNum++)
+    {
+        uint32_t requestSz = xorshift() % (MIN(OPSZ_MAX, bufferSz + 2) + 1);
+        uint32_t vacant = capacity - modelLen;
+        uint32_t gotCnt = 0;
+
+        switch (xorshift() % 4)
+        {
+            case 0:
+                opName = "push";
+                fillRandom(src, requestSz);
+                while (gotCnt < requestSz && cbffr_push(&cBuffer, (uint8_t)src[gotCnt]))
+                    gotCnt++;
+                expect(gotCnt == MIN(requestSz, vacant), "count", gotCnt, MIN(requestSz, vacant));
+                modelPush(src, gotCnt);
+                break;
+            case 1:
+                opName = "pop";
+                while (gotCnt < requestSz && cbffr_pop(&cBuffer, (uint8_t *)&dest[gotCnt]))
+                    gotCnt++;
+                expectFront(dest, gotCnt, MIN(requestSz, modelLen));
+                modelPop(gotCnt);
+                break;
+            case 2:
+                opName = "pushN";
+                fillRandom(src, requestSz);
+                gotCnt = cbffr_pushN(&cBuffer, (const uint8_t *)src, requestSz);
+                expect(gotCnt == MIN(requestSz, vacant), "count", gotCnt, MIN(requestSz, vacant));
+                modelPush(src, gotCnt);
+                break;
+            default:
+                opName = "popN";
+                gotCnt = cbffr_popN(&cBuffer, (uint8_t *)dest, requestSz);
+                expectFront(dest, gotCnt, MIN(requestSz, modelLen));
+                modelPop(gotCnt);
+                break;
+        }
+        uint32_t occupied = (cBuffer.head >= cBuffer.tail) ? cBuffer.head - cBuffer.tail : cBuffer.head + bufferSz - cBuffer.tail;
+        expect(occupied == modelLen, "occupied", occupied, modelLen);
+    }
+}
+
+
+/* Needle arrives a char or two at a time across the wrap, consumer skips between calls */
+static uint32_t checkSearchWrap()
+{
+    static const struct { const char *push; bbffrSz_t skip; bbffrSz_t want; } steps[] = {
+        { "ab", 0, BBFFR_NOTFOUND }, { "\r\n", 1, BBFFR_NOTFOUND }, { "OK", 0, BBFFR_NOTFOUND },       // tail 13, "OK" wraps
+        { "\r", 0, BBFFR_NOTFOUND }, { "\n", 0, 1 }, { "", 1, 0 }, { "x", 0, 0 }
+    };
+    char raw[16];
+    bbuffer_t bBuffer;
+    bbffrNeedle_t compiled;
+    bbffrSearch_t search;
+
+    bbffr_init(&bBuffer, raw, sizeof(raw));
+    bbffr_skipHead(&bBuffer, 12);
+    bbffr_skipTail(&bBuffer, 12);
+    bbffr_compileNeedle(&compiled, "\r\nOK\r\n");
+    bbffr_searchInit(&bBuffer, &search, &compiled);
+
+    opName = "searchWrap";
+    for (opNum = 0; opNum < sizeof(steps) / sizeof(steps[0]); opNum++)
+    {
+        bbffr_push(&bBuffer, steps[opNum].push, strlen(steps[opNum].push));
+        bbffr_skipTail(&bBuffer, steps[opNum].skip);
+        bbffrSz_t got = bbffr_searchNext(&bBuffer, &search, false);
+        expect(got == steps[opNum].want, "offset from current tail", got, steps[opNum].want);
+    }
+    return opNum;
+}
+
+
+static void watermarkCB(bbuffer_t *bbffr, bbffrWatermark_t watermark, bbffrSz_t occupied)
+{
+    (void)bbffr;
+    wmFired[watermark]++;
+    wmOccupied = occupied;
+    if (watermark != wmContext)
+        wmWrongContext = true;
+}
+
+
+/* Occupancy swings across both marks, each crossing fires its callback once, from the side that crossed */
+static uint32_t checkWatermarks(uint64_t opCnt)
+{
+    const bbffrSz_t highMark = 48, lowMark = 16;
+    char raw[64];
+    char data[OPSZ_MAX];
+    bbuffer_t bBuffer;
+    bool above = false;
+    uint32_t crossings = 0;
+
+    bbffr_init(&bBuffer, raw, sizeof(raw));
+    bbffr_setWatermarks(&bBuffer, highMark, lowMark, watermarkCB);
+    modelLen = 0;
+    wmWrongContext = false;
+
+    for (opNum = 0; opNum < opCnt && !failed; opNum++)
+    {
+        uint32_t op = xorshift() % 6;
+        uint32_t sz = xorshift() % 24;
+        bbffrSz_t got;
+        char *blockPtr;
+
+        memset(wmFired, 0, sizeof(wmFired));
+        if (op < 3)
+        {
+            wmContext = bbffrWatermark_high;
+            fillRandom(data, sz);
+            if (op == 0)
+            {
+                opName = "wm-push";
+                got = bbffr_push(&bBuffer, data, sz);
+            }
+            else if (op == 1)
+            {
+                opName = "wm-pushBlock";
+                got = bbffr_pushBlock(&bBuffer, &blockPtr, sz);
+                memcpy(blockPtr, data, got);
+                bbffr_pushBlockFinalize(&bBuffer, true);
+            }
+            else
+            {
+                opName = "wm-skipHead";
+                got = MIN(sz, bbffr_getVacant(&bBuffer));
+                bbffr_skipHead(&bBuffer, got);
+            }
+            modelLen += got;                                            // occupancy only, data is not checked here
+            bool crossed = !above && modelLen >= highMark;
+            expect(wmFired[bbffrWatermark_high] == crossed, "high fired", wmFired[bbffrWatermark_high], crossed);
+            expect(wmFired[bbffrWatermark_low] == 0, "low fired by producer", wmFired[bbffrWatermark_low], 0);
+            if (crossed)
+            {
+                expect(wmOccupied == modelLen, "high occupied", wmOccupied, modelLen);
+                above = true;
+                crossings++;
+            }
+        }
+        else
+        {
+            wmContext = bbffrWatermark_low;
+            if (op == 3)
+            {
+                opName = "wm-pop";
+                got = bbffr_pop(&bBuffer, data, sz);
+            }
+            else if (op == 4)
+            {
+                opName = "wm-popBlock";
+                got = bbffr_popBlock(&bBuffer, &blockPtr, sz);
+                bbffr_popBlockFinalize(&bBuffer, true);
+            }
+            else
+            {
+                opName = "wm-skipTail";
+                got = MIN(sz, modelLen);
+                bbffr_skipTail(&bBuffer, sz);
+            }
+            modelLen -= got;
+            bool crossed = above && got > 0 && modelLen <= lowMark;
+            expect(wmFired[bbffrWatermark_low] == crossed, "low fired", wmFired[bbffrWatermark_low], crossed);
+            expect(wmFired[bbffrWatermark_high] == 0, "high fired by consumer", wmFired[bbffrWatermark_high], 0);
+            if (crossed)
+            {
+                expect(wmOccupied == modelLen, "low occupied", wmOccupied, modelLen);
+                above = false;
+                crossings++;
+            }
+        }
+        expect(bbffr_getOccupied(&bBuffer) == modelLen, "occupied", bbffr_getOccupied(&bBuffer), modelLen);
+        expect(!wmWrongContext, "callback context", 0, 0);
+    }
+    expect(crossings > opCnt / 64, "crossings", crossings, (uint32_t)(opCnt / 64));
+    return crossings;
+}
+
+
+#if defined(BBFFR_LARGE)
+/* Counts and offsets past 65535: a 16-bit build would truncate them or read offset 65535 as NOTFOUND */
+static uint32_t checkLargeOffsets()
+{
+    static char raw[BUFFER_MAX];
+    static char data[150000];
+    static char dest[150000];
+    bbuffer_t bBuffer;
+    char *block;
+    uint32_t checks = 0;
+
+    _Static_assert(BBFFR_NOTFOUND == UINT32_MAX, "NOTFOUND is max bbffrSz_t");
+    bbffr_init(&bBuffer, raw, sizeof(raw));
+    modelLen = 0;
+    opName = "largeOffsets";
+
+    memset(data, 'a', sizeof(data));
+    memcpy(data + 65535, "Z!", 2);
+    data[sizeof(data) - 1] = '\n';
+    opNum = checks++;
+    bbffrSz_t gotSz = bbffr_push(&bBuffer, data, sizeof(data));
+    expect(gotSz == sizeof(data), "push count", gotSz, sizeof(data));
+    opNum = checks++;
+    gotSz = bbffr_find(&bBuffer, "Z!", 0, 0, false);
+    expect(gotSz == 65535, "find at 65535", gotSz, 65535);
+    opNum = checks++;
+    expect(bbffr_find(&bBuffer, "Z!", 65536, 0, false) == BBFFR_NOTFOUND, "find past it NOTFOUND", 0, 0);
+    opNum = checks++;
+    expect(bbffr_find(&bBuffer, "Z!", -84465, 0, false) == 65535, "find from head", 0, 65535);     // 150000 - 84465 = 65535
+    opNum = checks++;
+    expect(bbffr_find(&bBuffer, "Z!", 0, 65536, false) == BBFFR_NOTFOUND, "window ends before needle", 0, 0);
+    opNum = checks++;
+    expect(bbffr_find(&bBuffer, "missing", 0, 0, false) == BBFFR_NOTFOUND, "NOTFOUND", 0, 0);
+
+    opNum = checks++;
+    bbffrSz_t lineLen = bbffr_popLine(&bBuffer, dest, sizeof(dest));
+    expect(lineLen == sizeof(data) - 1 && memcmp(dest, data, lineLen) == 0 && dest[lineLen] == '\0', "popLine", lineLen, sizeof(data) - 1);
+    opNum = checks++;
+    expect(bbffr_popLine(&bBuffer, dest, sizeof(dest)) == BBFFR_NOTFOUND, "popLine empty NOTFOUND", 0, 0);
+
+    opNum = checks++;
+    bbffrSz_t blockSz = bbffr_pushBlock(&bBuffer, &block, 100000);
+    expect(blockSz == 100000, "pushBlock count", blockSz, 100000);
+    memcpy(block, data, blockSz);
+    bbffr_pushBlockFinalize(&bBuffer, true);
+    opNum = checks++;
+    blockSz = bbffr_popBlock(&bBuffer, &block, 100000);
+    expect(blockSz == 100000 && memcmp(block, data, blockSz) == 0, "popBlock", blockSz, 100000);
+    bbffr_popBlockFinalize(&bBuffer, true);
+    opNum = checks++;
+    expect(bbffr_getOccupied(&bBuffer) == 0, "empty", bbffr_getOccupied(&bBuffer), 0);
+    return checks;
+}
+#endif
+
+
+int main(int argc, char *argv[])
+{
+    uint64_t opCnt = 2000000;
+    uint32_t seed = 1;
+    uint16_t bufferSizes[] = { 2, 3, 17, 64, 257, 1024, 4096 };
+    uint16_t recordSizes[] = { 17, 64, 257, 1024, 4096 };
+    uint16_t pbffrSizes[] = { 1, 2, 16, 64, 256, 1024, 4096 };                // power of two only
+    struct { uint16_t bufferSz; uint16_t alignSz; } alignedCases[] = { { 64, 4 }, { 256, 32 }, { 4096, 64 } };
+    int rslt = 0;
+
+    if (argc > 1)
+        opCnt = strtoull(argv[1], NULL, 10);
+    if (argc > 2)
+        seed = (uint32_t)strtoul(argv[2], NULL, 10);
+
+    setvbuf(stdout, NULL, _IOLBF, 0);                                   // keep completed lines if a case crashes
+    printf("engine,bufferSz,seed,ops,result\n");
+    failed = false;
+    checkSearchWrap();
+    printf("bbffr-searchWrap,16,0,%" PRIu64 ",%s\n", opNum, failed ? "FAIL" : "PASS");
+    rslt |= failed;
+    rnd = seed * 0x9E3779B9u + 64;
+    if (rnd == 0)
+        rnd = 1;
+    failed = false;
+    checkWatermarks(opCnt);
+    printf("bbffr-watermarks,64,%u,%" PRIu64 ",%s\n", seed, opNum, failed ? "FAIL" : "PASS");
+    rslt |= failed;
+    for (size_t b = 0; b < sizeof(bufferSizes) / sizeof(bufferSizes[0]); b++)
+    {
+        for (int engine = 0; engine < 2; engine++)
+        {
+            rnd = seed * 0x9E3779B9u + bufferSizes[b];                  // xorshift state must be non-zero
+            if (rnd == 0)
+                rnd = 1;
+            failed = false;
+            if (engine == 0)
+                fuzzBbuffer(bufferSizes[b], 0, opCnt);
+            else
+                fuzzCbuffer(bufferSizes[b], opCnt);
+            printf("%s,%d,%u,%" PRIu64 ",%s\n", engine ? "cbffr" : "bbffr", bufferSizes[b], seed, opNum, failed ? "FAIL" : "PASS");
+            rslt |= failed;
+        }
+    }
+    failed = false;
+    opNum = checkRecordHeaders();
+    printf("bbffr-recordHeader,20000,0,%" PRIu64 ",%s\n", opNum, failed ? "FAIL" : "PASS");
+    rslt |= failed;
+    for (size_t r = 0; r < sizeof(recordSizes) / sizeof(recordSizes[0]); r++)
+    {
+        rnd = seed * 0x9E3779B9u + recordSizes[r] + 2;
+        if (rnd == 0)
+            rnd = 1;
+        failed = false;
+        fuzzRecords(recordSizes[r], opCnt);
+        printf("bbffr-records,%d,%u,%" PRIu64 ",%s\n", recordSizes[r], seed, opNum, failed ? "FAIL" : "PASS");
+        rslt |= failed;
+    }
+    for (size_t p = 0; p < sizeof(pbffrSizes) / sizeof(pbffrSizes[0]); p++)
+    {
+        rnd = seed * 0x9E3779B9u + pbffrSizes[p] + 1;
+        if (rnd == 0)
+            rnd = 1;
+        failed = false;
+        fuzzPbuffer(pbffrSizes[p], opCnt);
+        printf("pbffr,%d,%u,%" PRIu64 ",%s\n", pbffrSizes[p], seed, opNum, failed ? "FAIL" : "PASS");
+        rslt |= failed;
+    }
+#if defined(BBFFR_LARGE)
+    failed = false;
+    opNum = checkLargeOffsets();
+    printf("bbffr-largeOffsets,%d,0,%" PRIu64 ",%s\n", BUFFER_MAX, opNum, failed ? "FAIL" : "PASS");
+    rslt |= failed;
+    rnd = seed * 0x9E3779B9u + BUFFER_MAX;
+    if (rnd == 0)
+        rnd = 1;
+    failed = false;
+    fuzzBbuffer(BUFFER_MAX, 0, opCnt / 100);                            // model memmove is per op, fewer ops
+    printf("bbffr-large,%d,%u,%" PRIu64 ",%s\n", BUFFER_MAX, seed, opNum, failed ? "FAIL" : "PASS");
+    rslt |= failed;
+#endif
+    for (size_t a = 0; a < sizeof(alignedCases) / sizeof(alignedCases[0]); a++)
+    {
+        rnd = seed * 0x9E3779B9u + alignedCases[a].alignSz;
+        if (rnd == 0)
+            rnd = 1;
+        failed = false;
+        fuzzBbuffer(alignedCases[a].bufferSz, alignedCases[a].alignSz, opCnt);
+        printf("bbffr-aligned%d,%d,%u,%" PRIu64 ",%s\n", alignedCases[a].alignSz, alignedCases[a].bufferSz, seed, opNum, failed ? "FAIL" : "PASS");
+        rslt |= failed;
+    }
+    return rslt;
+}
@@ -0,0 +1,149 @@
+/******************************************************************************
+ *  \file cbffr-bench.c
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2022 LooUQ Incorporated.
+ *  www.loouq.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ * Linux host cycle-count benchmark for cbuffer: the original single char
+ * engine ('%' index wrap, reproduced here), the compare-and-reset single char
+ * engine, and bulk cbffr_pushN/cbffr_popN. Results are CSV lines:
+ *   engine,op,bufferSz,opSz,cyclesPerChar
+ * 
+ * Cycles are the x86 TSC (reference cycles) where available, else nanoseconds.
+ * On the host '%' is a hardware divide, on Cortex-M0+ it is a library call 
+ * (__aeabi_idivmod, ~40-100 cycles), so the host understates the M0+ gain.
+ * 
+ * Build/run (from this folder):
+ *   gcc -O2 -I../../src cbffr-bench.c ../../src/lq-cBuffer.c -o cbffr-bench
+ *   ./cbffr-bench [megabytesPerCase]
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "lq-cBuffer.h"
+
+static uint64_t volume = 16ULL << 20;
+static volatile uint32_t sink;                                          // defeat dead-store elimination of copied data
+static uint8_t src[256];
+static uint8_t dest[256];
+
+
+static uint64_t nowCycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+static void report(const char *engine, const char *op, int bufferSz, int opSz, uint64_t chars, uint64_t cycles)
+{
+    printf("%s,%s,%d,%d,%.2f\n", engine, op, bufferSz, opSz, (double)cycles / chars);
+}
+
+
+/* Original engine, index wrap by '%' */
+__attribute__((noinline)) static uint8_t modPush(cbuffer_t *bufStruct, uint8_t data)
+{
+    int next = (bufStruct->head + 1) % bufStruct->maxlen;
+    if (next == bufStruct->tail)
+        return 0;
+    bufStruct->buffer[bufStruct->head] = data;
+    bufStruct->head = next;
+    return 1;
+}
+
+__attribute__((noinline)) static uint8_t modPop(cbuffer_t *bufStruct, uint8_t *data)
+{
+    if (bufStruct->head == bufStruct->tail)
+        return 0;
+    int next = (bufStruct->tail + 1) % bufStruct->maxlen;
+    *data = bufStruct->buffer[bufStruct->tail];
+    bufStruct->tail = next;
+    return 1;
+}
+
+
+#define BENCH_CHARS(NAME, PUSH, POP)                                            \
+    do {                                                                        \
+        uint64_t moved = 0;                                                     \
+        uint64_t start = nowCycles();                                           \
+        while (moved < volume)                                                  \
+        {                                                                       \
+            for (int i = 0; i < opSz; i++)                                      \
+                PUSH(&cBuffer, src[i]);                                         \
+            for (int i = 0; i < opSz; i++)                                      \
+                moved += POP(&cBuffer, &dest[i]);                               \
+            sink += dest[0];                                                    \
+        }                                                                       \
+        report(NAME, "push+pop", bufferSz, opSz, moved, nowCycles() - start);   \
+    } while (0)
+
+
+int main(int argc, char *argv[])
+{
+    static uint8_t raw[256];
+    cbuffer_t cBuffer;
+    int bufferSizes[] = { 64, 100, 256 };
+    int opSizes[] = { 1, 16, 48 };
+
+    if (argc > 1)
+        volume = strtoull(argv[1], NULL, 10) << 20;
+    for (size_t i = 0; i < sizeof(src); i++)
+        src[i] = 'A' + (i % 26);
+
+    printf("engine,op,bufferSz,opSz,cyclesPerChar\n");
+    for (size_t b = 0; b < sizeof(bufferSizes) / sizeof(bufferSizes[0]); b++)
+    {
+        int bufferSz = bufferSizes[b];
+        for (size_t o = 0; o < sizeof(opSizes) / sizeof(opSizes[0]); o++)
+        {
+            int opSz = opSizes[o];
+            cBuffer = (cbuffer_t){ .buffer = raw, .head = 0, .tail = 0, .maxlen = bufferSz };
+            BENCH_CHARS("cbffr-mod", modPush, modPop);
+            cBuffer = (cbuffer_t){ .buffer = raw, .head = 0, .tail = 0, .maxlen = bufferSz };
+            BENCH_CHARS("cbffr", cbffr_push, cbffr_pop);
+
+            cBuffer = (cbuffer_t){ .buffer = raw, .head = 0, .tail = 0, .maxlen = bufferSz };
+            uint64_t moved = 0;
+            uint64_t start = nowCycles();
+            while (moved < volume)
+            {
+                cbffr_pushN(&cBuffer, src, opSz);
+                moved += cbffr_popN(&cBuffer, dest, opSz);
+                sink += dest[0];
+            }
+            report("cbffr-bulk", "pushN+popN", bufferSz, opSz, moved, nowCycles() - start);
+        }
+    }
+    return 0;
+}
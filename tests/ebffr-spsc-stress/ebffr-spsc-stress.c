@@ -0,0 +1,210 @@
+/******************************************************************************
+ *  \file ebffr-spsc-stress.c
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2022 LooUQ Incorporated.
+ *  www.loouq.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ * Linux host stress test for ebuffer single-producer/single-consumer operation.
+ * 
+ * A producer thread enqueues event records (pin, code, timestamp, sequence),
+ * mixing single enqueue and batch enqueueN, while a consumer thread mixes
+ * dequeue, dequeueN and peek and verifies every record is received exactly
+ * once, in order and untorn (all fields derive from the sequence number).
+ * 
+ * Build/run (from this folder):
+ *   gcc -O2 -pthread -I../../src ebffr-spsc-stress.c ../../src/lq-eBuffer.c -o ebffr-spsc-stress
+ *   ./ebffr-spsc-stress [totalEvents] [elemCnt]
+ * 
+ * Defaults to 200,000,000 events through a 17 slot buffer. Exit code 0 on success.
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "lq-eBuffer.h"
+
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+#define BATCH_MAX 40
+
+typedef struct pinEvent_tag
+{
+    uint8_t pin;
+    uint8_t code;
+    uint16_t check;                                                     // folded sequence, detects mixed halves
+    uint32_t timestamp;
+    uint64_t sequence;
+} pinEvent_t;
+
+EBFFR_TYPED(pinEvents, pinEvent_t)
+
+static ebuffer_t eventQueue;
+static uint64_t totalEvents = 200000000ULL;
+static volatile int failed = 0;
+
+
+static inline uint32_t xorshift(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+
+static void makeEvent(pinEvent_t *event, uint64_t sequence)
+{
+    uint64_t x = sequence * 0x9E3779B97F4A7C15ULL;
+    event->pin = (uint8_t)(x >> 56);
+    event->code = (uint8_t)(x >> 48);
+    event->check = (uint16_t)(sequence ^ (sequence >> 16));
+    event->timestamp = (uint32_t)(x >> 8);
+    event->sequence = sequence;
+}
+
+
+static bool checkEvent(const pinEvent_t *event, uint64_t sequence)
+{
+    pinEvent_t expected;
+    makeEvent(&expected, sequence);
+    return memcmp(event, &expected, sizeof(pinEvent_t)) == 0;
+}
+
+
+static void *producer(void *arg)
+{
+    (void)arg;
+    uint32_t rnd = 0x1234567;
+    uint64_t sent = 0;
+    pinEvent_t batch[BATCH_MAX];
+
+    while (sent < totalEvents && !failed)
+    {
+        uint16_t enqueued;
+        if (xorshift(&rnd) % 2)
+        {
+            pinEvent_t event;
+            makeEvent(&event, sent);
+            enqueued = pinEvents_enqueue(&eventQueue, &event) ? 1 : 0;
+        }
+        else
+        {
+            uint16_t batchCnt = (uint16_t)MIN(1 + xorshift(&rnd) % BATCH_MAX, totalEvents - sent);
+            for (uint16_t i = 0; i < batchCnt; i++)
+                makeEvent(&batch[i], sent + i);
+            enqueued = pinEvents_enqueueN(&eventQueue, batch, batchCnt);
+        }
+        if (enqueued == 0)
+            sched_yield();                                              // full, let consumer run (single core hosts)
+        sent += enqueued;
+    }
+    return NULL;
+}
+
+
+static void *consumer(void *arg)
+{
+    (void)arg;
+    uint32_t rnd = 0x7654321;
+    uint64_t received = 0;
+    uint64_t nextReport = 1ULL << 25;
+    pinEvent_t batch[BATCH_MAX];
+
+    while (received < totalEvents && !failed)
+    {
+        uint16_t gotCnt = 0;
+        uint32_t op = xorshift(&rnd) % 3;
+
+        if (op == 0)                                                    // peek must agree with a following dequeue
+        {
+            pinEvent_t peeked;
+            if (pinEvents_peek(&eventQueue, &peeked))
+            {
+                gotCnt = pinEvents_dequeue(&eventQueue, &batch[0]) ? 1 : 0;
+                if (gotCnt != 1 || memcmp(&peeked, &batch[0], sizeof(pinEvent_t)) != 0)
+                {
+                    printf("FAIL: peek/dequeue mismatch at %" PRIu64 "\n", received);
+                    failed = 1;
+                    break;
+                }
+            }
+        }
+        else if (op == 1)
+            gotCnt = pinEvents_dequeue(&eventQueue, &batch[0]) ? 1 : 0;
+        else
+            gotCnt = pinEvents_dequeueN(&eventQueue, batch, 1 + xorshift(&rnd) % BATCH_MAX);
+
+        for (uint16_t i = 0; i < gotCnt; i++)
+        {
+            if (!checkEvent(&batch[i], received + i))
+            {
+                printf("FAIL: event mismatch at %" PRIu64 " (got sequence %" PRIu64 ")\n", received + i, batch[i].sequence);
+                failed = 1;
+                break;
+            }
+        }
+        received += gotCnt;
+        if (gotCnt == 0)
+            sched_yield();                                              // empty, let producer run (single core hosts)
+
+        if (received >= nextReport)
+        {
+            printf("  %" PRIu64 "M events verified\n", received >> 20);
+            nextReport += 1ULL << 25;
+        }
+    }
+    return NULL;
+}
+
+
+int main(int argc, char *argv[])
+{
+    uint16_t elemCnt = 17;
+
+    if (argc > 1)
+        totalEvents = strtoull(argv[1], NULL, 10);
+    if (argc > 2)
+        elemCnt = (uint16_t)strtoul(argv[2], NULL, 10);
+
+    pinEvent_t *eventStore = malloc(elemCnt * sizeof(pinEvent_t));
+    pinEvents_init(&eventQueue, eventStore, elemCnt);
+    printf("ebffr SPSC stress: %" PRIu64 " events, elemCnt=%d, elemSz=%d\n", totalEvents, elemCnt, eventQueue.elemSz);
+
+    pthread_t producerThread, consumerThread;
+    pthread_create(&consumerThread, NULL, consumer, NULL);
+    pthread_create(&producerThread, NULL, producer, NULL);
+    pthread_join(producerThread, NULL);
+    pthread_join(consumerThread, NULL);
+
+    if (failed || ebffr_getOccupied(&eventQueue) != 0)
+    {
+        printf("FAILED (occupied=%d)\n", ebffr_getOccupied(&eventQueue));
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
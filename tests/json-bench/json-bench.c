@@ -0,0 +1,497 @@
+/******************************************************************************
+ *  \file json-bench.c
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2022 LooUQ Incorporated.
+ *  www.loouq.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ * Linux host check and benchmark for the JSON token index (lq-json) against
+ * lq_getJsonPropValue() scanning the text for each property.
+ * 
+ * The check pass confirms the index returns the same lqJsonPropValue_t as
+ * lq_getJsonPropValue() for every property of a cloud command, plus token
+ * links and the invalid/partial/noTokens results. Path lookups (index and
+ * text), struct binding and the streamed parser (command split at every
+ * chunk size, fed from a wrapping bbuffer) are checked against the same
+ * command. The benchmark then reads the command's properties each way to
+ * show the cost of indexing; the index is not a speedup for flat lookups,
+ * scanning stays cheaper up to all 12 properties. Results are CSV lines:
+ *   method,props,docLen,nsPerDoc
+ * 
+ * Build/run (from this folder):
+ *   gcc -O2 -DDISABLE_ASSERT -Wno-unknown-pragmas -I../../src json-bench.c ../../src/lq-json.c ../../src/lq-collections.c ../../src/lq-bBuffer.c -o json-bench
+ *   ./json-bench [iterations]
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "lq-collections.h"
+#include "lq-json.h"
+#include "lq-bBuffer.h"
+
+static const char *command = 
+    "{\"deviceId\":\"864508030074113\",\"cmdId\":\"c0a8011e-7f3d\",\"seq\":1042,\"action\":\"setConfig\","
+    "\"issued\":\"2022-11-04T17:21:08Z\",\"ttl\":300,\"ack\":true,\"priority\":2.5,\"owner\":null,"
+    "\"params\":{\"interval\":30,\"mode\":\"eco\",\"thresholds\":[10,20,45.5],\"notify\":{\"sms\":false,\"email\":\"ops@example.com\"}},"
+    "\"tags\":[\"field\",\"v2\",{\"site\":\"north\"}],"
+    "\"signature\":\"MEUCIQDxvN6y0b7m4lJ2d8Kx9cK3bYvP1s0mV2rT3Yw5HkQ1aQIgW8r7nQ4f2pL6uZ9xS3dE1cV0bN5mK8jH2gF4tR6yU7o=\"}";
+
+static const char *props[] = { "deviceId", "cmdId", "seq", "action", "issued", "ttl", "ack", "priority", "owner", "params", "tags", "signature" };
+#define PROP_CNT (sizeof(props) / sizeof(props[0]))
+
+static volatile uint32_t sink;
+static int failures = 0;
+
+
+static double nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void check(int condition, const char *what)
+{
+    if (!condition)
+    {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+
+static void checkIndex()
+{
+    lqJsonToken_t tokens[64];
+    lqJsonIndex_t index;
+
+    check(lq_jsonIndex(&index, command, strlen(command), tokens, 64) == lqJsonResult_ok, "command indexes");
+    for (size_t i = 0; i < PROP_CNT; i++)
+    {
+        lqJsonPropValue_t scanned = lq_getJsonPropValue(command, props[i]);
+        lqJsonPropValue_t indexed = lq_jsonGetPropValue(&index, LQJSON_ROOT, props[i]);
+        if (scanned.value != indexed.value || scanned.len != indexed.len || scanned.type != indexed.type)
+        {
+            printf("FAIL: prop %s: scan=(%d,%d) index=(%d,%d)\n", props[i], scanned.len, scanned.type, indexed.len, indexed.type);
+            failures++;
+        }
+    }
+    check(lq_jsonGetPropValue(&index, LQJSON_ROOT, "missing").type == lqcJsonPropType_notFound, "missing prop not found");
+    check(lq_jsonGetPropValue(&index, LQJSON_ROOT, "interval").type == lqcJsonPropType_notFound, "nested prop not at root");
+
+    uint16_t params = lq_jsonFindProp(&index, LQJSON_ROOT, "params");
+    uint16_t notify = lq_jsonFindProp(&index, params, "notify");
+    lqJsonPropValue_t email = lq_jsonGetPropValue(&index, notify, "email");
+    check(email.type == lqcJsonPropType_text && email.len == 15 && memcmp(email.value, "ops@example.com", 15) == 0, "nested prop");
+    check(tokens[params].size == 4 && tokens[LQJSON_ROOT].size == PROP_CNT, "container sizes");
+
+    uint16_t thresholds = lq_jsonFindProp(&index, params, "thresholds");
+    uint16_t elem = thresholds + 1;
+    const char *expected[] = { "10", "20", "45.5" };
+    for (int i = 0; i < 3; i++, elem = tokens[elem].next)
+        check(elem != LQJSON_NONE && tokens[elem].len == strlen(expected[i]) && memcmp(command + tokens[elem].start, expected[i], tokens[elem].len) == 0, "array element links");
+    check(elem == LQJSON_NONE, "array ends");
+
+    const char *invalid[] = { "{\"a\" 1}", "{\"a\":1,}", "[1 2]", "{\"a\":tru}", "{\"a\":1}}", "{1:2}", "[1,]", "{\"a\":[1}",
+                              "{\"a\":-}", "{\"a\":1-2}", "{\"a\":1e}", "{\"a\":--.}", "{\"a\":01}", "{\"a\":1.}", "{\"a\":.5}", "{\"a\":1e+}" };
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+    {
+        if (lq_jsonIndex(&index, invalid[i], strlen(invalid[i]), tokens, 64) != lqJsonResult_invalid)
+        {
+            printf("FAIL: accepted invalid %s\n", invalid[i]);
+            failures++;
+        }
+    }
+    const char *partial[] = { "", "{\"a\":1", "{\"a\":\"xy", "[true, fa", "{\"a\"", "[-", "[1.", "[1e-" };
+    for (size_t i = 0; i < sizeof(partial) / sizeof(partial[0]); i++)
+    {
+        if (lq_jsonIndex(&index, partial[i], strlen(partial[i]), tokens, 64) != lqJsonResult_partial)
+        {
+            printf("FAIL: partial not reported for %s\n", partial[i]);
+            failures++;
+        }
+    }
+    check(lq_jsonIndex(&index, command, strlen(command), tokens, 8) == lqJsonResult_noTokens, "noTokens reported");
+    check(lq_jsonIndex(&index, " [ ] ", 5, tokens, 64) == lqJsonResult_ok && tokens[0].size == 0 && tokens[0].len == 3, "empty array");
+    check(lq_jsonIndex(&index, "[0,-0,10,-1.25,0.5e3,2E+10,1e-2]", 32, tokens, 64) == lqJsonResult_ok && tokens[0].size == 7 &&
+          tokens[3].type == lqcJsonPropType_int && tokens[4].type == lqcJsonPropType_float && tokens[7].len == 4, "number grammar");
+}
+
+
+static void checkPaths()
+{
+    lqJsonToken_t tokens[64];
+    lqJsonIndex_t index;
+    static const struct { const char *path; const char *value; lqJsonPropType_t type; } paths[] = {
+        { "params.notify.email", "ops@example.com", lqcJsonPropType_text },
+        { "tags[2].site", "north", lqcJsonPropType_text },
+        { "params.thresholds[2]", "45.5", lqcJsonPropType_float },
+        { "params.thresholds", "[10,20,45.5]", lqcJsonPropType_array },
+        { "params.notify", "{\"sms\":false,\"email\":\"ops@example.com\"}", lqcJsonPropType_object },
+        { "params.notify.sms", "false", lqcJsonPropType_bool },
+        { "tags[0]", "field", lqcJsonPropType_text },
+        { "owner", "null", lqcJsonPropType_null },
+        { "seq", "1042", lqcJsonPropType_int },
+        { "params.notify.phone", NULL, lqcJsonPropType_notFound },
+        { "params.thresholds[3]", NULL, lqcJsonPropType_notFound },
+        { "tags.site", NULL, lqcJsonPropType_notFound },                                // tags is an array
+        { "seq[0]", NULL, lqcJsonPropType_notFound },
+        { "interval", NULL, lqcJsonPropType_notFound },                                 // only nested
+        { "setConfig", NULL, lqcJsonPropType_notFound },                                // only a string value
+        { "params.[x]", NULL, lqcJsonPropType_notFound },                               // malformed
+    };
+
+    check(lq_jsonIndex(&index, command, strlen(command), tokens, 64) == lqJsonResult_ok, "command indexes");
+    for (size_t i = 0; i < sizeof(paths) / sizeof(paths[0]); i++)
+    {
+        lqJsonPropValue_t indexed = lq_jsonGetPathValue(&index, LQJSON_ROOT, paths[i].path);
+        lqJsonPropValue_t scanned = lq_jsonScanPathValue(command, strlen(command), paths[i].path);
+        int expected = (indexed.type == paths[i].type) && 
+                       (paths[i].value == NULL || (indexed.len == strlen(paths[i].value) && memcmp(indexed.value, paths[i].value, indexed.len) == 0));
+        if (!expected || scanned.value != indexed.value || scanned.len != indexed.len || scanned.type != indexed.type)
+        {
+            printf("FAIL: path %s: index=(%d,%d) scan=(%d,%d)\n", paths[i].path, indexed.len, indexed.type, scanned.len, scanned.type);
+            failures++;
+        }
+    }
+
+    const char *nested = " [ {\"id\":1,\"s\":\"}]\\\"{\"}, {\"id\" : [ [], {\"id\":7} ] } ] ";
+    check(lq_jsonIndex(&index, nested, strlen(nested), tokens, 64) == lqJsonResult_ok, "nested indexes");
+    lqJsonPropValue_t id = lq_jsonScanPathValue(nested, strlen(nested), "[1].id[1].id");
+    check(id.type == lqcJsonPropType_int && id.len == 1 && *id.value == '7', "scan skips brackets in strings");
+    check(lq_jsonGetPathValue(&index, LQJSON_ROOT, "[1].id[1].id").value == id.value, "index path from root array");
+    check(lq_jsonFindPath(&index, lq_jsonGetElement(&index, LQJSON_ROOT, 1), "id[0]") == lq_jsonFindPath(&index, LQJSON_ROOT, "[1].id[0]"), "relative path");
+    check(lq_jsonScanPathValue(nested, 20, "[1].id").type == lqcJsonPropType_notFound, "truncated document");
+}
+
+
+typedef struct command_tag
+{
+    char deviceId[16];
+    uint16_t seq;
+    char action[16];
+    uint32_t ttl;
+    bool ack;
+    double priority;
+    int8_t owner;
+    char signature[24];
+    float interval;
+    int32_t notPresent;
+} command_t;
+
+static const lqJsonBinding_t commandBindings[] = {
+    LQJSON_BIND(command_t, deviceId, "deviceId", lqJsonBindType_text),
+    LQJSON_BIND(command_t, seq, "seq", lqJsonBindType_uint),
+    LQJSON_BIND(command_t, action, "action", lqJsonBindType_text),
+    LQJSON_BIND(command_t, ttl, "ttl", lqJsonBindType_uint),
+    LQJSON_BIND(command_t, ack, "ack", lqJsonBindType_bool),
+    LQJSON_BIND(command_t, priority, "priority", lqJsonBindType_float),
+    LQJSON_BIND(command_t, owner, "owner", lqJsonBindType_int),                        // null: mismatch
+    LQJSON_BIND(command_t, signature, "signature", lqJsonBindType_text),               // truncated: mismatch
+    LQJSON_BIND(command_t, interval, "interval", lqJsonBindType_float),                // nested: not present
+    LQJSON_BIND(command_t, notPresent, "notPresent", lqJsonBindType_int)
+};
+#define COMMAND_BINDING_CNT (sizeof(commandBindings) / sizeof(commandBindings[0]))
+
+
+typedef struct ranges_tag
+{
+    int8_t i8;
+    uint8_t u8;
+    int16_t i16;
+    int64_t i64;
+    uint64_t u64;
+    char text[8];
+    float f;
+} ranges_t;
+
+static const lqJsonBinding_t rangeBindings[] = {
+    LQJSON_BIND(ranges_t, i8, "i8", lqJsonBindType_int),
+    LQJSON_BIND(ranges_t, u8, "u8", lqJsonBindType_uint),
+    LQJSON_BIND(ranges_t, i16, "i16", lqJsonBindType_int),
+    LQJSON_BIND(ranges_t, i64, "i64", lqJsonBindType_int),
+    LQJSON_BIND(ranges_t, u64, "u64", lqJsonBindType_uint),
+    LQJSON_BIND(ranges_t, text, "text", lqJsonBindType_text),
+    LQJSON_BIND(ranges_t, f, "f", lqJsonBindType_float)
+};
+#define RANGE_BINDING_CNT (sizeof(rangeBindings) / sizeof(rangeBindings[0]))
+
+
+static void checkBind()
+{
+    command_t cmd;
+    lqJsonBindStatus_t status;
+
+    memset(&cmd, 0x5A, sizeof(cmd));
+    check(lq_jsonBind(command, strlen(command), commandBindings, COMMAND_BINDING_CNT, &cmd, &status) == lqJsonResult_ok, "command binds");
+    check(status.present == 0xFF && status.mismatch == 0xC0, "command present/mismatch bits");
+    check(strcmp(cmd.deviceId, "864508030074113") == 0 && strcmp(cmd.action, "setConfig") == 0, "text fields");
+    check(cmd.seq == 1042 && cmd.ttl == 300 && cmd.ack && cmd.priority == 2.5, "number and bool fields");
+    check(cmd.owner == 0x5A && cmd.interval != 30, "mismatched and absent fields unchanged");
+    check(strlen(cmd.signature) == sizeof(cmd.signature) - 1 && memcmp(cmd.signature, "MEUCIQDxvN6y0b7m4lJ2d8K", 23) == 0, "text truncated");
+
+    lqJsonPropValue_t params = lq_jsonScanPathValue(command, strlen(command), "params");
+    check(lq_jsonBind(params.value, params.len, commandBindings, COMMAND_BINDING_CNT, &cmd, &status) == lqJsonResult_ok, "nested object binds");
+    check(status.present == 0x100 && status.mismatch == 0 && cmd.interval == 30.0f, "nested object field");
+
+    ranges_t r;
+    memset(&r, 0, sizeof(r));
+    const char *limits = "{ \"i8\" : -128, \"u8\":255, \"i16\":32767, \"i64\":-9223372036854775808, \"u64\":18446744073709551615, "
+                         "\"text\":\"a\\\"\\u00e9\\n\", \"f\":-1.5e3 }";
+    check(lq_jsonBind(limits, strlen(limits), rangeBindings, RANGE_BINDING_CNT, &r, &status) == lqJsonResult_ok, "limits bind");
+    check(status.present == 0x7F && status.mismatch == 0, "limits fit");
+    check(r.i8 == -128 && r.u8 == 255 && r.i16 == 32767 && r.i64 == INT64_MIN && r.u64 == UINT64_MAX && r.f == -1500.0f, "limit values");
+    check(strcmp(r.text, "a\"\xC3\xA9\n") == 0, "escapes decoded");
+
+    const char *over = "{\"i8\":128,\"u8\":-1,\"i16\":-32769,\"i64\":9223372036854775808,\"u64\":1.5,\"text\":7,\"f\":\"1\"}";
+    check(lq_jsonBind(over, strlen(over), rangeBindings, RANGE_BINDING_CNT, &r, &status) == lqJsonResult_ok, "overflow binds");
+    check(status.present == 0x7F && status.mismatch == 0x7F && r.i8 == -128 && r.u8 == 255, "overflow and type mismatch, fields unchanged");
+
+    const char *badEscapes[] = { "{\"text\":\"ok\\u00zz\"}", "{\"text\":\"ok\\u12\"}", "{\"text\":\"a\\u0000b\"}" };
+    for (size_t i = 0; i < sizeof(badEscapes) / sizeof(badEscapes[0]); i++)
+    {
+        strcpy(r.text, "kept");
+        if (lq_jsonBind(badEscapes[i], strlen(badEscapes[i]), rangeBindings, RANGE_BINDING_CNT, &r, &status) != lqJsonResult_ok ||
+            status.present != 0x20 || status.mismatch != 0x20 || strcmp(r.text, "kept") != 0)
+        {
+            printf("FAIL: bad escape bound %s\n", badEscapes[i]);
+            failures++;
+        }
+    }
+
+    check(lq_jsonBind("{\"u8\":1,\"i8\":2", 14, rangeBindings, RANGE_BINDING_CNT, &r, &status) == lqJsonResult_partial && status.present == 0x02, "partial object");
+    check(lq_jsonBind("{\"u8\" 1}", 8, rangeBindings, RANGE_BINDING_CNT, &r, &status) == lqJsonResult_invalid, "invalid object");
+    check(lq_jsonBind("[1]", 3, rangeBindings, RANGE_BINDING_CNT, &r, &status) == lqJsonResult_invalid, "not an object");
+    check(lq_jsonBind(" {} ", 4, rangeBindings, RANGE_BINDING_CNT, &r, &status) == lqJsonResult_ok && status.present == 0, "empty object");
+}
+
+
+typedef struct eventLog_tag
+{
+    char text[1024];
+    uint16_t len;
+} eventLog_t;
+
+static void logEvent(void *context, const lqJsonEvent_t *event)
+{
+    static const char *marks[] = { "", "{", "}", "[", "]" };
+    eventLog_t *log = (eventLog_t*)context;
+    log->len += snprintf(log->text + log->len, sizeof(log->text) - log->len, "%d%.*s%s%s%.*s%s", event->depth, event->keyLen, 
+                         event->key ? event->key : "", event->key ? "=" : "", marks[event->eventType], event->len, event->value ? event->value : "",
+                         (event->eventType == lqJsonEventType_value) ? "|" : "");
+}
+
+
+static void checkStream()
+{
+    char tokenBuffer[128];
+    lqJsonStream_t stream;
+    eventLog_t whole = {0}, chunked;
+    uint16_t docLen = strlen(command);
+
+    const char *small = " {\"a\":[1,\"x\\\"y\",{\"b\":null}],\"c\":{},\"d\":-2.5e3} ";
+    lq_jsonStreamInit(&stream, tokenBuffer, sizeof(tokenBuffer), logEvent, &whole);
+    check(lq_jsonStreamFeed(&stream, small, strlen(small)) == lqJsonResult_ok, "small document streams");
+    const char *expectedLog = "0{1a=[21|2x\\\"y|2{3b=null|2}1]1c={1}1d=-2.5e3|0}";
+    if (strcmp(whole.text, expectedLog) != 0)
+    {
+        printf("FAIL: event log\n  got:    %s\n  expect: %s\n", whole.text, expectedLog);
+        failures++;
+    }
+
+    command_t bound, expectedCmd;
+    lqJsonBindStatus_t expectedStatus;
+    memset(&expectedCmd, 0, sizeof(expectedCmd));
+    lq_jsonBind(command, docLen, commandBindings, COMMAND_BINDING_CNT, &expectedCmd, &expectedStatus);
+
+    whole.len = 0;
+    lq_jsonStreamInit(&stream, tokenBuffer, sizeof(tokenBuffer), logEvent, &whole);
+    check(lq_jsonStreamFeed(&stream, command, docLen) == lqJsonResult_ok, "command streams");
+    for (uint16_t chunkSz = 1; chunkSz <= docLen; chunkSz++)
+    {
+        memset(&bound, 0, sizeof(bound));
+        chunked.len = 0;
+        lq_jsonStreamInit(&stream, tokenBuffer, sizeof(tokenBuffer), logEvent, &chunked);
+        lq_jsonStreamBind(&stream, commandBindings, COMMAND_BINDING_CNT, &bound);
+        lqJsonResult_t result = lqJsonResult_partial;
+        for (uint16_t pos = 0; pos < docLen; pos += chunkSz)
+        {
+            check(result == lqJsonResult_partial, "partial until complete");
+            result = lq_jsonStreamFeed(&stream, command + pos, (docLen - pos < chunkSz) ? docLen - pos : chunkSz);
+        }
+        if (result != lqJsonResult_ok || chunked.len != whole.len || memcmp(chunked.text, whole.text, whole.len) != 0 ||
+            memcmp(&bound, &expectedCmd, sizeof(bound)) != 0 || stream.status.present != expectedStatus.present || 
+            stream.status.mismatch != expectedStatus.mismatch)
+        {
+            printf("FAIL: chunk size %d: result=%d logLen=%d/%d bind=%d present=%x/%x mismatch=%x/%x\n", chunkSz, result, chunked.len, whole.len,
+                   memcmp(&bound, &expectedCmd, sizeof(bound)), stream.status.present, expectedStatus.present, stream.status.mismatch, expectedStatus.mismatch);
+            failures++;
+        }
+    }
+
+    char raw[96];                                                                       // document passes through a small ring
+    bbuffer_t rxBuffer;
+    bbffr_init(&rxBuffer, raw, sizeof(raw));
+    bbffr_skipHead(&rxBuffer, 50);
+    bbffr_skipTail(&rxBuffer, 50);
+    chunked.len = 0;
+    lq_jsonStreamInit(&stream, tokenBuffer, sizeof(tokenBuffer), logEvent, &chunked);
+    lqJsonResult_t result = lqJsonResult_partial;
+    for (uint16_t pushed = 0; result == lqJsonResult_partial; )
+    {
+        char *block;
+        pushed += bbffr_push(&rxBuffer, command + pushed, docLen - pushed);
+        bbffrSz_t blockSz;
+        while (result == lqJsonResult_partial && (blockSz = bbffr_popBlock(&rxBuffer, &block, 32)) > 0)
+        {
+            result = lq_jsonStreamFeed(&stream, block, blockSz);
+            bbffr_popBlockFinalize(&rxBuffer, true);
+        }
+    }
+    check(result == lqJsonResult_ok && chunked.len == whole.len && memcmp(chunked.text, whole.text, whole.len) == 0, "streamed from bbuffer");
+
+    check(lq_jsonStreamFeed(&stream, " \r\n", 3) == lqJsonResult_ok, "trailing whitespace");
+    check(lq_jsonStreamFeed(&stream, " x", 2) == lqJsonResult_invalid, "trailing data invalid");
+    check(lq_jsonStreamFeed(&stream, "{}", 2) == lqJsonResult_invalid, "errors are sticky");
+
+    const char *invalid[] = { "{\"a\" 1}", "{\"a\":1,}", "[1 2]", "{\"a\":tru}", "{\"a\":1}}", "{1:2}", "[1,]", "{\"a\":[1}", "[x]", "{\"a\":1]",
+                              "{\"a\":-}", "{\"a\":1-2}", "{\"a\":1e}", "{\"a\":--.}", "{\"a\":01}", "{\"a\":1.}" };
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+    {
+        lq_jsonStreamInit(&stream, tokenBuffer, sizeof(tokenBuffer), NULL, NULL);
+        lqJsonResult_t result = lqJsonResult_partial;
+        for (const char *c = invalid[i]; *c; c++)
+            result = lq_jsonStreamFeed(&stream, c, 1);
+        if (result != lqJsonResult_invalid)
+        {
+            printf("FAIL: streamed invalid %s (%d)\n", invalid[i], result);
+            failures++;
+        }
+    }
+
+    lq_jsonStreamInit(&stream, tokenBuffer, 32, NULL, NULL);                            // signature is 88 chars
+    check(lq_jsonStreamFeed(&stream, command, docLen) == lqJsonResult_noTokens, "token buffer overflow");
+    lq_jsonStreamInit(&stream, tokenBuffer, sizeof(tokenBuffer), NULL, NULL);
+    for (int i = 0; i <= LQJSON_STREAM_MAXDEPTH; i++)
+        result = lq_jsonStreamFeed(&stream, "[", 1);
+    check(result == lqJsonResult_noTokens, "nesting past max depth");
+}
+
+
+int main(int argc, char *argv[])
+{
+    uint32_t iterations = 200000;
+    uint16_t docLen = strlen(command);
+    lqJsonToken_t tokens[64];
+    lqJsonIndex_t index;
+
+    if (argc > 1)
+        iterations = strtoul(argv[1], NULL, 10);
+
+    checkIndex();
+    checkPaths();
+    checkBind();
+    checkStream();
+    if (failures)
+        return 1;
+
+    printf("method,props,docLen,nsPerDoc\n");
+    for (size_t propCnt = 1; propCnt <= PROP_CNT; propCnt = (propCnt < 4) ? propCnt * 2 : propCnt + 4)
+    {
+        double start = nowNs();
+        for (uint32_t n = 0; n < iterations; n++)
+        {
+            for (size_t i = 0; i < propCnt; i++)
+                sink += lq_getJsonPropValue(command, props[i]).len;
+        }
+        printf("scan,%d,%d,%.0f\n", (int)propCnt, docLen, (nowNs() - start) / iterations);
+
+        start = nowNs();
+        for (uint32_t n = 0; n < iterations; n++)
+        {
+            lq_jsonIndex(&index, command, docLen, tokens, 64);
+            for (size_t i = 0; i < propCnt; i++)
+                sink += lq_jsonGetPropValue(&index, LQJSON_ROOT, props[i]).len;
+        }
+        printf("index,%d,%d,%.0f\n", (int)propCnt, docLen, (nowNs() - start) / iterations);
+    }
+
+    const char *path = "params.notify.email";                                           // one deep value, no index
+    double start = nowNs();
+    for (uint32_t n = 0; n < iterations; n++)
+        sink += lq_jsonScanPathValue(command, docLen, path).len;
+    printf("scanPath,1,%d,%.0f\n", docLen, (nowNs() - start) / iterations);
+
+    start = nowNs();
+    for (uint32_t n = 0; n < iterations; n++)
+    {
+        lq_jsonIndex(&index, command, docLen, tokens, 64);
+        sink += lq_jsonGetPathValue(&index, LQJSON_ROOT, path).len;
+    }
+    printf("indexPath,1,%d,%.0f\n", docLen, (nowNs() - start) / iterations);
+
+    command_t cmd;                                                                      // 8 fields converted
+    lqJsonBindStatus_t status;
+    start = nowNs();
+    for (uint32_t n = 0; n < iterations; n++)
+    {
+        lqJsonPropValue_t value;
+        value = lq_getJsonPropValue(command, "deviceId");
+        memcpy(cmd.deviceId, value.value, value.len < sizeof(cmd.deviceId) ? value.len : sizeof(cmd.deviceId) - 1);
+        cmd.seq = strtoul(lq_getJsonPropValue(command, "seq").value, NULL, 10);
+        value = lq_getJsonPropValue(command, "action");
+        memcpy(cmd.action, value.value, value.len < sizeof(cmd.action) ? value.len : sizeof(cmd.action) - 1);
+        cmd.ttl = strtoul(lq_getJsonPropValue(command, "ttl").value, NULL, 10);
+        cmd.ack = *lq_getJsonPropValue(command, "ack").value == 't';
+        cmd.priority = strtod(lq_getJsonPropValue(command, "priority").value, NULL);
+        cmd.owner = lq_getJsonPropValue(command, "owner").type == lqcJsonPropType_int;
+        value = lq_getJsonPropValue(command, "signature");
+        memcpy(cmd.signature, value.value, sizeof(cmd.signature) - 1);
+        sink += cmd.seq;
+    }
+    printf("scanConvert,8,%d,%.0f\n", docLen, (nowNs() - start) / iterations);
+
+    start = nowNs();
+    for (uint32_t n = 0; n < iterations; n++)
+    {
+        lq_jsonBind(command, docLen, commandBindings, COMMAND_BINDING_CNT, &cmd, &status);
+        sink += cmd.seq;
+    }
+    printf("bind,8,%d,%.0f\n", docLen, (nowNs() - start) / iterations);
+
+    lqJsonStream_t stream;
+    char tokenBuffer[128];
+    start = nowNs();
+    for (uint32_t n = 0; n < iterations; n++)
+    {
+        lq_jsonStreamInit(&stream, tokenBuffer, sizeof(tokenBuffer), NULL, NULL);
+        lq_jsonStreamBind(&stream, commandBindings, COMMAND_BINDING_CNT, &cmd);
+        for (uint16_t pos = 0; pos < docLen; pos += 64)                                 // 64 char receive chunks
+            lq_jsonStreamFeed(&stream, command + pos, (docLen - pos < 64) ? docLen - pos : 64);
+        sink += cmd.seq;
+    }
+    printf("streamBind,8,%d,%.0f\n", docLen, (nowNs() - start) / iterations);
+    return 0;
+}
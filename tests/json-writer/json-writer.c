@@ -0,0 +1,379 @@
+/******************************************************************************
+ *  \file json-writer.c
+ *  \author Greg Terrell
+ *  \license MIT License
+ *
+ *  Copyright (c) 2022 LooUQ Incorporated.
+ *  www.loouq.com
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+ * "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+ * LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ ******************************************************************************
+ * Linux host check and benchmark for the JSON writer (lq-jsonWriter).
+ * 
+ * The check pass compares writer output with expected text for a telemetry
+ * document (nesting, escapes, integer and float edge values), re-indexes it
+ * with lq_jsonIndex(), streams it through a bbuffer whose head is placed to
+ * force a wrap, and confirms overflow, unbalanced and out of order (ex: close
+ * of the wrong container, value without key) documents report 0. The
+ * benchmark builds the telemetry document with the writer straight into a
+ * bbuffer vs snprintf() into a stack buffer plus bbffr_push(), results are
+ * CSV lines:
+ *   method,docLen,nsPerDoc
+ * 
+ * Build/run (from this folder):
+ *   gcc -O2 -DDISABLE_ASSERT -Wno-unknown-pragmas -I../../src json-writer.c ../../src/lq-jsonWriter.c ../../src/lq-json.c ../../src/lq-bBuffer.c -o json-writer
+ *   ./json-writer [iterations]
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "lq-jsonWriter.h"
+#include "lq-json.h"
+
+typedef struct telemetry_tag
+{
+    const char *deviceId;
+    uint32_t seq;
+    int32_t rssi;
+    double temperature;
+    double humidity;
+    bool door;
+    const char *note;
+    int32_t samples[6];
+} telemetry_t;
+
+static const telemetry_t telemetry = {
+    "864508030074113", 4000000000u, -97, 21.456, 48.0, true, "tab\there \"quoted\"\n", { 12, -3, 0, 1024, 77, 2147483647 }
+};
+
+static const char *expected = 
+    "{\"deviceId\":\"864508030074113\",\"seq\":4000000000,\"rssi\":-97,\"temp\":21.46,\"humidity\":48.0,\"door\":true,"
+    "\"note\":\"tab\\there \\\"quoted\\\"\\n\",\"samples\":[12,-3,0,1024,77,2147483647],\"gps\":null,\"meta\":{\"fw\":\"1.2.0\",\"empty\":[]}}";
+
+static volatile uint32_t sink;
+static int failures = 0;
+
+
+static double nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void check(int condition, const char *what)
+{
+    if (!condition)
+    {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+
+static uint32_t writeTelemetry(lqJsonWriter_t *writer, const telemetry_t *t)
+{
+    lq_jsonWriteObjectStart(writer);
+    lq_jsonWriteKey(writer, "deviceId");
+    lq_jsonWriteText(writer, t->deviceId);
+    lq_jsonWriteKey(writer, "seq");
+    lq_jsonWriteUint(writer, t->seq);
+    lq_jsonWriteKey(writer, "rssi");
+    lq_jsonWriteInt(writer, t->rssi);
+    lq_jsonWriteKey(writer, "temp");
+    lq_jsonWriteFloat(writer, t->temperature, 2);
+    lq_jsonWriteKey(writer, "humidity");
+    lq_jsonWriteFloat(writer, t->humidity, 1);
+    lq_jsonWriteKey(writer, "door");
+    lq_jsonWriteBool(writer, t->door);
+    lq_jsonWriteKey(writer, "note");
+    lq_jsonWriteText(writer, t->note);
+    lq_jsonWriteKey(writer, "samples");
+    lq_jsonWriteArrayStart(writer);
+    for (int i = 0; i < 6; i++)
+        lq_jsonWriteInt(writer, t->samples[i]);
+    lq_jsonWriteArrayEnd(writer);
+    lq_jsonWriteKey(writer, "gps");
+    lq_jsonWriteNull(writer);
+    lq_jsonWriteKey(writer, "meta");
+    lq_jsonWriteObjectStart(writer);
+    lq_jsonWriteKey(writer, "fw");
+    lq_jsonWriteRaw(writer, "\"1.2.0\"", 7);
+    lq_jsonWriteKey(writer, "empty");
+    lq_jsonWriteArrayStart(writer);
+    lq_jsonWriteArrayEnd(writer);
+    lq_jsonWriteObjectEnd(writer);
+    lq_jsonWriteObjectEnd(writer);
+    return lq_jsonWriterFinish(writer);
+}
+
+
+static int snprintfTelemetry(char *dest, size_t destSz, const telemetry_t *t)
+{
+    char samples[80];
+    int len = 0;
+    for (int i = 0; i < 6; i++)
+        len += snprintf(samples + len, sizeof(samples) - len, i ? ",%ld" : "%ld", (long)t->samples[i]);
+    return snprintf(dest, destSz, 
+                    "{\"deviceId\":\"%s\",\"seq\":%lu,\"rssi\":%ld,\"temp\":%.2f,\"humidity\":%.1f,\"door\":%s,"
+                    "\"note\":\"%s\",\"samples\":[%s],\"gps\":null,\"meta\":{\"fw\":\"1.2.0\",\"empty\":[]}}",
+                    t->deviceId, (unsigned long)t->seq, (long)t->rssi, t->temperature, t->humidity, t->door ? "true" : "false", 
+                    "tab\\there \\\"quoted\\\"\\n", samples);                           // escaping done by hand
+}
+
+
+static void checkText(const char *actual, const char *expect, const char *what)
+{
+    if (strcmp(actual, expect) != 0)
+    {
+        printf("FAIL: %s\n  got:    %s\n  expect: %s\n", what, actual, expect);
+        failures++;
+    }
+}
+
+
+static void checkNumbers()
+{
+    static const struct { double value; uint8_t decimals; const char *text; } floats[] = {
+        { 0.0, 2, "0.00" }, { -0.001, 2, "0.00" }, { -1.005, 1, "-1.0" }, { 0.5, 0, "1" }, { 123456.789, 3, "123456.789" },
+        { -2.5e-7, 9, "-0.000000250" }, { 1e19, 2, "10000000000000000000" }, { 3.0, 12, "3.000000000" }, { 1e300, 2, "null" }
+    };
+    char text[64];
+    lqJsonWriter_t writer;
+
+    for (size_t i = 0; i < sizeof(floats) / sizeof(floats[0]); i++)
+    {
+        lq_jsonWriterInit(&writer, text, sizeof(text));
+        lq_jsonWriteFloat(&writer, floats[i].value, floats[i].decimals);
+        check(lq_jsonWriterFinish(&writer) == strlen(floats[i].text), "float length");
+        checkText(text, floats[i].text, "float format");
+    }
+    double nan = 0.0;
+    lq_jsonWriterInit(&writer, text, sizeof(text));
+    lq_jsonWriteFloat(&writer, nan / nan, 2);
+    lq_jsonWriterFinish(&writer);
+    checkText(text, "null", "NaN is null");
+
+    lq_jsonWriterInit(&writer, text, sizeof(text));
+    lq_jsonWriteArrayStart(&writer);
+    lq_jsonWriteInt(&writer, INT32_MIN);
+    lq_jsonWriteInt(&writer, INT32_MAX);
+    lq_jsonWriteUint(&writer, UINT32_MAX);
+    lq_jsonWriteUint(&writer, 0);
+    lq_jsonWriteInt(&writer, -9);
+    lq_jsonWriteArrayEnd(&writer);
+    lq_jsonWriterFinish(&writer);
+    checkText(text, "[-2147483648,2147483647,4294967295,0,-9]", "integer limits");
+
+    lq_jsonWriterInit(&writer, text, sizeof(text));
+    lq_jsonWriteTextN(&writer, "\x01\x1f/\\\b\f\r\xc3\xa9\0x", 11);
+    lq_jsonWriterFinish(&writer);
+    checkText(text, "\"\\u0001\\u001f/\\\\\\b\\f\\r\xc3\xa9\\u0000x\"", "control chars escaped, UTF-8 passed");
+}
+
+
+static void checkDocument()
+{
+    char text[512];
+    lqJsonWriter_t writer;
+    uint32_t expectedLen = strlen(expected);
+
+    lq_jsonWriterInit(&writer, text, sizeof(text));
+    check(writeTelemetry(&writer, &telemetry) == expectedLen, "document length");
+    checkText(text, expected, "document text");
+
+    lqJsonToken_t tokens[64];
+    lqJsonIndex_t index;
+    check(lq_jsonIndex(&index, text, strlen(text), tokens, 64) == lqJsonResult_ok, "document re-indexes");
+    lqJsonPropValue_t note = lq_jsonGetPathValue(&index, LQJSON_ROOT, "note");
+    check(note.type == lqcJsonPropType_text && note.len == strlen("tab\\there \\\"quoted\\\"\\n"), "escaped text round trip");
+
+    for (uint16_t bufferSz = 0; bufferSz <= expectedLen + 1; bufferSz++)                // every truncation point
+    {
+        memset(text, '#', sizeof(text));
+        lq_jsonWriterInit(&writer, text, bufferSz);
+        uint32_t len = writeTelemetry(&writer, &telemetry);
+        bool fits = (bufferSz > expectedLen);
+        if ((len != 0) != fits || writer.overflow == fits || writer.written != expectedLen ||
+            (bufferSz > 0 && (strlen(text) != (fits ? expectedLen : bufferSz - 1u) || memcmp(text, expected, strlen(text)) != 0)) || 
+            text[bufferSz] != '#')
+        {
+            printf("FAIL: bounded buffer size %d\n", bufferSz);
+            failures++;
+        }
+    }
+
+    lq_jsonWriterInit(&writer, text, sizeof(text));
+    lq_jsonWriteObjectStart(&writer);
+    lq_jsonWriteKey(&writer, "open");
+    lq_jsonWriteArrayStart(&writer);
+    check(lq_jsonWriterFinish(&writer) == 0, "unbalanced document reports 0");
+    lq_jsonWriterInit(&writer, text, sizeof(text));
+    for (int i = 0; i <= LQJSON_WRITER_MAXDEPTH; i++)
+        lq_jsonWriteArrayStart(&writer);
+    check(writer.overflow, "nesting past max depth fails");
+}
+
+
+/* Write ops ({ } [ ] k=key v=value) in order, out of JSON order documents must finish as 0 */
+static void checkOrder()
+{
+    static const struct { const char *ops; bool valid; } cases[] = {
+        { "v", true }, { "{kv}", true }, { "[vv{}[]]", true }, { "{k[v]k{kv}}", true },
+        { "{}}", false }, { "{]", false }, { "[}", false }, { "}", false }, { "k", false }, { "[k", false }, { "{kk", false },
+        { "{kvv}", false }, { "{v}", false }, { "{k}", false }, { "vv", false }, { "{}{}", false }, { "[v]k", false }
+    };
+    char text[64];
+    lqJsonWriter_t writer;
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        lq_jsonWriterInit(&writer, text, sizeof(text));
+        for (const char *op = cases[i].ops; *op; op++)
+        {
+            switch (*op)
+            {
+                case '{': lq_jsonWriteObjectStart(&writer); break;
+                case '}': lq_jsonWriteObjectEnd(&writer); break;
+                case '[': lq_jsonWriteArrayStart(&writer); break;
+                case ']': lq_jsonWriteArrayEnd(&writer); break;
+                case 'k': lq_jsonWriteKey(&writer, "k"); break;
+                default: lq_jsonWriteInt(&writer, 1); break;
+            }
+        }
+        if ((lq_jsonWriterFinish(&writer) != 0) != cases[i].valid || writer.invalid == cases[i].valid)
+        {
+            printf("FAIL: write order %s %s\n", cases[i].ops, cases[i].valid ? "rejected" : "accepted");
+            failures++;
+        }
+    }
+}
+
+
+static void checkBbuffer()
+{
+    char raw[300];
+    char popped[600];
+    bbuffer_t bbffr;
+    lqJsonWriter_t writer;
+    uint32_t expectedLen = strlen(expected);
+
+    for (uint16_t start = 0; start < sizeof(raw); start += 7)                           // document wraps at every offset
+    {
+        bbffr_init(&bbffr, raw, sizeof(raw));
+        bbffr_skipHead(&bbffr, start);
+        bbffr_skipTail(&bbffr, start);
+        lq_jsonWriterInitBbffr(&writer, &bbffr);
+        uint32_t len = writeTelemetry(&writer, &telemetry);
+        uint16_t poppedLen = bbffr_pop(&bbffr, popped, sizeof(popped));
+        popped[poppedLen] = '\0';
+        if (len != expectedLen || poppedLen != expectedLen || strcmp(popped, expected) != 0)
+        {
+            printf("FAIL: bbuffer start %d: len=%d popped=%d\n", start, (int)len, poppedLen);
+            failures++;
+        }
+    }
+
+    for (uint16_t start = 0; start < 120; start += 13)                                  // too small, wrapped or not
+    {
+        bbffr_init(&bbffr, raw, 120);
+        bbffr_skipHead(&bbffr, start);
+        bbffr_skipTail(&bbffr, start);
+        lq_jsonWriterInitBbffr(&writer, &bbffr);
+        if (writeTelemetry(&writer, &telemetry) != 0 || !writer.overflow || bbffr_getOccupied(&bbffr) != 0)
+        {
+            printf("FAIL: bbuffer overflow start %d left %d chars\n", start, bbffr_getOccupied(&bbffr));
+            failures++;
+        }
+    }
+
+    bbffr_init(&bbffr, raw, sizeof(raw));                                               // incomplete, nothing published
+    lq_jsonWriterInitBbffr(&writer, &bbffr);
+    lq_jsonWriteArrayStart(&writer);
+    lq_jsonWriteInt(&writer, 1);
+    check(lq_jsonWriterFinish(&writer) == 0 && bbffr_getOccupied(&bbffr) == 0, "bbuffer unbalanced drops block");
+
+    bbffr_init(&bbffr, raw, sizeof(raw));
+    bbffr_push(&bbffr, "prefix|", 7);
+    lq_jsonWriterInitBbffr(&writer, &bbffr);
+    writeTelemetry(&writer, &telemetry);
+    bbffr_push(&bbffr, "|suffix", 7);
+    uint16_t poppedLen = bbffr_pop(&bbffr, popped, sizeof(popped));
+    check(poppedLen == expectedLen + 14 && memcmp(popped + 7, expected, expectedLen) == 0 && memcmp(popped + 7 + expectedLen, "|suffix", 7) == 0, 
+          "writer appends to existing stream");
+}
+
+
+int main(int argc, char *argv[])
+{
+    uint32_t iterations = 200000;
+    char raw[1024];
+    char scratch[512];
+    bbuffer_t bbffr;
+    lqJsonWriter_t writer;
+
+    if (argc > 1)
+        iterations = strtoul(argv[1], NULL, 10);
+
+    checkNumbers();
+    checkDocument();
+    checkOrder();
+    checkBbuffer();
+    if (failures)
+        return 1;
+
+    bbffr_init(&bbffr, raw, sizeof(raw));
+    int docLen = snprintfTelemetry(scratch, sizeof(scratch), &telemetry);
+    if (strcmp(scratch, expected) != 0)
+    {
+        printf("FAIL: snprintf reference differs\n");
+        return 1;
+    }
+
+    printf("method,docLen,nsPerDoc\n");
+    double start = nowNs();
+    for (uint32_t n = 0; n < iterations; n++)
+    {
+        int len = snprintfTelemetry(scratch, sizeof(scratch), &telemetry);
+        bbffr_push(&bbffr, scratch, len);
+        bbffr_skipTail(&bbffr, len);
+    }
+    printf("snprintf+push,%d,%.0f\n", docLen, (nowNs() - start) / iterations);
+
+    start = nowNs();
+    for (uint32_t n = 0; n < iterations; n++)
+    {
+        lq_jsonWriterInitBbffr(&writer, &bbffr);
+        sink += writeTelemetry(&writer, &telemetry);
+        bbffr_skipTail(&bbffr, docLen);
+    }
+    printf("writer-bbuffer,%d,%.0f\n", docLen, (nowNs() - start) / iterations);
+
+    start = nowNs();
+    for (uint32_t n = 0; n < iterations; n++)
+    {
+        lq_jsonWriterInit(&writer, scratch, sizeof(scratch));
+        sink += writeTelemetry(&writer, &telemetry);
+    }
+    printf("writer-array,%d,%.0f\n", docLen, (nowNs() - start) / iterations);
+    return 0;
+}